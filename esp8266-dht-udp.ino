@@ -11,16 +11,16 @@
 // required include files...
 #include "src/applib/esp8266-ino.h"
 #include "src/applib/sensor-dht.h"
-
-// disabled OTA due to unreliability in regards to
-// seeing the device on the Arduino IDE
-//#define USE_OTA
-#ifdef USE_OTA
+#include "src/applib/esp8266-cmd.h"
+#include "src/applib/esp8266-heap.h"
+#include "src/applib/sensor-diag.h"
+#include "src/applib/sensor-derived.h"
+#include "src/applib/esp8266-prof.h"
+#include "src/applib/esp8266-log.h"
+#include "src/applib/esp8266-logship.h"
+// USE_OTA is in esp8266-ota.h
 #include "src/applib/esp8266-ota.h"
 
-bool start = false;
-#endif
-
 #ifdef HEARTBEAT
 void startHeart();
 void heartBeat();
@@ -47,21 +47,35 @@ void setup()
 {
     // begin the set up process...
     setupStart();
-    // read and parse the necessary config files
+    // save the reset reason and start tracking the heap
+    initHeapStats();
+    // read and parse the necessary config files, the sensor
+    // is started before the WiFi connection is made
     setupConfig();
     // initialize prior to running the application
     setupInit();
     // initial setup is complete, wrap up and continue...
     setupDone();
+#ifdef LOG_BENCH
+    logBench();
+#endif
+#ifdef DHT_SIM_BENCH
+    dhtSimBench();
+#endif
+#ifdef DERIVED_BENCH
+    derivedBench();
+#endif
 #ifdef USE_OTA
-    // init for ota...
+    // init for ota, it runs alongside the application
     initOTA();
-#else
-    // announce that we're ready to any interested clients
-    ready();
-    // start up the sensor and begin reading data from it
-    startSensor();
 #endif
+    // announce that we're ready to any interested clients, the
+    // first sensor reading is sent when the loop starts
+    ready();
+    // listen for commands from the server
+    initCmd();
+    // ship the log to a collector if one is configured
+    initLogShip();
 #ifdef HEARTBEAT
     startHeart();
 #endif
@@ -81,19 +95,13 @@ String lasterr = "";
 
     yield();
 
-#ifdef USE_OTA
-    // wait until the OTA wait-time exprires, then
-    // run the rest of the app...
-    if(waitForOTA()) return;
-    else if(start == false)
-    {
-        start = true;
-        // announce that we're ready to any interested clients
-        ready();
-        // start up the sensor and begin reading data from it
-        startSensor();
-    }
-#endif
+    // move the virtual clock forward (SOAK_TEST only)
+    soakTick();
+
+    PROF_BEGIN(PROF_LOOP);
+
+    // track the minimum free heap, and watch for it getting low
+    updateHeapStats();
 
     // NOTE: using the LED toggle interval value to indicate 
     // an error comes from a prior iteration of this code. 
@@ -127,15 +135,35 @@ String lasterr = "";
 #ifdef HEARTBEAT
     // works best when sensor reporting 
     // mode is "CHG"
+    PROF_BEGIN(PROF_HEART);
     if(!datasent) heartBeat();
-    else lastbeat = millis();
+    else lastbeat = appMillis();
+    PROF_END(PROF_HEART);
 #endif
+    // check for and run any commands from the server
+    handleComm();
+
+#ifdef USE_OTA
+    // the lowest priority, check for an update while the
+    // OTA window is open. a transfer is received before
+    // handleOTA() returns, nothing else runs until then
+    PROF_BEGIN(PROF_OTA);
+    handleOTA();
+    PROF_END(PROF_OTA);
+#endif
+
+    PROF_END(PROF_LOOP);
+    // send the timing histograms if it's time
+    PROF_REPORT();
+
+    // the work is done, write out any pending log records
+    drainLog();
 }
 
 #ifdef HEARTBEAT
 void startHeart()
 {
-    lastbeat  = millis();
+    lastbeat  = appMillis();
     beatcount = 0;
     heartrate = getSensorInterval() * 4;
     Serial.println("heart started, beats @ "+String((float(heartrate/1000)/60))+" min");
@@ -146,9 +174,9 @@ void heartBeat()
 {
 sensornow tmp;
 
-    if((lastbeat + heartrate) < millis())
+    if(timeReached(appMillis(), lastbeat + heartrate))
     {
-        lastbeat = millis();
+        lastbeat = appMillis();
         beatcount += 1;
 
 // a "safety", have seen where the heart rate appears
@@ -163,6 +191,8 @@ sensornow tmp;
         }
         readSensorNow(tmp);
         sendSensorNow(tmp);
+        sendHeapStats();
+        sendSensorDiag();
     }
 }
 #endif
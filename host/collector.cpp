@@ -0,0 +1,741 @@
+/* ************************************************************************ */
+/*
+    collector.cpp - a collector for a large number of devices, the native
+    counterpart of src/applib/nodejs/collector-udp.js.
+
+    There's a lane for each core. A lane's receive thread has its own
+    socket on the data port (SO_REUSEPORT), the kernel spreads the devices
+    over the sockets by their address and port so a device's packets
+    always arrive at the same lane. It reads them in batches with
+    recvmmsg() straight into the slots of the lane's ring, and the lane's
+    parse thread takes them from the other end. The ring has one writer
+    and one reader, the head and the tail are all they share. Both of the
+    lane's threads are pinned to its core.
+
+    The parse threads read each message with the device's JSON parser
+    (ArduinoJson, see json/) and keep the latest reading of each device
+    and the number of reports lost (from "boot" and "rseq"). The status
+    thread receives the status messages on the multicast port, answers
+    REQ_IP and keeps the latest status of each device.
+
+    Messages are classified as in collector-udp.js - data, beat, stats,
+    status, prof, reply and bad (not valid JSON). The end of a
+    fleet-udp.js run is reported with the loss, like its sink does.
+
+    Usage -
+
+        host-collector [-p port] [-m port] [-g group] [-a ip] [-w lanes]
+                       [-q slots] [-t secs] [-v] [-B secs] [-s senders]
+                       [-n devices]
+
+            -p  the data port, "udp1" in clientcfg.json (default 54321)
+            -m  the status port, "port" in multicfg.json (default 54000)
+            -g  the multicast group, "addr" in multicfg.json (default
+                224.0.0.1). It isn't joined if it isn't multicast.
+            -a  the address in the reply to REQ_IP, the default is the
+                first IPv4 address that isn't loopback
+            -w  the number of lanes, 0 = one per core (default)
+            -q  slots in each lane's ring, a power of 2 (default 8192)
+            -t  seconds between throughput reports (default 5)
+            -v  display every message
+
+            -B  run the benchmark for this many seconds
+            -s  the benchmark's sending threads (default 2)
+            -n  devices for each sending thread (default 500)
+
+    The benchmark sends REQ_IP and waits for the reply, then the sending
+    threads send data and heartbeats to the data port as fast as they
+    can, each device from its own socket. When they're done it reports
+    the throughput, the loss and how the packets were spread over the
+    lanes. It exits with 1 if REQ_IP wasn't answered, nothing arrived or
+    a message couldn't be parsed. Run it with a different -w to compare.
+*/
+#include <errno.h>
+#include <ifaddrs.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <ArduinoJson.h>
+
+// packets read by each recvmmsg()
+#define RECV_BATCH      64
+// the largest packet kept, a device's are UDP_PAYLOAD_SIZE (150) bytes
+#define SLOT_SIZE       512
+#define RING_SLOTS      8192
+// bytes of each socket's receive buffer
+#define RECV_BUFFER     (4 * 1024 * 1024)
+// the receive threads look for a stop this often
+#define RECV_TIMEOUT_MS 200
+// an idle parse thread spins this many times before it sleeps
+#define PARSE_SPINS     1000
+#define PARSE_SLEEP_US  100
+
+// packets each benchmark device sends at a time, the last is a heartbeat
+#define BENCH_BATCH     4
+
+enum {
+    KIND_DATA,
+    KIND_BEAT,
+    KIND_STATS,
+    KIND_STATUS,
+    KIND_PROF,
+    KIND_REPLY,
+    KIND_BAD,
+    KIND_COUNT
+};
+
+static const char *kindNames[KIND_COUNT] = {"data", "beat", "stats", "status", "prof", "reply", "bad"};
+
+/* ************************************************************************ */
+/*
+    A ring of packets, the receive thread writes at the head and the parse
+    thread reads at the tail. They count up and wrap at 32 bits, the slot
+    is the count masked by the size.
+*/
+class slot {
+    public:
+        uint16_t len;
+        char data[SLOT_SIZE - 2];
+};
+
+class ring {
+    public:
+        slot *slots = NULL;
+        uint32_t mask = 0;
+        // the head and the tail are on cache lines of their own
+        char pad0[64];
+        std::atomic<uint32_t> head{0};
+        char pad1[64];
+        std::atomic<uint32_t> tail{0};
+        char pad2[64];
+};
+
+// the latest from a device
+class devrec {
+    public:
+        long seq = -1;
+        float t = 0;
+        float h = 0;
+        uint32_t boot = 0;
+        long rseq = -1;
+        std::string status;
+};
+
+/*
+    A lane, a socket with its receive thread, ring and parse thread. Each
+    counter is only written by one of the threads.
+*/
+class lane {
+    public:
+        int sock = -1;
+        int core = 0;
+        ring rx;
+        std::thread receiver;
+        std::thread parser;
+        // the receive thread's
+        std::atomic<uint64_t> received{0};
+        std::atomic<uint64_t> dropped{0};
+        char pad[64];
+        // the parse thread's
+        std::atomic<uint64_t> counts[KIND_COUNT];
+        std::atomic<uint64_t> lost{0};
+        std::atomic<uint64_t> devices{0};
+        std::unordered_map<std::string, devrec> table;
+
+        lane() { for(int ix = 0; ix < KIND_COUNT; ix++) counts[ix] = 0; }
+};
+
+static std::vector<lane *> lanes;
+// the status thread's
+static lane status;
+
+static std::atomic<bool> stopping(false);
+static bool verbose = false;
+static uint16_t dataPort = 54321;
+static uint16_t statusPort = 54000;
+static char replyIP[INET_ADDRSTRLEN] = "";
+static std::atomic<uint64_t> answered(0);
+// what had been received at the last fleet END
+static std::atomic<uint64_t> fleetBase(0);
+
+static void onStop(int sig)
+{
+    stopping = true;
+}
+
+static void pinThread(std::thread &th, int core)
+{
+cpu_set_t cpus;
+
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    pthread_setaffinity_np(th.native_handle(), sizeof(cpus), &cpus);
+}
+
+static int openSocket(uint16_t port, bool reuseport, int core)
+{
+int sock = socket(AF_INET, SOCK_DGRAM, 0);
+int on = 1;
+int size = RECV_BUFFER;
+struct timeval tv = {0, RECV_TIMEOUT_MS * 1000};
+struct sockaddr_in addr;
+
+    if(sock < 0) return -1;
+    setsockopt(sock, SOL_SOCKET, (reuseport ? SO_REUSEPORT : SO_REUSEADDR), &on, sizeof(on));
+    // more than rmem_max needs CAP_NET_ADMIN, the smaller one is used then
+    if(setsockopt(sock, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) < 0) setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    // the kernel prefers the socket of the core that took the packet
+    if(reuseport) setsockopt(sock, SOL_SOCKET, SO_INCOMING_CPU, &core, sizeof(core));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if(bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// the first IPv4 address that isn't loopback, like findIP() in collector-udp.js
+static void findIP(char *ip)
+{
+struct ifaddrs *list;
+
+    strcpy(ip, "127.0.0.1");
+    if(getifaddrs(&list) != 0) return;
+    for(struct ifaddrs *ifa = list; ifa != NULL; ifa = ifa->ifa_next)
+    {
+        if((ifa->ifa_addr == NULL) || (ifa->ifa_addr->sa_family != AF_INET)) continue;
+        struct in_addr in = ((struct sockaddr_in *)ifa->ifa_addr)->sin_addr;
+        if((ntohl(in.s_addr) >> 24) == 127) continue;
+        inet_ntop(AF_INET, &in, ip, INET_ADDRSTRLEN);
+        break;
+    }
+    freeifaddrs(list);
+}
+
+static uint64_t total(std::atomic<uint64_t> lane::*counter)
+{
+uint64_t sum = 0;
+
+    for(lane *ln : lanes) sum += (ln->*counter).load(std::memory_order_relaxed);
+    return sum;
+}
+
+static uint64_t totalKind(int kind, bool withStatus = true)
+{
+uint64_t sum = (withStatus ? status.counts[kind].load(std::memory_order_relaxed) : 0);
+
+    for(lane *ln : lanes) sum += ln->counts[kind].load(std::memory_order_relaxed);
+    return sum;
+}
+
+/* ************************************************************************ */
+/*
+    Messages
+*/
+static int classify(JsonObject &msg)
+{
+    if(!msg.success()) return KIND_BAD;
+    if(msg.containsKey("status")) return KIND_STATUS;
+    if(msg.containsKey("prof")) return KIND_PROF;
+    if(msg.containsKey("reply")) return KIND_REPLY;
+    if(msg.containsKey("last")) return KIND_BEAT;
+    if((msg["t"].size() > 0) && (msg["h"].size() > 0)) return KIND_STATS;
+    return KIND_DATA;
+}
+
+static devrec &record(lane *ln, const char *id)
+{
+auto found = ln->table.find(id);
+
+    if(found != ln->table.end()) return found->second;
+    ln->devices.store(ln->devices.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return ln->table[id];
+}
+
+static void count(std::atomic<uint64_t> &counter, uint64_t add = 1)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + add, std::memory_order_relaxed);
+}
+
+/*
+    The reports lost between this one and the last, a new "boot" starts
+    over
+*/
+static void checkGap(lane *ln, devrec &rec, JsonObject &msg)
+{
+uint32_t boot;
+long rseq;
+
+    if(!msg.containsKey("boot") || !msg.containsKey("rseq")) return;
+    boot = msg["boot"].as<uint32_t>();
+    rseq = msg["rseq"].as<long>();
+    if((boot == rec.boot) && (rseq > rec.rseq + 1) && (rec.rseq >= 0)) count(ln->lost, rseq - rec.rseq - 1);
+    if((boot != rec.boot) || (rseq > rec.rseq))
+    {
+        rec.boot = boot;
+        rec.rseq = rseq;
+    }
+}
+
+static void fleetEnd(JsonObject &msg)
+{
+uint64_t received = 0;
+uint64_t sent = msg["sent"].as<uint64_t>();
+int64_t lost;
+
+    for(int kind = 0; kind < KIND_COUNT; kind++) received += totalKind(kind, false);
+    received -= fleetBase.exchange(received);
+    lost = (int64_t)sent - (int64_t)received;
+    printf("fleet END - sent %llu, received %llu, lost %lld (%.2f%%) from %llu devices\n", (unsigned long long)sent,
+           (unsigned long long)received, (long long)lost, (lost * 100.0) / (sent > 0 ? sent : 1), (unsigned long long)total(&lane::devices));
+    fflush(stdout);
+}
+
+/*
+    The reply to REQ_IP, the format is in ParseIPReply.cpp. It's sent to
+    the port in "msg".
+*/
+static void answerReqIP(int sock, JsonObject &msg, struct sockaddr_in to)
+{
+char reply[128];
+const char *port = msg["msg"].as<const char *>();
+int len = snprintf(reply, sizeof(reply), "{\"reply\":\"IP_ADDR\",\"ip\":\"%s\",\"port\":%u}", replyIP, dataPort);
+
+    if((port != NULL) && (atoi(port) > 0)) to.sin_port = htons(atoi(port));
+    sendto(sock, reply, len, 0, (struct sockaddr *)&to, sizeof(to));
+    count(answered);
+}
+
+/*
+    A message from a device, `data` is NUL terminated and can be changed
+    by the parser. REQ_IP is answered when it's from `from`.
+*/
+static void handle(lane *ln, char *data, const struct sockaddr_in *from = NULL)
+{
+StaticJsonBuffer<1024> buffer;
+std::string text(verbose ? data : "");
+JsonObject &msg = buffer.parseObject(data);
+int kind = classify(msg);
+const char *id;
+
+    if(verbose) printf("%s - %s\n", kindNames[kind], text.c_str());
+    // the end of a fleet-udp.js run, it isn't from a device
+    if((kind == KIND_DATA) && msg.containsKey("fleet"))
+    {
+        fleetEnd(msg);
+        return;
+    }
+    count(ln->counts[kind]);
+
+    if((kind == KIND_BAD) || ((id = msg["dev_id"].as<const char *>()) == NULL)) return;
+
+    devrec &rec = record(ln, id);
+    switch(kind)
+    {
+        case KIND_DATA:
+        case KIND_BEAT:
+            // a report with only the other sensors' readings has no "t"
+            if(msg.containsKey("t"))
+            {
+                rec.seq = msg["seq"].as<long>();
+                rec.t = msg["t"].as<float>();
+                rec.h = msg["h"].as<float>();
+            }
+            // each of the other sensors is a device of its own, "ESP_49ECF6.1"
+            for(size_t ix = 0; ix < msg["p"].size(); ix++)
+            {
+                std::string other = std::string(id) + "." + std::to_string(msg["p"][ix][0].as<int>());
+                devrec &sensor = record(ln, other.c_str());
+                sensor.seq = msg["rseq"].as<long>();
+                sensor.t = msg["p"][ix][1].as<float>();
+                sensor.h = msg["p"][ix][2].as<float>();
+            }
+            checkGap(ln, rec, msg);
+            break;
+
+        case KIND_STATS:
+            // the mean stands in for the reading
+            rec.seq = msg["seq"].as<long>();
+            rec.t = msg["t"][2].as<float>();
+            rec.h = msg["h"][2].as<float>();
+            checkGap(ln, rec, msg);
+            break;
+
+        case KIND_STATUS:
+            rec.status = msg["status"].as<const char *>();
+            if((from != NULL) && (rec.status == "REQ_IP")) answerReqIP(ln->sock, msg, *from);
+            break;
+    }
+}
+
+/* ************************************************************************ */
+/*
+    Threads
+*/
+static void receiveLoop(lane *ln)
+{
+struct mmsghdr hdrs[RECV_BATCH];
+struct iovec iovs[RECV_BATCH];
+static thread_local char scratch[RECV_BATCH][SLOT_SIZE];
+ring &rx = ln->rx;
+uint32_t head = rx.head.load(std::memory_order_relaxed);
+
+    while(!stopping)
+    {
+        uint32_t room = (rx.mask + 1) - (head - rx.tail.load(std::memory_order_acquire));
+        int want = (room < RECV_BATCH ? room : RECV_BATCH);
+        // the ring is full, the packets are read and dropped
+        bool full = (want == 0);
+
+        if(full) want = RECV_BATCH;
+        for(int ix = 0; ix < want; ix++)
+        {
+            iovs[ix].iov_base = (full ? scratch[ix] : rx.slots[(head + ix) & rx.mask].data);
+            // room for a NUL
+            iovs[ix].iov_len = sizeof(slot::data) - 1;
+            memset(&hdrs[ix].msg_hdr, 0, sizeof(hdrs[ix].msg_hdr));
+            hdrs[ix].msg_hdr.msg_iov = &iovs[ix];
+            hdrs[ix].msg_hdr.msg_iovlen = 1;
+        }
+
+        int got = recvmmsg(ln->sock, hdrs, want, MSG_WAITFORONE, NULL);
+        if(got <= 0) continue;
+
+        count(ln->received, got);
+        if(full)
+        {
+            count(ln->dropped, got);
+            continue;
+        }
+        for(int ix = 0; ix < got; ix++) rx.slots[(head + ix) & rx.mask].len = (uint16_t)hdrs[ix].msg_len;
+        head += got;
+        rx.head.store(head, std::memory_order_release);
+    }
+}
+
+static void parseLoop(lane *ln)
+{
+ring &rx = ln->rx;
+uint32_t tail = rx.tail.load(std::memory_order_relaxed);
+int idle = 0;
+
+    while(!stopping || (tail != rx.head.load(std::memory_order_acquire)))
+    {
+        uint32_t head = rx.head.load(std::memory_order_acquire);
+
+        if(head == tail)
+        {
+            if(++idle < PARSE_SPINS) sched_yield();
+            else std::this_thread::sleep_for(std::chrono::microseconds(PARSE_SLEEP_US));
+            continue;
+        }
+        idle = 0;
+        for(; tail != head; tail++)
+        {
+            slot &s = rx.slots[tail & rx.mask];
+            uint16_t len = s.len;
+
+            // the device's payload might end with a NUL
+            while((len > 0) && (s.data[len - 1] == '\0')) len--;
+            s.data[len] = '\0';
+            handle(ln, s.data);
+            rx.tail.store(tail + 1, std::memory_order_release);
+        }
+    }
+}
+
+// the status messages, REQ_IP is answered
+static void statusLoop()
+{
+char buf[SLOT_SIZE];
+struct sockaddr_in from;
+socklen_t fromlen;
+
+    while(!stopping)
+    {
+        fromlen = sizeof(from);
+        ssize_t len = recvfrom(status.sock, buf, sizeof(buf) - 1, 0, (struct sockaddr *)&from, &fromlen);
+        if(len <= 0) continue;
+        while((len > 0) && (buf[len - 1] == '\0')) len--;
+        buf[len] = '\0';
+        count(status.received);
+
+        handle(&status, buf, &from);
+    }
+}
+
+/* ************************************************************************ */
+/*
+    Benchmark - the load generator
+*/
+static uint32_t benchDevices = 500;
+static int benchSenders = 2;
+static std::atomic<uint64_t> benchSent(0);
+
+static void benchSender(int sender, unsigned long secs)
+{
+std::vector<int> socks;
+struct sockaddr_in to;
+struct mmsghdr hdrs[BENCH_BATCH];
+struct iovec iovs[BENCH_BATCH];
+char pkts[BENCH_BATCH][SLOT_SIZE];
+unsigned long rseq = 0;
+uint64_t sent = 0;
+auto end = std::chrono::steady_clock::now() + std::chrono::seconds(secs);
+
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    to.sin_port = htons(dataPort);
+
+    // each device has its own port, so they're spread over the lanes
+    for(uint32_t ix = 0; ix < benchDevices; ix++)
+    {
+        int sock = socket(AF_INET, SOCK_DGRAM, 0);
+        if((sock < 0) || (connect(sock, (struct sockaddr *)&to, sizeof(to)) < 0))
+        {
+            fprintf(stderr, "sender %d - only %u devices, %s\n", sender, ix, strerror(errno));
+            if(sock >= 0) close(sock);
+            break;
+        }
+        socks.push_back(sock);
+    }
+
+    memset(hdrs, 0, sizeof(hdrs));
+    while((std::chrono::steady_clock::now() < end) && !socks.empty())
+    {
+        // every device sends the same rseq in a pass, a new one each pass
+        for(size_t dev = 0; dev < socks.size(); dev++)
+        {
+            for(int ix = 0; ix < BENCH_BATCH; ix++)
+            {
+                unsigned long seq = (rseq * BENCH_BATCH) + ix;
+                iovs[ix].iov_base = pkts[ix];
+                iovs[ix].iov_len = snprintf(pkts[ix], sizeof(pkts[ix]),
+                                            "{\"dev_id\":\"ESP_%02X%04X\",\"seq\":%lu,\"boot\":1,\"rseq\":%lu,\"t\":71.5,\"h\":37.4%s}",
+                                            sender, (unsigned)dev, seq, seq,
+                                            (ix == BENCH_BATCH - 1 ? ",\"last\":{\"t\":71.4,\"h\":37.5}" : ""));
+                hdrs[ix].msg_hdr.msg_iov = &iovs[ix];
+                hdrs[ix].msg_hdr.msg_iovlen = 1;
+            }
+            int done = sendmmsg(socks[dev], hdrs, BENCH_BATCH, 0);
+            if(done > 0) sent += done;
+        }
+        rseq += 1;
+    }
+    for(int sock : socks) close(sock);
+    benchSent += sent;
+}
+
+// send REQ_IP from a socket of our own and wait for the reply
+static bool benchReqIP()
+{
+int sock = socket(AF_INET, SOCK_DGRAM, 0);
+struct sockaddr_in addr;
+socklen_t addrlen = sizeof(addr);
+struct timeval tv = {1, 0};
+char buf[SLOT_SIZE];
+bool ok = false;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(sock, (struct sockaddr *)&addr, sizeof(addr));
+    getsockname(sock, (struct sockaddr *)&addr, &addrlen);
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    int len = snprintf(buf, sizeof(buf), "{\"dev_id\":\"ESP_BENCH\",\"status\":\"REQ_IP\",\"msg\":\"%u\"}", ntohs(addr.sin_port));
+    addr.sin_port = htons(statusPort);
+    sendto(sock, buf, len, 0, (struct sockaddr *)&addr, sizeof(addr));
+
+    len = recv(sock, buf, sizeof(buf) - 1, 0);
+    if(len > 0)
+    {
+        buf[len] = '\0';
+        ok = (strstr(buf, "\"IP_ADDR\"") != NULL);
+        printf("REQ_IP - %s\n", buf);
+    }
+    close(sock);
+    return ok;
+}
+
+static int runBench(unsigned long secs)
+{
+struct rlimit files;
+std::vector<std::thread> senders;
+bool replied;
+
+    // a socket for each device
+    getrlimit(RLIMIT_NOFILE, &files);
+    files.rlim_cur = files.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &files);
+
+    replied = benchReqIP();
+
+    auto start = std::chrono::steady_clock::now();
+    for(int ix = 0; ix < benchSenders; ix++) senders.push_back(std::thread(benchSender, ix, secs));
+    for(std::thread &th : senders) th.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // let the parse threads catch up
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    uint64_t sent = benchSent;
+    uint64_t parsed = 0;
+    for(int kind = 0; kind < KIND_COUNT; kind++) parsed += totalKind(kind, false);
+    uint64_t received = total(&lane::received);
+    uint64_t dropped = total(&lane::dropped);
+    uint64_t lost = sent - (parsed < sent ? parsed : sent);
+
+    printf("sent %llu in %.1fs (%.0f pkt/s) from %d x %u devices\n", (unsigned long long)sent, elapsed, sent / elapsed, benchSenders, benchDevices);
+    printf("parsed %llu (%.0f pkt/s) from %llu devices, dropped %llu in the rings, lost %llu (%.2f%%), %llu missing from rseq\n",
+           (unsigned long long)parsed, parsed / elapsed, (unsigned long long)total(&lane::devices), (unsigned long long)dropped,
+           (unsigned long long)lost, (lost * 100.0) / (sent > 0 ? sent : 1), (unsigned long long)total(&lane::lost));
+    printf("data %llu  beat %llu  bad %llu\n", (unsigned long long)totalKind(KIND_DATA), (unsigned long long)totalKind(KIND_BEAT),
+           (unsigned long long)totalKind(KIND_BAD));
+    printf("received by each lane -");
+    for(lane *ln : lanes) printf(" %llu", (unsigned long long)ln->received.load());
+    printf(" (%llu)\n", (unsigned long long)received);
+
+    return ((replied && (parsed > 0) && (totalKind(KIND_BAD) == 0)) ? 0 : 1);
+}
+
+/* ************************************************************************ */
+int main(int argc, char *argv[])
+{
+int opt;
+int nlanes = 0;
+uint32_t slots = RING_SLOTS;
+int report = 5;
+unsigned long bench = 0;
+const char *group = "224.0.0.1";
+int cores = (int)std::thread::hardware_concurrency();
+int result = 0;
+
+    while((opt = getopt(argc, argv, "p:m:g:a:w:q:t:vB:s:n:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'p': dataPort = (uint16_t)atoi(optarg); break;
+            case 'm': statusPort = (uint16_t)atoi(optarg); break;
+            case 'g': group = optarg; break;
+            case 'a': snprintf(replyIP, sizeof(replyIP), "%s", optarg); break;
+            case 'w': nlanes = atoi(optarg); break;
+            case 'q': slots = (uint32_t)atol(optarg); break;
+            case 't': report = (atoi(optarg) > 0 ? atoi(optarg) : 1); break;
+            case 'v': verbose = true; break;
+            case 'B': bench = atol(optarg); break;
+            case 's': benchSenders = (atoi(optarg) > 0 ? atoi(optarg) : 1); break;
+            case 'n': benchDevices = (atoi(optarg) > 0 ? atoi(optarg) : 1); break;
+            default:
+                fprintf(stderr, "usage: %s [-p port] [-m port] [-g group] [-a ip] [-w lanes] [-q slots] [-t secs] [-v] [-B secs] [-s senders] [-n devices]\n", argv[0]);
+                return 1;
+        }
+    }
+    if(cores < 1) cores = 1;
+    if(nlanes <= 0) nlanes = cores;
+    if((slots < RECV_BATCH) || ((slots & (slots - 1)) != 0))
+    {
+        fprintf(stderr, "%s: -q must be a power of 2 and at least %d\n", argv[0], RECV_BATCH);
+        return 1;
+    }
+    if(replyIP[0] == '\0') findIP(replyIP);
+
+    signal(SIGINT, onStop);
+    signal(SIGTERM, onStop);
+
+    for(int ix = 0; ix < nlanes; ix++)
+    {
+        lane *ln = new lane;
+        ln->core = ix % cores;
+        ln->sock = openSocket(dataPort, true, ln->core);
+        if(ln->sock < 0)
+        {
+            fprintf(stderr, "%s: can't bind port %u - %s\n", argv[0], dataPort, strerror(errno));
+            return 1;
+        }
+        ln->rx.slots = new slot[slots];
+        ln->rx.mask = slots - 1;
+        lanes.push_back(ln);
+    }
+
+    status.sock = openSocket(statusPort, false, 0);
+    if(status.sock < 0)
+    {
+        fprintf(stderr, "%s: can't bind port %u - %s\n", argv[0], statusPort, strerror(errno));
+        return 1;
+    }
+    struct ip_mreq mreq;
+    if((inet_pton(AF_INET, group, &mreq.imr_multiaddr) == 1) && IN_MULTICAST(ntohl(mreq.imr_multiaddr.s_addr)))
+    {
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+        if(setsockopt(status.sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
+            fprintf(stderr, "can't join %s - %s\n", group, strerror(errno));
+    }
+
+    for(lane *ln : lanes)
+    {
+        ln->receiver = std::thread(receiveLoop, ln);
+        ln->parser = std::thread(parseLoop, ln);
+        pinThread(ln->receiver, ln->core);
+        pinThread(ln->parser, ln->core);
+    }
+    std::thread statusThread(statusLoop);
+
+    printf("collector listening on port %u with %d lanes, REQ_IP on port %u replies with %s\n", dataPort, nlanes, statusPort, replyIP);
+    fflush(stdout);
+
+    if(bench > 0) result = runBench(bench);
+    else
+    {
+        uint64_t last = 0;
+        auto next = std::chrono::steady_clock::now() + std::chrono::seconds(report);
+
+        while(!stopping)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if(std::chrono::steady_clock::now() < next) continue;
+            next += std::chrono::seconds(report);
+
+            uint64_t all = 0;
+            for(int kind = 0; kind < KIND_COUNT; kind++) all += totalKind(kind);
+            printf("%llu pkt/s -", (unsigned long long)((all - last) / report));
+            for(int kind = 0; kind < KIND_COUNT; kind++) printf(" %s %llu ", kindNames[kind], (unsigned long long)totalKind(kind));
+            printf(" dropped %llu  lost %llu  devices %llu  REQ_IP %llu\n", (unsigned long long)total(&lane::dropped),
+                   (unsigned long long)total(&lane::lost), (unsigned long long)total(&lane::devices), (unsigned long long)answered.load());
+            fflush(stdout);
+            last = all;
+        }
+    }
+
+    stopping = true;
+    for(lane *ln : lanes)
+    {
+        ln->receiver.join();
+        ln->parser.join();
+    }
+    statusThread.join();
+    return result;
+}
@@ -0,0 +1,286 @@
+/* ************************************************************************ */
+/*
+    device.cpp - runs the sketch on the host. setup() is called once and
+    then loop() until the process is stopped, the simulated sensor drifts
+    slowly while it runs.
+
+    One process can run many devices (-d). The sketch keeps its state in
+    globals, so each device has its own copy of the program's data and
+    bss (its image) and runs on its own stack. When a device calls
+    delay() it gives up the processor, its image is saved and the next
+    device that is due is switched in. It's all one thread, a device
+    runs until it calls delay() like it would on an ESP8266.
+
+    Usage -
+
+        host-device [-f dir] [-i ip] [-n hostname] [-b percent] [-c port]
+                    [-d count] [-l ms] [-r ms]
+
+            -f  the directory that holds the config files, the default
+                is the sketch's data directory
+            -i  the device's address, any 127.x.y.z (default 127.0.0.1).
+                With -d it's the first device's, the others follow it.
+            -n  the hostname, it's the device ID (default ESP_HOST). With
+                -d it's followed by the low 3 bytes of the address in
+                hex, like a device's ID is followed by its MAC's.
+            -b  percent of sensor reads with a bad checksum
+            -c  the collector port, the number of packets sent to it is
+                printed when the process stops
+            -d  the number of devices (default 1)
+            -l  milliseconds between passes through loop() (default 10)
+            -r  milliseconds over which the devices are started
+
+    When setup() is done each device prints {"dev_id":"...","discover":N},
+    N is the milliseconds from its start to the server's reply to REQ_IP.
+    On SIGINT or SIGTERM each one prints
+    {"dev_id":"...","sent":N,"failed":N} and the process exits.
+*/
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "../esp8266-dht-udp.ino"
+
+// milliseconds between passes through loop()
+#define HOST_LOOP_MS    10
+// milliseconds between changes to the simulated reading
+#define HOST_DRIFT_MS   5000
+// each device's stack, its pages are only used as it grows
+#define HOST_STACK_SIZE (256 * 1024)
+
+// the program's data and bss, from the linker
+extern char __data_start[];
+extern char _end[];
+
+/*
+    A device, they're on the heap so that they aren't in the images
+*/
+class hostdev {
+    public:
+        ucontext_t ctx;
+        char *stack;
+        char *image;
+        char name[32];
+        char ip[INET_ADDRSTRLEN];
+        // when it's due to run again
+        unsigned long wake;
+        unsigned long seed;
+};
+
+class hostfleet {
+    public:
+        ucontext_t sched;
+        std::vector<hostdev *> devs;
+        hostdev *current = NULL;
+        unsigned long loopms = HOST_LOOP_MS;
+        uint8_t badsum = 0;
+        uint16_t collector = 0;
+        volatile sig_atomic_t stopping = 0;
+};
+
+// set before the images are made, it's the same in all of them
+static hostfleet *fleet = NULL;
+
+static void imageSave(hostdev *dev)
+{
+    memcpy(dev->image, __data_start, _end - __data_start);
+}
+
+static void imageLoad(hostdev *dev)
+{
+    memcpy(__data_start, dev->image, _end - __data_start);
+}
+
+/*
+    A line for fleet-udp.js, it's written directly so that it isn't
+    mixed up with what Serial has buffered
+*/
+static void printLine(const char *fmt, ...)
+{
+char line[128];
+va_list args;
+
+    va_start(args, fmt);
+    int len = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+
+    fflush(stdout);
+    write(STDOUT_FILENO, line, min(len, (int)sizeof(line) - 1));
+}
+
+static void onStop(int sig)
+{
+    fleet->stopping = 1;
+}
+
+/*
+    delay() in a device, the others run until it's due again
+*/
+static void deviceDelay(unsigned long ms)
+{
+hostdev *dev = fleet->current;
+
+    dev->wake = millis() + ms;
+    swapcontext(&dev->ctx, &fleet->sched);
+}
+
+/*
+    A device, the sketch with its own simulated sensor
+*/
+static void deviceMain()
+{
+hostdev *dev = fleet->current;
+dhtsimcfg simcfg;
+std::minstd_rand rng(dev->seed);
+int16_t t10 = 215;
+int16_t h10 = 450;
+unsigned long started;
+unsigned long drifted;
+
+    hostSetIP(dev->ip);
+    hostSetHostname(dev->name);
+    simcfg.badsum = fleet->badsum;
+    dhtSimConfig(simcfg);
+    dhtSimSet(t10, h10);
+
+    // it doesn't return until the server answers REQ_IP
+    started = millis();
+    setup();
+    printLine("{\"dev_id\":\"%s\",\"discover\":%lu}\n", dev->name, timeSince(millis(), started));
+
+    drifted = millis();
+    while(true)
+    {
+        loop();
+
+        if(timeSince(millis(), drifted) >= HOST_DRIFT_MS)
+        {
+            drifted = millis();
+            t10 = constrain(t10 + (int16_t)(rng() % 7) - 3, -100, 450);
+            h10 = constrain(h10 + (int16_t)(rng() % 11) - 5, 50, 950);
+            dhtSimSet(t10, h10);
+        }
+        delay(fleet->loopms);
+    }
+}
+
+/*
+    Run the device until it calls delay()
+*/
+static void deviceRun(hostdev *dev)
+{
+    fleet->current = dev;
+    imageLoad(dev);
+    swapcontext(&fleet->sched, &dev->ctx);
+    imageSave(dev);
+}
+
+static hostdev *deviceNew(uint32_t addr, const char *name, bool suffix, unsigned long wake, const char *pristine)
+{
+hostdev *dev = new hostdev;
+struct in_addr in;
+
+    in.s_addr = htonl(addr);
+    inet_ntop(AF_INET, &in, dev->ip, sizeof(dev->ip));
+    if(suffix) snprintf(dev->name, sizeof(dev->name), "%s%06X", name, addr & 0xFFFFFF);
+    else snprintf(dev->name, sizeof(dev->name), "%s", name);
+    dev->wake = wake;
+    dev->seed = addr;
+
+    dev->image = new char[_end - __data_start];
+    memcpy(dev->image, pristine, _end - __data_start);
+    dev->stack = (char *)malloc(HOST_STACK_SIZE);
+
+    getcontext(&dev->ctx);
+    dev->ctx.uc_stack.ss_sp = dev->stack;
+    dev->ctx.uc_stack.ss_size = HOST_STACK_SIZE;
+    dev->ctx.uc_link = &fleet->sched;
+    makecontext(&dev->ctx, deviceMain, 0);
+    return dev;
+}
+
+int main(int argc, char *argv[])
+{
+int opt;
+const char *ip = "127.0.0.1";
+const char *name = "ESP_HOST";
+int count = 1;
+unsigned long ramp = 0;
+struct in_addr first;
+
+    fleet = new hostfleet;
+
+    while((opt = getopt(argc, argv, "f:i:n:b:c:d:l:r:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'f': hostSetFSRoot(optarg); break;
+            case 'i': ip = optarg; break;
+            case 'n': name = optarg; break;
+            case 'b': fleet->badsum = (uint8_t)atoi(optarg); break;
+            case 'c': fleet->collector = (uint16_t)atoi(optarg); break;
+            case 'd': count = max(atoi(optarg), 1); break;
+            case 'l': fleet->loopms = max(atol(optarg), 1L); break;
+            case 'r': ramp = atol(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-f dir] [-i ip] [-n hostname] [-b percent] [-c port] [-d count] [-l ms] [-r ms]\n", argv[0]);
+                return 1;
+        }
+    }
+    if(inet_pton(AF_INET, ip, &first) != 1)
+    {
+        fprintf(stderr, "%s: bad address %s\n", argv[0], ip);
+        return 1;
+    }
+
+    signal(SIGINT, onStop);
+    signal(SIGTERM, onStop);
+    hostSetDelayHook(deviceDelay);
+
+    // the devices start from the program's data as it is now
+    std::vector<char> pristine(__data_start, _end);
+    unsigned long now = millis();
+
+    for(int ix = 0; ix < count; ix++)
+    {
+        fleet->devs.push_back(deviceNew(ntohl(first.s_addr) + ix, name, (count > 1), now + ((ramp * ix) / count), pristine.data()));
+    }
+
+    while(!fleet->stopping)
+    {
+        // run the ones that are due, and wait for the next one
+        now = millis();
+        unsigned long next = now + fleet->loopms;
+
+        for(hostdev *dev : fleet->devs)
+        {
+            if(timeReached(now, dev->wake))
+            {
+                deviceRun(dev);
+                now = millis();
+            }
+            if(!timeReached(dev->wake, next)) next = dev->wake;
+        }
+        long wait = (int32_t)(uint32_t)(next - millis());
+        if(wait > 0) std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+    }
+
+    Serial.flush();
+    for(hostdev *dev : fleet->devs)
+    {
+        imageLoad(dev);
+        printLine("{\"dev_id\":\"%s\",\"sent\":%lu,\"failed\":%lu}\n", dev->name, hostUDPSent(fleet->collector), hostUDPFailed());
+    }
+    // the destructors would only see the last device's image
+    _exit(0);
+}
@@ -0,0 +1,231 @@
+/* ************************************************************************ */
+/*
+    ArduinoJson.cpp - host stand-in for the ArduinoJson 5 parser, see
+    ArduinoJson.h
+*/
+#include <string.h>
+
+#include "ArduinoJson.h"
+
+/* ************************************************************************ */
+/*
+    JsonVariant
+*/
+JsonVariant JsonVariant::operator[](const char *key) const
+{
+    if(_node && (_node->type == JsonNode::OBJECT) && (key != NULL))
+    {
+        for(auto &member : _node->members)
+        {
+            if(member.first == key) return JsonVariant(member.second);
+        }
+    }
+    return JsonVariant();
+}
+
+JsonVariant JsonVariant::operator[](int index) const
+{
+    if(_node && (_node->type == JsonNode::ARRAY) && (index >= 0) && (index < (int)_node->elements.size()))
+        return JsonVariant(_node->elements[index]);
+    return JsonVariant();
+}
+
+size_t JsonVariant::size() const
+{
+    if(_node == nullptr) return 0;
+    if(_node->type == JsonNode::ARRAY) return _node->elements.size();
+    if(_node->type == JsonNode::OBJECT) return _node->members.size();
+    return 0;
+}
+
+const char *JsonVariant::asValue(const char **) const
+{
+    if(_node && (_node->type == JsonNode::STRING)) return _node->str.c_str();
+    return NULL;
+}
+
+bool JsonVariant::asValue(bool *) const
+{
+    if(_node == nullptr) return false;
+    if(_node->type == JsonNode::BOOLEAN) return _node->boolean;
+    return asInteger() != 0;
+}
+
+long long JsonVariant::asInteger() const
+{
+    if(_node == nullptr) return 0;
+    switch(_node->type)
+    {
+        case JsonNode::BOOLEAN:
+            return (_node->boolean ? 1 : 0);
+        case JsonNode::INTEGER:
+            return _node->integer;
+        case JsonNode::FLOAT:
+            return (long long)_node->real;
+        case JsonNode::STRING:
+            return strtoll(_node->str.c_str(), NULL, 10);
+        default:
+            return 0;
+    }
+}
+
+double JsonVariant::asReal() const
+{
+    if(_node == nullptr) return 0.0;
+    if(_node->type == JsonNode::FLOAT) return _node->real;
+    if(_node->type == JsonNode::STRING) return strtod(_node->str.c_str(), NULL);
+    return (double)asInteger();
+}
+
+/* ************************************************************************ */
+/*
+    JsonBuffer, a recursive descent parser. A failed parse returns an
+    object where success() is false, as the library does.
+*/
+static void skipSpace(const char *&p)
+{
+    while((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n')) p++;
+}
+
+JsonNode *JsonBuffer::newNode(JsonNode::Type type)
+{
+    _nodes.emplace_back();
+    _nodes.back().type = type;
+    return &_nodes.back();
+}
+
+JsonObject &JsonBuffer::parseObject(const char *json)
+{
+const JsonNode *node = nullptr;
+
+    if(json != NULL)
+    {
+        const char *p = json;
+        skipSpace(p);
+        if(*p == '{') node = parseValue(p);
+    }
+    _root = JsonObject(node);
+    return _root;
+}
+
+const JsonNode *JsonBuffer::parseValue(const char *&p)
+{
+    skipSpace(p);
+    switch(*p)
+    {
+        case '{':
+        {
+            JsonNode *obj = newNode(JsonNode::OBJECT);
+            p++;
+            skipSpace(p);
+            if(*p == '}') { p++; return obj; }
+            while(true)
+            {
+                skipSpace(p);
+                const JsonNode *key = parseString(p);
+                if(key == nullptr) return nullptr;
+                skipSpace(p);
+                if(*p++ != ':') return nullptr;
+                const JsonNode *value = parseValue(p);
+                if(value == nullptr) return nullptr;
+                obj->members.push_back(std::make_pair(key->str, value));
+                skipSpace(p);
+                if(*p == ',') { p++; continue; }
+                if(*p == '}') { p++; return obj; }
+                return nullptr;
+            }
+        }
+        case '[':
+        {
+            JsonNode *arr = newNode(JsonNode::ARRAY);
+            p++;
+            skipSpace(p);
+            if(*p == ']') { p++; return arr; }
+            while(true)
+            {
+                const JsonNode *value = parseValue(p);
+                if(value == nullptr) return nullptr;
+                arr->elements.push_back(value);
+                skipSpace(p);
+                if(*p == ',') { p++; continue; }
+                if(*p == ']') { p++; return arr; }
+                return nullptr;
+            }
+        }
+        case '"':
+        case '\'':
+            return parseString(p);
+        case 't':
+            if(parseLiteral(p, "true")) { JsonNode *n = newNode(JsonNode::BOOLEAN); n->boolean = true; return n; }
+            return nullptr;
+        case 'f':
+            if(parseLiteral(p, "false")) return newNode(JsonNode::BOOLEAN);
+            return nullptr;
+        case 'n':
+            if(parseLiteral(p, "null")) return newNode(JsonNode::NUL);
+            return nullptr;
+        default:
+            return parseNumber(p);
+    }
+}
+
+const JsonNode *JsonBuffer::parseString(const char *&p)
+{
+char quote = *p;
+
+    if((quote != '"') && (quote != '\'')) return nullptr;
+    p++;
+
+    JsonNode *n = newNode(JsonNode::STRING);
+    while(*p != quote)
+    {
+        if(*p == '\0') return nullptr;
+        if(*p == '\\')
+        {
+            p++;
+            switch(*p)
+            {
+                case 'n': n->str += '\n'; break;
+                case 'r': n->str += '\r'; break;
+                case 't': n->str += '\t'; break;
+                case 'b': n->str += '\b'; break;
+                case 'f': n->str += '\f'; break;
+                case '\0': return nullptr;
+                default: n->str += *p; break;
+            }
+            p++;
+        } else n->str += *p++;
+    }
+    p++;
+    return n;
+}
+
+const JsonNode *JsonBuffer::parseNumber(const char *&p)
+{
+const char *start = p;
+bool real = false;
+
+    if((*p == '-') || (*p == '+')) p++;
+    if((*p < '0') || (*p > '9')) return nullptr;
+    while(((*p >= '0') && (*p <= '9')) || (*p == '.') || (*p == 'e') || (*p == 'E') ||
+          (((*p == '-') || (*p == '+')) && ((p[-1] == 'e') || (p[-1] == 'E'))))
+    {
+        if((*p == '.') || (*p == 'e') || (*p == 'E')) real = true;
+        p++;
+    }
+
+    std::string text(start, p - start);
+    JsonNode *n = newNode(real ? JsonNode::FLOAT : JsonNode::INTEGER);
+    if(real) n->real = strtod(text.c_str(), NULL);
+    else n->integer = strtoll(text.c_str(), NULL, 10);
+    return n;
+}
+
+bool JsonBuffer::parseLiteral(const char *&p, const char *word)
+{
+size_t len = strlen(word);
+
+    if(strncmp(p, word, len) != 0) return false;
+    p += len;
+    return true;
+}
@@ -0,0 +1,99 @@
+/* ************************************************************************ */
+/*
+    ArduinoJson.h - host stand-in for the part of ArduinoJson 5 that the
+    application uses, which is parsing an object and reading its values.
+
+    The buffer size isn't enforced, the size macros are only there so that
+    the code compiles. Build with HOST_FETCH_ARDUINOJSON to use the real
+    library instead (see host/CMakeLists.txt).
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <deque>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define JSON_OBJECT_SIZE(n) (8 + (n) * 16)
+#define JSON_ARRAY_SIZE(n)  (8 + (n) * 12)
+
+struct JsonNode {
+    enum Type { UNDEFINED, NUL, BOOLEAN, INTEGER, FLOAT, STRING, ARRAY, OBJECT };
+
+    Type type = UNDEFINED;
+    bool boolean = false;
+    long long integer = 0;
+    double real = 0.0;
+    std::string str;
+    std::vector<std::pair<std::string, const JsonNode *>> members;
+    std::vector<const JsonNode *> elements;
+};
+
+class JsonVariant {
+    public:
+        JsonVariant(const JsonNode *node = nullptr) : _node(node) {}
+
+        JsonVariant operator[](const char *key) const;
+        JsonVariant operator[](int index) const;
+
+        bool success() const { return _node != nullptr; }
+        size_t size() const;
+
+        template<typename T> T as() const { return asValue((T *)nullptr); }
+        template<typename T> bool is() const { return isType((T *)nullptr); }
+        template<typename T> operator T() const { return as<T>(); }
+
+    private:
+        const char *asValue(const char **) const;
+        bool asValue(bool *) const;
+        template<typename T> typename std::enable_if<std::is_integral<T>::value, T>::type asValue(T *) const { return (T)asInteger(); }
+        template<typename T> typename std::enable_if<std::is_floating_point<T>::value, T>::type asValue(T *) const { return (T)asReal(); }
+        long long asInteger() const;
+        double asReal() const;
+
+        bool isType(const char **) const { return _node && (_node->type == JsonNode::STRING); }
+        bool isType(bool *) const { return _node && (_node->type == JsonNode::BOOLEAN); }
+        template<typename T> typename std::enable_if<std::is_integral<T>::value, bool>::type isType(T *) const { return _node && (_node->type == JsonNode::INTEGER); }
+        template<typename T> typename std::enable_if<std::is_floating_point<T>::value, bool>::type isType(T *) const { return _node && ((_node->type == JsonNode::INTEGER) || (_node->type == JsonNode::FLOAT)); }
+
+        const JsonNode *_node;
+};
+
+class JsonObject {
+    public:
+        JsonObject(const JsonNode *node = nullptr) : _node(node) {}
+
+        JsonVariant operator[](const char *key) const { return JsonVariant(_node)[key]; }
+        bool containsKey(const char *key) const { return JsonVariant(_node)[key].success(); }
+        bool success() const { return _node != nullptr; }
+        size_t size() const { return JsonVariant(_node).size(); }
+
+    private:
+        const JsonNode *_node;
+};
+
+class JsonBuffer {
+    public:
+        JsonBuffer() = default;
+        JsonBuffer(const JsonBuffer &) = delete;
+        JsonBuffer &operator=(const JsonBuffer &) = delete;
+
+        JsonObject &parseObject(const char *json);
+
+    private:
+        const JsonNode *parseValue(const char *&p);
+        const JsonNode *parseString(const char *&p);
+        const JsonNode *parseNumber(const char *&p);
+        bool parseLiteral(const char *&p, const char *word);
+        JsonNode *newNode(JsonNode::Type type);
+
+        std::deque<JsonNode> _nodes;
+        JsonObject _root;
+};
+
+template<size_t CAPACITY> class StaticJsonBuffer : public JsonBuffer {
+};
@@ -0,0 +1,207 @@
+/* ************************************************************************ */
+/*
+    Arduino.cpp - host stand-in for the ESP8266 Arduino core, see Arduino.h
+*/
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "Arduino.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static bool virtualClock = false;
+static unsigned long virtualMillis = 0;
+static unsigned long virtualMicros = 0;
+static void (*delayHook)(unsigned long) = NULL;
+
+static bool serialMute = false;
+static uint32_t freeHeap = 40000;
+static int restarts = 0;
+static rst_info resetInfo = { REASON_EXT_SYS_RST, 0, 0, 0, 0, 0, 0 };
+
+static std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+static uint64_t elapsedMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+/* ************************************************************************ */
+/*
+    Host controls, see host.h
+*/
+void hostSetMillis(unsigned long ms)
+{
+    virtualClock = true;
+    virtualMillis = ms;
+    virtualMicros = 0;
+}
+
+void hostAdvance(unsigned long ms)
+{
+    virtualMillis += ms;
+}
+
+void hostSetDelayHook(void (*hook)(unsigned long ms))
+{
+    delayHook = hook;
+}
+
+void hostSetFreeHeap(uint32_t bytes)
+{
+    freeHeap = bytes;
+}
+
+void hostSerialMute(bool mute)
+{
+    serialMute = mute;
+}
+
+int hostRestarts()
+{
+    return restarts;
+}
+
+/* ************************************************************************ */
+/*
+    Time
+*/
+/*
+    They are 32 bits on the device and roll over, they do here too
+*/
+unsigned long millis()
+{
+    if(virtualClock) return (uint32_t)virtualMillis;
+    return (uint32_t)(elapsedMicros() / 1000);
+}
+
+unsigned long micros()
+{
+    if(virtualClock) return (uint32_t)(virtualMillis * 1000 + virtualMicros);
+    return (uint32_t)elapsedMicros();
+}
+
+void delay(unsigned long ms)
+{
+    if(virtualClock) virtualMillis += ms;
+    else if(delayHook != NULL) delayHook(ms);
+    else std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    if(virtualClock)
+    {
+        virtualMicros += us;
+        virtualMillis += virtualMicros / 1000;
+        virtualMicros %= 1000;
+    } else std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield()
+{
+}
+
+/* ************************************************************************ */
+/*
+    Pins, the sensor is simulated (DHT_SIM) and the LED isn't there
+*/
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+}
+
+int digitalRead(uint8_t pin)
+{
+    return HIGH;
+}
+
+/* ************************************************************************ */
+/*
+    Serial
+*/
+int HardwareSerial::availableForWrite()
+{
+    return 256;
+}
+
+void HardwareSerial::flush()
+{
+    fflush(stdout);
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t len)
+{
+    if(!serialMute) fwrite(buf, 1, len, stdout);
+    return len;
+}
+
+size_t HardwareSerial::printf(const char *format, ...)
+{
+char buf[256];
+va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+
+    if(len < 0) return 0;
+    if(len >= (int)sizeof(buf)) len = sizeof(buf) - 1;
+    return write((const uint8_t *)buf, len);
+}
+
+/* ************************************************************************ */
+/*
+    ESP, the cycle counter runs at F_CPU in real time
+*/
+uint32_t EspClass::getCycleCount()
+{
+    return (uint32_t)(elapsedMicros() * clockCyclesPerMicrosecond());
+}
+
+uint32_t EspClass::getFreeHeap()
+{
+    return freeHeap;
+}
+
+uint8_t EspClass::getHeapFragmentation()
+{
+    return 0;
+}
+
+uint32_t EspClass::getMaxFreeBlockSize()
+{
+    return freeHeap;
+}
+
+uint32_t EspClass::getChipId()
+{
+    return 0x00E5C0DE;
+}
+
+uint32_t EspClass::random()
+{
+static std::random_device rd;
+
+    return rd();
+}
+
+rst_info *EspClass::getResetInfoPtr()
+{
+    return &resetInfo;
+}
+
+void EspClass::restart()
+{
+    restarts += 1;
+}
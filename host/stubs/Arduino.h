@@ -0,0 +1,158 @@
+/* ************************************************************************ */
+/*
+    Arduino.h - host stand-in for the parts of the ESP8266 Arduino core
+    that the application uses.
+
+    The clock is real time until a test calls hostSetMillis(), from then
+    on it is virtual and only moves with delay() and hostAdvance(). Either
+    way millis() and micros() wrap at 32 bits like the device's. The
+    pins do nothing, the sensor is read through DHT_SIM. See host.h for
+    the functions that tests use to control the stand-ins.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "WString.h"
+#include "host.h"
+
+using std::abs;
+using std::min;
+using std::max;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH    0x1
+#define LOW     0x0
+
+#define INPUT           0x00
+#define OUTPUT          0x01
+#define INPUT_PULLUP    0x02
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+// NodeMCU pin names, the GPIO numbers are the ones used by the core
+#define D0  16
+#define D1  5
+#define D2  4
+#define D3  0
+#define D4  2
+#define D5  14
+#define D6  12
+#define D7  13
+#define D8  15
+#define LED_BUILTIN 2
+
+#define F_CPU   80000000L
+#define clockCyclesPerMicrosecond() (F_CPU / 1000000L)
+#define clockCyclesToMicroseconds(a) ((a) / clockCyclesPerMicrosecond())
+#define microsecondsToClockCycles(a) ((a) * clockCyclesPerMicrosecond())
+
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+
+// there's no separate program memory on the host
+#define PROGMEM
+#define ICACHE_RAM_ATTR
+#define F(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+#define interrupts()
+#define noInterrupts()
+
+/*
+    Serial writes to stdout
+*/
+class HardwareSerial {
+    public:
+        void begin(unsigned long baud) { _baud = baud; }
+        void end() {}
+        unsigned long baudRate() { return _baud; }
+        int availableForWrite();
+        void flush();
+
+        size_t write(uint8_t c);
+        size_t write(const uint8_t *buf, size_t len);
+        size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+
+        size_t printf(const char *format, ...) __attribute__ ((format (printf, 2, 3)));
+
+        size_t print(const String &s) { return write(s.c_str()); }
+        size_t print(const char *s) { return write(s); }
+        size_t print(char c) { return write((uint8_t)c); }
+        size_t print(int n, int base = DEC) { return print(String(n, base)); }
+        size_t print(unsigned int n, int base = DEC) { return print(String(n, base)); }
+        size_t print(long n, int base = DEC) { return print(String(n, base)); }
+        size_t print(unsigned long n, int base = DEC) { return print(String(n, base)); }
+        size_t print(double n, int digits = 2) { return print(String(n, digits)); }
+
+        template<typename T> size_t println(const T &v) { return print(v) + println(); }
+        template<typename T> size_t println(const T &v, int fmt) { return print(v, fmt) + println(); }
+        size_t println() { return write("\r\n"); }
+
+    private:
+        unsigned long _baud = 0;
+};
+
+extern HardwareSerial Serial;
+
+/*
+    The ESP object
+*/
+struct rst_info {
+    uint32_t reason;
+    uint32_t exccause;
+    uint32_t epc1;
+    uint32_t epc2;
+    uint32_t epc3;
+    uint32_t excvaddr;
+    uint32_t depc;
+};
+
+enum rst_reason {
+    REASON_DEFAULT_RST = 0,
+    REASON_WDT_RST = 1,
+    REASON_EXCEPTION_RST = 2,
+    REASON_SOFT_WDT_RST = 3,
+    REASON_SOFT_RESTART = 4,
+    REASON_DEEP_SLEEP_AWAKE = 5,
+    REASON_EXT_SYS_RST = 6
+};
+
+class EspClass {
+    public:
+        uint32_t getCycleCount();
+        uint32_t getFreeHeap();
+        uint8_t getHeapFragmentation();
+        uint32_t getMaxFreeBlockSize();
+        uint32_t getChipId();
+        uint32_t random();
+        rst_info *getResetInfoPtr();
+        void restart();
+};
+
+extern EspClass ESP;
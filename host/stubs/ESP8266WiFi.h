@@ -0,0 +1,38 @@
+/* ************************************************************************ */
+/*
+    ESP8266WiFi.h - host stand-in, the station is always connected. The
+    address and hostname are set with hostSetIP() and hostSetHostname().
+*/
+#pragma once
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} WiFiMode_t;
+
+class ESP8266WiFiClass {
+    public:
+        bool mode(WiFiMode_t m) { return true; }
+        wl_status_t begin(const char *ssid, const char *passphrase = NULL) { return WL_CONNECTED; }
+        wl_status_t status() { return WL_CONNECTED; }
+        IPAddress localIP();
+        String hostname();
+        uint8_t *macAddress(uint8_t *mac);
+        String macAddress();
+        int32_t RSSI() { return -50; }
+};
+
+extern ESP8266WiFiClass WiFi;
@@ -0,0 +1,63 @@
+/* ************************************************************************ */
+/*
+    FS.cpp - host stand-in for SPIFFS, see FS.h
+*/
+#include <string.h>
+#include <string>
+
+#include <sys/stat.h>
+
+#include "FS.h"
+#include "host.h"
+
+#ifndef HOST_FS_ROOT
+#define HOST_FS_ROOT "data"
+#endif
+
+FS SPIFFS;
+
+static std::string fsRoot = HOST_FS_ROOT;
+
+void hostSetFSRoot(const char *dir)
+{
+    fsRoot = dir;
+}
+
+File::File(FILE *fp)
+{
+    if(fp != NULL) _fp = std::shared_ptr<FILE>(fp, fclose);
+}
+
+size_t File::size() const
+{
+struct stat st;
+
+    if(!_fp || (fstat(fileno(_fp.get()), &st) != 0)) return 0;
+    return (size_t)st.st_size;
+}
+
+size_t File::readBytes(char *buffer, size_t length)
+{
+    if(!_fp) return 0;
+    return fread(buffer, 1, length, _fp.get());
+}
+
+bool FS::info(FSInfo &info)
+{
+    memset(&info, 0, sizeof(info));
+    info.maxOpenFiles = 5;
+    info.maxPathLength = 32;
+    return true;
+}
+
+File FS::open(const char *path, const char *mode)
+{
+    return File(fopen((fsRoot + path).c_str(), mode));
+}
+
+bool FS::exists(const char *path)
+{
+struct stat st;
+
+    return stat((fsRoot + path).c_str(), &st) == 0;
+}
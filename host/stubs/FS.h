@@ -0,0 +1,45 @@
+/* ************************************************************************ */
+/*
+    FS.h - host stand-in for SPIFFS, the files are read from a directory.
+    It's HOST_FS_ROOT unless hostSetFSRoot() is called.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+#include <memory>
+
+#include "Arduino.h"
+
+struct FSInfo {
+    size_t totalBytes;
+    size_t usedBytes;
+    size_t blockSize;
+    size_t pageSize;
+    size_t maxOpenFiles;
+    size_t maxPathLength;
+};
+
+class File {
+    public:
+        File(FILE *fp = NULL);
+
+        operator bool() const { return _fp != nullptr; }
+        size_t size() const;
+        size_t readBytes(char *buffer, size_t length);
+        void close() { _fp.reset(); }
+
+    private:
+        std::shared_ptr<FILE> _fp;
+};
+
+class FS {
+    public:
+        bool begin() { return true; }
+        void end() {}
+        bool info(FSInfo &info);
+        File open(const char *path, const char *mode);
+        bool exists(const char *path);
+};
+
+extern FS SPIFFS;
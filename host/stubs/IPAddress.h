@@ -0,0 +1,29 @@
+/* ************************************************************************ */
+/*
+    IPAddress.h - host stand-in, the address is kept in network order as
+    the core does
+*/
+#pragma once
+
+#include <stdint.h>
+
+#include "WString.h"
+
+class IPAddress {
+    public:
+        IPAddress() : _addr(0) {}
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d);
+        IPAddress(uint32_t addr) : _addr(addr) {}
+
+        operator uint32_t() const { return _addr; }
+        bool operator==(const IPAddress &rhs) const { return _addr == rhs._addr; }
+        bool operator!=(const IPAddress &rhs) const { return _addr != rhs._addr; }
+        uint8_t operator[](int index) const { return (uint8_t)(_addr >> (8 * index)); }
+
+        bool fromString(const char *address);
+        bool fromString(const String &address) { return fromString(address.c_str()); }
+        String toString() const;
+
+    private:
+        uint32_t _addr;
+};
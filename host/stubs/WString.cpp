@@ -0,0 +1,88 @@
+/* ************************************************************************ */
+/*
+    WString.cpp - host stand-in for the Arduino String class
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "WString.h"
+
+/*
+    Format an unsigned value in any base from 2 to 16, as utoa() does
+*/
+static std::string toBase(unsigned long value, unsigned char base)
+{
+char buf[8 * sizeof(unsigned long) + 1];
+char *p = &buf[sizeof(buf) - 1];
+
+    if((base < 2) || (base > 16)) base = 10;
+    *p = '\0';
+    do
+    {
+        *--p = "0123456789abcdef"[value % base];
+        value /= base;
+    } while(value != 0);
+    return std::string(p);
+}
+
+String::String(unsigned char value, unsigned char base) : _s(toBase(value, base)) {}
+String::String(unsigned int value, unsigned char base) : _s(toBase(value, base)) {}
+String::String(unsigned long value, unsigned char base) : _s(toBase(value, base)) {}
+
+String::String(int value, unsigned char base) : String((long)value, base) {}
+
+String::String(long value, unsigned char base)
+{
+    // like ltoa(), only base 10 is signed
+    if((base == 10) && (value < 0)) _s = "-" + toBase(0UL - (unsigned long)value, base);
+    else _s = toBase((unsigned long)value, base);
+}
+
+String::String(float value, unsigned char decimalPlaces) : String((double)value, decimalPlaces) {}
+
+String::String(double value, unsigned char decimalPlaces)
+{
+char buf[64];
+
+    snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+    _s = buf;
+}
+
+String String::substring(unsigned int left, unsigned int right) const
+{
+    if(left > right) { unsigned int tmp = left; left = right; right = tmp; }
+    if(left >= _s.length()) return String();
+    if(right > _s.length()) right = _s.length();
+    return String(_s.substr(left, right - left).c_str());
+}
+
+void String::toUpperCase()
+{
+    for(auto &c : _s) c = toupper((unsigned char)c);
+}
+
+void String::toLowerCase()
+{
+    for(auto &c : _s) c = tolower((unsigned char)c);
+}
+
+void String::trim()
+{
+    std::string::size_type first = _s.find_first_not_of(" \t\r\n\f\v");
+    std::string::size_type last = _s.find_last_not_of(" \t\r\n\f\v");
+
+    if(first == std::string::npos) _s.clear();
+    else _s = _s.substr(first, last - first + 1);
+}
+
+String operator+(const String &lhs, const String &rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String &lhs, const char *rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const char *lhs, const String &rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String &lhs, char rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String &lhs, int rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String &lhs, unsigned int rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String &lhs, long rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String &lhs, unsigned long rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String &lhs, float rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String &lhs, double rhs) { String s(lhs); s.concat(rhs); return s; }
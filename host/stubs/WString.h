@@ -0,0 +1,80 @@
+/* ************************************************************************ */
+/*
+    WString.h - host stand-in for the Arduino String class, it's kept on
+    a std::string. Only what the application uses is here, the numeric
+    constructors format the same way as the core does.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+class String {
+    public:
+        String(const char *cstr = "") : _s(cstr == NULL ? "" : cstr) {}
+        String(const String &str) = default;
+        String(char c) : _s(1, c) {}
+        explicit String(unsigned char value, unsigned char base = 10);
+        explicit String(int value, unsigned char base = 10);
+        explicit String(unsigned int value, unsigned char base = 10);
+        explicit String(long value, unsigned char base = 10);
+        explicit String(unsigned long value, unsigned char base = 10);
+        explicit String(float value, unsigned char decimalPlaces = 2);
+        explicit String(double value, unsigned char decimalPlaces = 2);
+
+        String &operator=(const String &rhs) = default;
+        String &operator=(const char *cstr) { _s = (cstr == NULL ? "" : cstr); return *this; }
+
+        unsigned int length() const { return _s.length(); }
+        const char *c_str() const { return _s.c_str(); }
+        char charAt(unsigned int index) const { return (index < _s.length() ? _s[index] : 0); }
+        char operator[](unsigned int index) const { return charAt(index); }
+
+        bool concat(const String &str) { _s += str._s; return true; }
+        bool concat(const char *cstr) { if(cstr != NULL) _s += cstr; return true; }
+        bool concat(char c) { _s += c; return true; }
+        bool concat(int n) { return concat(String(n)); }
+        bool concat(unsigned int n) { return concat(String(n)); }
+        bool concat(long n) { return concat(String(n)); }
+        bool concat(unsigned long n) { return concat(String(n)); }
+        bool concat(float n) { return concat(String(n)); }
+        bool concat(double n) { return concat(String(n)); }
+
+        template<typename T> String &operator+=(const T &rhs) { concat(rhs); return *this; }
+
+        bool equals(const String &s) const { return _s == s._s; }
+        bool equals(const char *cstr) const { return _s == (cstr == NULL ? "" : cstr); }
+        bool operator==(const String &rhs) const { return equals(rhs); }
+        bool operator==(const char *cstr) const { return equals(cstr); }
+        bool operator!=(const String &rhs) const { return !equals(rhs); }
+        bool operator!=(const char *cstr) const { return !equals(cstr); }
+
+        bool startsWith(const String &prefix) const { return _s.compare(0, prefix._s.length(), prefix._s) == 0; }
+        int indexOf(char ch, unsigned int from = 0) const { return find(_s.find(ch, from)); }
+        int indexOf(const String &str, unsigned int from = 0) const { return find(_s.find(str._s, from)); }
+        String substring(unsigned int left) const { return substring(left, _s.length()); }
+        String substring(unsigned int left, unsigned int right) const;
+
+        void toUpperCase();
+        void toLowerCase();
+        void trim();
+        long toInt() const { return atol(_s.c_str()); }
+        float toFloat() const { return (float)atof(_s.c_str()); }
+
+    private:
+        static int find(std::string::size_type pos) { return (pos == std::string::npos ? -1 : (int)pos); }
+
+        std::string _s;
+};
+
+String operator+(const String &lhs, const String &rhs);
+String operator+(const String &lhs, const char *rhs);
+String operator+(const char *lhs, const String &rhs);
+String operator+(const String &lhs, char rhs);
+String operator+(const String &lhs, int rhs);
+String operator+(const String &lhs, unsigned int rhs);
+String operator+(const String &lhs, long rhs);
+String operator+(const String &lhs, unsigned long rhs);
+String operator+(const String &lhs, float rhs);
+String operator+(const String &lhs, double rhs);
@@ -0,0 +1,224 @@
+/* ************************************************************************ */
+/*
+    WiFi.cpp - host stand-ins for IPAddress, WiFi and WiFiUDP
+*/
+#include <map>
+#include <string>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ESP8266WiFi.h"
+#include "WiFiUdp.h"
+
+ESP8266WiFiClass WiFi;
+
+static std::string hostIP = "127.0.0.1";
+static std::string hostName = "ESP_HOST";
+
+static std::map<uint16_t, unsigned long> udpSent;
+static unsigned long udpFailed = 0;
+
+/* ************************************************************************ */
+/*
+    Host controls, see host.h
+*/
+void hostSetIP(const char *ip)
+{
+    hostIP = ip;
+}
+
+void hostSetHostname(const char *name)
+{
+    hostName = name;
+}
+
+unsigned long hostUDPSent(uint16_t port)
+{
+    return udpSent[port];
+}
+
+unsigned long hostUDPFailed()
+{
+    return udpFailed;
+}
+
+/* ************************************************************************ */
+/*
+    IPAddress
+*/
+IPAddress::IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+    _addr = (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+}
+
+bool IPAddress::fromString(const char *address)
+{
+struct in_addr in;
+
+    if((address == NULL) || (inet_pton(AF_INET, address, &in) != 1)) return false;
+    _addr = in.s_addr;
+    return true;
+}
+
+String IPAddress::toString() const
+{
+char buf[INET_ADDRSTRLEN];
+struct in_addr in;
+
+    in.s_addr = _addr;
+    return String(inet_ntop(AF_INET, &in, buf, sizeof(buf)));
+}
+
+/* ************************************************************************ */
+/*
+    WiFi, the MAC address is made from the IP address so that every host
+    device has its own
+*/
+IPAddress ESP8266WiFiClass::localIP()
+{
+IPAddress ip;
+
+    ip.fromString(hostIP.c_str());
+    return ip;
+}
+
+String ESP8266WiFiClass::hostname()
+{
+    return String(hostName.c_str());
+}
+
+uint8_t *ESP8266WiFiClass::macAddress(uint8_t *mac)
+{
+IPAddress ip = localIP();
+
+    mac[0] = 0x5C; mac[1] = 0xCF; mac[2] = 0x7F;
+    mac[3] = ip[1]; mac[4] = ip[2]; mac[5] = ip[3];
+    return mac;
+}
+
+String ESP8266WiFiClass::macAddress()
+{
+uint8_t mac[6];
+char buf[18];
+
+    macAddress(mac);
+    snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return String(buf);
+}
+
+/* ************************************************************************ */
+/*
+    WiFiUDP
+*/
+bool WiFiUDP::open(uint16_t port)
+{
+struct sockaddr_in addr;
+
+    stop();
+    if((_sock = socket(AF_INET, SOCK_DGRAM, 0)) < 0) return false;
+    fcntl(_sock, F_SETFL, O_NONBLOCK);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = (uint32_t)WiFi.localIP();
+    if(bind(_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port)
+{
+    return (open(port) ? 1 : 0);
+}
+
+void WiFiUDP::stop()
+{
+    if(_sock >= 0) close(_sock);
+    _sock = -1;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+    // a client that never called begin() sends from any port
+    if((_sock < 0) && !open(0)) return 0;
+
+    _destIP = ip;
+    _destPort = port;
+    _txLen = 0;
+    return 1;
+}
+
+int WiFiUDP::beginPacketMulticast(IPAddress multicastAddress, uint16_t port, IPAddress interfaceAddress, int ttl)
+{
+    return beginPacket(multicastAddress, port);
+}
+
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size)
+{
+    // the core's write() fails when the packet is full
+    if(size > (HOST_UDP_MAX - _txLen)) size = HOST_UDP_MAX - _txLen;
+    memcpy(_tx + _txLen, buffer, size);
+    _txLen += size;
+    return size;
+}
+
+int WiFiUDP::endPacket()
+{
+struct sockaddr_in addr;
+
+    if(_sock < 0) return 0;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(_destPort);
+    addr.sin_addr.s_addr = (uint32_t)_destIP;
+
+    if(sendto(_sock, _tx, _txLen, 0, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        udpFailed += 1;
+        return 0;
+    }
+    udpSent[_destPort] += 1;
+    return 1;
+}
+
+int WiFiUDP::parsePacket()
+{
+struct sockaddr_in addr;
+socklen_t addrlen = sizeof(addr);
+
+    _rxLen = 0;
+    _rxPos = 0;
+    if(_sock < 0) return 0;
+
+    ssize_t len = recvfrom(_sock, _rx, sizeof(_rx), 0, (struct sockaddr *)&addr, &addrlen);
+    if(len <= 0) return 0;
+
+    _rxLen = (size_t)len;
+    _remoteIP = IPAddress((uint32_t)addr.sin_addr.s_addr);
+    _remotePort = ntohs(addr.sin_port);
+    return (int)len;
+}
+
+int WiFiUDP::read()
+{
+    return (_rxPos < _rxLen ? _rx[_rxPos++] : -1);
+}
+
+int WiFiUDP::read(unsigned char *buffer, size_t len)
+{
+size_t count = _rxLen - _rxPos;
+
+    if(count > len) count = len;
+    memcpy(buffer, _rx + _rxPos, count);
+    _rxPos += count;
+    return (int)count;
+}
@@ -0,0 +1,55 @@
+/* ************************************************************************ */
+/*
+    WiFiUdp.h - host stand-in that uses a UDP socket, it's bound to the
+    address set with hostSetIP(). Multicast addresses are sent to like any
+    other, the host configs use a unicast address instead. The packets
+    are kept in fixed buffers like the core's, so the heap that a soak
+    test sees is the application's.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "IPAddress.h"
+
+// the largest packet that can be sent or received
+#define HOST_UDP_MAX    1500
+
+class WiFiUDP {
+    public:
+        WiFiUDP() : _sock(-1), _remotePort(0), _destPort(0), _txLen(0), _rxLen(0), _rxPos(0) {}
+        ~WiFiUDP() { stop(); }
+
+        uint8_t begin(uint16_t port);
+        void stop();
+
+        int beginPacket(IPAddress ip, uint16_t port);
+        int beginPacketMulticast(IPAddress multicastAddress, uint16_t port, IPAddress interfaceAddress, int ttl = 1);
+        size_t write(uint8_t c) { return write(&c, 1); }
+        size_t write(const uint8_t *buffer, size_t size);
+        size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+        int endPacket();
+
+        int parsePacket();
+        int available() { return (int)(_rxLen - _rxPos); }
+        int read();
+        int read(unsigned char *buffer, size_t len);
+        int read(char *buffer, size_t len) { return read((unsigned char *)buffer, len); }
+
+        IPAddress remoteIP() { return _remoteIP; }
+        uint16_t remotePort() { return _remotePort; }
+
+    private:
+        bool open(uint16_t port);
+
+        int _sock;
+        IPAddress _remoteIP;
+        uint16_t _remotePort;
+        IPAddress _destIP;
+        uint16_t _destPort;
+        uint8_t _tx[HOST_UDP_MAX];
+        size_t _txLen;
+        uint8_t _rx[HOST_UDP_MAX];
+        size_t _rxLen;
+        size_t _rxPos;
+};
@@ -0,0 +1,40 @@
+/* ************************************************************************ */
+/*
+    host.h - controls for the host stand-ins, these don't exist on the
+    device. Tests use them to move the clock, set up the file system and
+    the network identity, and to watch what the application does.
+*/
+#pragma once
+
+#include <stdint.h>
+
+// switch to the virtual clock and set it, then move it forward
+void hostSetMillis(unsigned long ms);
+void hostAdvance(unsigned long ms);
+
+// delay() on the real clock calls this instead of sleeping, host-device
+// uses it to run other devices while one waits
+void hostSetDelayHook(void (*hook)(unsigned long ms));
+
+// the directory that SPIFFS is read from, the default is HOST_FS_ROOT
+void hostSetFSRoot(const char *dir);
+
+// the device's address and hostname, the defaults are 127.0.0.1 and
+// ESP_HOST. Any 127.x.y.z address can be used so that several devices
+// can listen on the command port.
+void hostSetIP(const char *ip);
+void hostSetHostname(const char *name);
+
+// what ESP.getFreeHeap() returns
+void hostSetFreeHeap(uint32_t bytes);
+
+// stop Serial writing to stdout
+void hostSerialMute(bool mute);
+
+// the number of times that ESP.restart() was called
+int hostRestarts();
+
+// the number of UDP packets sent to `port` (any address), and the
+// number that failed
+unsigned long hostUDPSent(uint16_t port);
+unsigned long hostUDPFailed();
@@ -0,0 +1,324 @@
+/* ************************************************************************ */
+/*
+    test-cmd.cpp - sends commands to handleComm() from a UDP peer and
+    checks the replies. Every opcode from A to Z is sent, along with bad
+    arguments, empty and oversized packets, and bytes that aren't opcodes.
+*/
+#include <ArduinoJson.h>
+
+#include "esp8266-cmd.h"
+#include "sensor-dht.h"
+#include "sensor-diag.h"
+
+#include "test.h"
+
+extern "C" bool connectWiFi(String ssid, String pass);
+extern "C" char cmdReplyBuffer[];
+
+// the collector port in test/data/clientcfg.json
+#define COLLECTOR_PORT  54390
+// the multicast port in test/data/multicfg.json
+#define MCAST_PORT      54391
+
+static int peer = -1;
+static int collector = -1;
+
+/*
+    Send a command and run handleComm() until it has been received.
+    Returns the reply's length, or -1 if there wasn't one.
+*/
+static int sendCmd(const void *cmd, size_t len, char *reply, size_t size)
+{
+    peerSend(peer, UDP_CMD_PORT, cmd, len);
+    for(int ix = 0; (ix < 50) && (handleComm() == 0); ix++) usleep(1000);
+    return peerRecv(peer, reply, size, 100);
+}
+
+/*
+    Send a command and check the reply's opcode and status, the reply
+    must be valid JSON that fits in a payload. Returns the parsed reply
+    so that the caller can check the rest of it.
+*/
+static JsonObject &checkCmd(JsonBuffer &json, const char *cmd, char op, const char *status)
+{
+static char reply[1500];
+int len = sendCmd(cmd, strlen(cmd), reply, sizeof(reply));
+
+    CHECK_MSG(len > 0, "no reply to [%s]", cmd);
+    CHECK_MSG(len <= UDP_PAYLOAD_SIZE, "[%s] reply is %d bytes", cmd, len);
+
+    JsonObject &r = json.parseObject(reply);
+    CHECK_MSG(r.success(), "[%s] reply isn't JSON - %s", cmd, reply);
+    CHECK_MSG((r["reply"].as<const char *>() != NULL) && (r["reply"].as<const char *>()[0] == op), "[%s] - %s", cmd, reply);
+    CHECK_MSG((r["status"].as<const char *>() != NULL) && (strcmp(r["status"], status) == 0), "[%s] expected %s - %s", cmd, status, reply);
+    CHECK_MSG((r["dev_id"].as<const char *>() != NULL) && (strcmp(r["dev_id"], devID) == 0), "[%s] - %s", cmd, reply);
+    return r;
+}
+
+/*
+    Every opcode with no arguments
+*/
+static void testOpcodes()
+{
+char cmd[2] = { 0, 0 };
+
+    for(char op = CMD_FIRST; op <= CMD_LAST; op++)
+    {
+        StaticJsonBuffer<200> json;
+        const char *status = "UNKNOWN";
+
+        // reboot is tested last
+        if(op == CMD_REBOOT) continue;
+
+        switch(op)
+        {
+            case CMD_READ:
+            case CMD_STATS:
+            case CMD_FILTER:
+            case CMD_DIAG:
+            case CMD_MUTE:
+                status = "OK";
+                break;
+            // these need an argument
+            case CMD_INTERVAL:
+            case CMD_DELTA:
+            case CMD_REPORT:
+                status = "FAIL";
+                break;
+            // USE_OTA isn't supported on the host
+            case CMD_OTA:
+            default:
+                break;
+        }
+        cmd[0] = op;
+        checkCmd(json, cmd, op, status);
+    }
+}
+
+static void testArguments()
+{
+char reply[200];
+
+    {
+        StaticJsonBuffer<200> json;
+        JsonObject &r = checkCmd(json, "I 60000", 'I', "OK");
+        CHECK((unsigned long)r["interval"] == 60000);
+        CHECK(getSensorInterval() == 60000);
+    }
+    {
+        StaticJsonBuffer<200> json;
+        checkCmd(json, "I 2499", 'I', "FAIL");
+        // longer than timeReached() can handle on the device
+        checkCmd(json, "I 2147483648", 'I', "FAIL");
+        checkCmd(json, "I 536870912", 'I', "FAIL");
+        checkCmd(json, "I -60000", 'I', "FAIL");
+        checkCmd(json, "I abc", 'I', "FAIL");
+        CHECK(getSensorInterval() == 60000);
+    }
+    {
+        StaticJsonBuffer<200> json;
+        JsonObject &r = checkCmd(json, "D 5 10", 'D', "OK");
+        CHECK((int)r["delta_t"] == 5);
+        CHECK((int)r["delta_h"] == 10);
+        checkCmd(json, "D 5", 'D', "FAIL");
+        checkCmd(json, "D -1 5", 'D', "FAIL");
+        checkCmd(json, "D x y", 'D', "FAIL");
+    }
+#ifdef SENSOR_PROFILE
+    {
+        // the mode is compiled in
+        StaticJsonBuffer<200> json;
+        checkCmd(json, "M ALL", 'M', "FAIL");
+        checkCmd(json, "M CHG", 'M', "FAIL");
+    }
+#else
+    {
+        StaticJsonBuffer<200> json;
+        JsonObject &r = checkCmd(json, "M ALL", 'M', "OK");
+        CHECK(strcmp(r["report"], "ALL") == 0);
+        checkCmd(json, "M XYZ", 'M', "FAIL");
+        // not cut down to "STATS"
+        checkCmd(json, "M STATSX", 'M', "FAIL");
+        checkCmd(json, "M", 'M', "FAIL");
+        JsonObject &r2 = checkCmd(json, "M CHG", 'M', "OK");
+        CHECK(strcmp(r2["report"], "CHG") == 0);
+    }
+#endif
+    {
+        StaticJsonBuffer<200> json;
+        JsonObject &r = checkCmd(json, "H R", 'H', "OK");
+        CHECK(r["ratio"].size() == 8);
+        JsonObject &r2 = checkCmd(json, "H C", 'H', "OK");
+        CHECK(r2["fail"].size() == 4);
+        checkCmd(json, "H X", 'H', "FAIL");
+    }
+    {
+        StaticJsonBuffer<200> json;
+        JsonObject &r = checkCmd(json, "Q 1", 'Q', "OK");
+        CHECK((int)r["mute"] == 1);
+        JsonObject &r2 = checkCmd(json, "Q 0", 'Q', "OK");
+        CHECK((int)r2["mute"] == 0);
+    }
+    {
+        // R sends a reading to the collector
+        StaticJsonBuffer<200> json;
+        while(peerRecv(collector, reply, sizeof(reply), 0) > 0);
+        checkCmd(json, "R", 'R', "OK");
+        CHECK(peerRecv(collector, reply, sizeof(reply), 100) > 0);
+        JsonObject &data = json.parseObject(reply);
+        CHECK(data.success() && data.containsKey("t") && data.containsKey("h"));
+        // drawn for the first report, it doesn't change
+        CHECK(((uint32_t)data["boot"] != 0) && ((uint32_t)data["boot"] == bootID));
+    }
+}
+
+/*
+    S and H take a probe's number, and there's a SENSOR_DIAG message
+    for each sensor
+*/
+static void testProbes()
+{
+char buf[1500];
+int mcast = peerOpen(MCAST_PORT);
+int count[SENSOR_MAX] = { 0 };
+
+    CHECK(setupSensor("/sensorcfg-probes.json"));
+    {
+        StaticJsonBuffer<300> json;
+        JsonObject &r = checkCmd(json, "S 1", 'S', "OK");
+        CHECK(((int)r["sensor"] == 1) && ((unsigned long)r["interval"] == 10000));
+        JsonObject &r2 = checkCmd(json, "S", 'S', "OK");
+        CHECK(!r2.containsKey("sensor"));
+        checkCmd(json, "S 3", 'S', "FAIL");
+    }
+    {
+        StaticJsonBuffer<300> json;
+        JsonObject &r = checkCmd(json, "H 2", 'H', "OK");
+        CHECK(((int)r["sensor"] == 2) && r.containsKey("good"));
+        JsonObject &r2 = checkCmd(json, "H R 1", 'H', "OK");
+        CHECK(((int)r2["sensor"] == 1) && r2.containsKey("ratio"));
+        checkCmd(json, "H C 2", 'H', "OK");
+        checkCmd(json, "H 3", 'H', "FAIL");
+        checkCmd(json, "H R -1", 'H', "FAIL");
+    }
+
+    CHECK(mcast >= 0);
+    CHECK(sendSensorDiag());
+    while(peerRecv(mcast, buf, sizeof(buf), 50) > 0)
+    {
+        StaticJsonBuffer<300> json;
+        JsonObject &r = json.parseObject(buf);
+
+        if(!r.success() || (strcmp(r["status"].as<const char *>(), "SENSOR_DIAG") != 0)) continue;
+        int num = (r.containsKey("sensor") ? (int)r["sensor"] : 0);
+        CHECK_MSG((num >= 0) && (num < SENSOR_MAX), "%s", buf);
+        if((num >= 0) && (num < SENSOR_MAX)) count[num] += 1;
+    }
+    for(int ix = 0; ix < SENSOR_MAX; ix++) CHECK_MSG(count[ix] == 1, "sensor %d - %d SENSOR_DIAG", ix, count[ix]);
+    close(mcast);
+
+    CHECK(setupSensor("/sensorcfg.json"));
+}
+
+/*
+    Bytes that aren't opcodes are answered with "?"
+*/
+static void testMalformed()
+{
+char reply[1500];
+char cmd[UDP_PAYLOAD_SIZE + 1];
+const char notops[] = { 'r', 'a', 'z', '@', '[', '1', ' ', '"', '{', '\\', (char)0x80, (char)0xFF };
+
+    for(char op : notops)
+    {
+        StaticJsonBuffer<200> json;
+        char tmp[3] = { op, 'I', 0 };
+        checkCmd(json, tmp, '?', "UNKNOWN");
+    }
+
+    // an empty packet isn't a command
+    peerSend(peer, UDP_CMD_PORT, "", 0);
+    for(int ix = 0; ix < 10; ix++) { handleComm(); usleep(1000); }
+    CHECK(peerRecv(peer, reply, sizeof(reply), 50) < 0);
+
+    // a NUL opcode
+    CHECK(sendCmd("\0I", 2, reply, sizeof(reply)) > 0);
+    CHECK(strstr(reply, "\"reply\":\"?\"") != NULL);
+
+    // the longest packet that's accepted
+    memset(cmd, ' ', sizeof(cmd));
+    memcpy(cmd, "I 60000", 7);
+    CHECK(sendCmd(cmd, UDP_PAYLOAD_SIZE - 1, reply, sizeof(reply)) > 0);
+    CHECK(strstr(reply, "\"status\":\"OK\"") != NULL);
+
+    // too long, it's dropped without a reply
+    CHECK(sendCmd(cmd, UDP_PAYLOAD_SIZE, reply, sizeof(reply)) < 0);
+    CHECK(sendCmd(cmd, sizeof(cmd), reply, sizeof(reply)) < 0);
+
+    // the read buffer wasn't overrun, the next command works
+    StaticJsonBuffer<200> json;
+    checkCmd(json, "S", 'S', "OK");
+}
+
+/*
+    With the longest device ID the replies that have the most to say
+    don't fit. They must not be sent cut short, the short ones still are.
+*/
+static void testReplyBounds()
+{
+char reply[1500];
+const char *longest = "ESP_0123456789ABCDEF0123456789AB";
+const char *cmds[] = { "S", "H", "H R", "F", "I 536870911", "D 2147483647 2147483647", "A", "Q 0" };
+
+    CHECK(strlen(longest) == DEVID_SIZE - 1);
+    hostSetHostname(longest);
+    CHECK(connectWiFi("host", "host"));
+    CHECK(strcmp(devID, longest) == 0);
+
+    for(const char *cmd : cmds)
+    {
+        int len = sendCmd(cmd, strlen(cmd), reply, sizeof(reply));
+        if(len > 0)
+        {
+            StaticJsonBuffer<200> json;
+            CHECK_MSG(len <= UDP_PAYLOAD_SIZE, "[%s] reply is %d bytes", cmd, len);
+            CHECK_MSG(json.parseObject(reply).success(), "[%s] reply isn't JSON - %s", cmd, reply);
+        }
+        // the reply buffer is never filled past its end
+        CHECK(strlen(cmdReplyBuffer) <= UDP_PAYLOAD_SIZE);
+    }
+    CHECK(sendCmd("A", 1, reply, sizeof(reply)) > 0);
+    CHECK(sendCmd("Q 0", 3, reply, sizeof(reply)) > 0);
+
+    hostSetHostname("ESP_HOST");
+    CHECK(connectWiFi("host", "host"));
+}
+
+static void testReboot()
+{
+    StaticJsonBuffer<200> json;
+    CHECK(hostRestarts() == 0);
+    // the reply is sent before the restart
+    checkCmd(json, "B", 'B', "OK");
+    CHECK(hostRestarts() == 1);
+}
+
+int main()
+{
+    hostSetMillis(1000);
+    testSetup();
+    initCmd();
+
+    peer = peerOpen(0);
+    collector = peerOpen(COLLECTOR_PORT);
+    CHECK((peer >= 0) && (collector >= 0));
+
+    testOpcodes();
+    testArguments();
+    testMalformed();
+    testReplyBounds();
+    testProbes();
+    testReboot();
+
+    return testResult("cmd");
+}
@@ -0,0 +1,159 @@
+/* ************************************************************************ */
+/*
+    test-config.cpp - reads the config files in test/data with the
+    application's parsers
+*/
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "esp8266-ino.h"
+#include "DHT.h"
+
+#include "test.h"
+
+static void testSensorCfg()
+{
+sensorconfig cfg;
+SensorCfgData *data = new SensorCfgData("/sensorcfg-full.json", true);
+String err;
+
+    CHECK(data->getError(err) == 0);
+    CHECK(data->parseFile());
+    CHECK(data->getSensor(cfg));
+
+    // the first entry in "sensors" replaces the top level settings
+    CHECK(cfg.type == "DHT22");
+    CHECK(cfg.type_id == DHT22);
+    CHECK(cfg.pin == "D5");
+    CHECK(cfg.pin_id == D5);
+    CHECK(cfg.interval == 20000);
+    CHECK(cfg.delta_t == 3);
+    CHECK(cfg.delta_h == 6);
+
+    CHECK(cfg.scale_id == SCALE_C);
+    CHECK(cfg.error_interval == 7000);
+    CHECK(cfg.retries == 3);
+    CHECK(cfg.warmup == 1500);
+    CHECK(cfg.report_id == REPORT_STATS);
+    CHECK(cfg.interval_min == 10000);
+    CHECK(cfg.interval_max == 120000);
+    CHECK(cfg.slope_t == 6);
+    CHECK(cfg.slope_h == 12);
+    CHECK(cfg.backoff == 3);
+    CHECK(cfg.stats_sample == 5000);
+    CHECK(cfg.median == 5);
+    CHECK(cfg.max_rate_t == 20);
+    CHECK(cfg.max_rate_h == 40);
+    CHECK(cfg.ema == 2);
+    CHECK(cfg.derived == true);
+
+    // missing settings are copied from the first sensor
+    CHECK(cfg.probe_count == 2);
+    CHECK(cfg.probes[0].pin_id == D7);
+    CHECK(cfg.probes[0].type_id == DHT22);
+    CHECK(cfg.probes[0].interval == 20000);
+    CHECK(cfg.probes[0].delta_t == 3);
+    CHECK(cfg.probes[1].pin_id == D1);
+    CHECK(cfg.probes[1].type_id == DHT21);
+    CHECK(cfg.probes[1].interval == 45000);
+    CHECK(cfg.probes[1].delta_h == 6);
+
+    delete data;
+}
+
+static void testOptionalDefaults()
+{
+sensorconfig cfg;
+SensorCfgData *data = new SensorCfgData("/sensorcfg.json", true);
+
+    CHECK(data->parseFile());
+    CHECK(data->getSensor(cfg));
+    CHECK(cfg.type_id == DHT22);
+    CHECK(cfg.pin_id == D6);
+    CHECK(cfg.interval == 60000);
+    CHECK(cfg.report_id == REPORT_ALL);
+    // not in the file, the defaults are kept
+    CHECK(cfg.retries == 2);
+    CHECK(cfg.warmup == 2000);
+    CHECK(cfg.backoff == 2);
+    CHECK(cfg.interval_min == 0);
+    CHECK(cfg.median == 0);
+    CHECK(cfg.derived == false);
+    CHECK(cfg.probe_count == 0);
+
+    delete data;
+}
+
+static void testOtherCfg()
+{
+String err;
+clisrvcfg srv;
+mcastcfg mcast;
+
+    AppCfgData *app = new AppCfgData("/appcfg.json");
+    CHECK(app->getError(err) == 0);
+    CHECK(app->parseFile());
+    CHECK(app->getDebugMute() == true);
+    CHECK(app->getSensorConfig() == "/sensorcfg.json");
+    delete app;
+
+    ClientCfgData *client = new ClientCfgData("/clientcfg.json", true);
+    CHECK(client->parseFile());
+    CHECK(client->getServer("udp1", srv));
+    CHECK(srv.addr == "127.0.0.1");
+    CHECK(srv.port == 54390);
+    CHECK(srv.ipaddr == IPAddress(127, 0, 0, 1));
+    CHECK(client->getServer("log", srv));
+    CHECK(srv.port == 0);
+    delete client;
+
+    MultiCastCfgData *multi = new MultiCastCfgData("/multicfg.json", true);
+    CHECK(multi->parseFile());
+    CHECK(multi->getCfg(mcast));
+    CHECK(mcast.port == 54391);
+    delete multi;
+
+    SensorCfgData *missing = new SensorCfgData("/nothere.json", true);
+    CHECK(missing->getError(err) == CFGDAT_FILENOTFOUND);
+    CHECK(!missing->parseFile());
+    delete missing;
+}
+
+/*
+    The parser that the config classes depend on
+*/
+static void testJson()
+{
+StaticJsonBuffer<JSON_OBJECT_SIZE(4)> buf;
+char good[] = "{\"s\":\"a\\\"b\",\"n\":-12,\"f\":2.5,\"a\":[1,{\"k\":true}]}";
+char bad[] = "{\"s\":\"a\",}";
+
+    JsonObject &json = buf.parseObject(good);
+    CHECK(json.success());
+    CHECK(strcmp((const char *)json["s"], "a\"b") == 0);
+    CHECK((int)json["n"] == -12);
+    CHECK((float)json["f"] == 2.5f);
+    CHECK((int)json["f"] == 2);
+    CHECK(json["a"].size() == 2);
+    CHECK((bool)json["a"][1]["k"] == true);
+    CHECK(!json["a"][2].success());
+    CHECK(!json.containsKey("x"));
+    CHECK((const char *)json["x"] == NULL);
+    CHECK((unsigned long)json["x"] == 0);
+
+    StaticJsonBuffer<JSON_OBJECT_SIZE(1)> buf2;
+    CHECK(!buf2.parseObject(bad).success());
+}
+
+int main()
+{
+    hostSerialMute(true);
+    hostSetFSRoot(HOST_TEST_DATA);
+
+    testJson();
+    testSensorCfg();
+    testOptionalDefaults();
+    testOtherCfg();
+
+    return testResult("config");
+}
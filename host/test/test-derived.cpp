@@ -0,0 +1,108 @@
+/* ************************************************************************ */
+/*
+    test-derived.cpp - compares heatIndex10() and dewPoint10() with the
+    formulas in floating point, DHT::computeHeatIndex() and Magnus, over
+    the range of the tables. The limits are the ones in sensor-derived.h.
+*/
+#include <math.h>
+
+#include "DHT.h"
+#include "sensor-derived.h"
+
+#include "test.h"
+
+// the end of the heat index table, HI_T_MAX in sensor-derived.cpp
+#define HI_T_MAX    560
+
+// the largest errors in C, and the mean
+#define HI_MAX_ERR  0.8f
+#define HI_MEAN_ERR 0.1f
+#define DP_MAX_ERR  0.4f
+#define DP_MEAN_ERR 0.1f
+
+// the Magnus formula, as in derivedBench()
+static float dewPointRef(float t, float rh)
+{
+float gamma = logf(rh / 100) + ((17.62f * t) / (243.12f + t));
+
+    return (243.12f * gamma) / (17.62f - gamma);
+}
+
+static void testHeatIndex()
+{
+DHT dht;
+float err;
+float worst = 0;
+float sum = 0;
+int count = 0;
+
+    for(int16_t t10 = -400; t10 <= HI_T_MAX; t10 += 3)
+    {
+        for(int16_t h10 = 0; h10 <= 1000; h10 += 7)
+        {
+            err = fabsf((heatIndex10(t10, h10, false) / 10.0f) - dht.computeHeatIndex(t10 / 10.0f, h10 / 10.0f, false));
+            CHECK_MSG(err <= HI_MAX_ERR, "heat index off by %.2f C at %d %d", err, t10, h10);
+            worst = fmaxf(worst, err);
+            sum += err;
+            count += 1;
+
+            // F is the C result converted, within rounding
+            err = fabsf((heatIndex10(t10, h10, true) / 10.0f) - dht.computeHeatIndex(DHT::convertCtoF10(t10) / 10.0f, h10 / 10.0f, true));
+            CHECK_MSG(err <= (HI_MAX_ERR * 1.8f) + 0.1f, "heat index off by %.2f F at %d %d", err, t10, h10);
+        }
+    }
+    CHECK_MSG((sum / count) <= HI_MEAN_ERR, "heat index mean error %.3f C", sum / count);
+    fprintf(stderr, "heat index - mean %.3f  max %.2f C\n", sum / count, worst);
+}
+
+static void testDewPoint()
+{
+float err;
+float worst = 0;
+float sum = 0;
+int count = 0;
+
+    for(int16_t t10 = -400; t10 <= 800; t10 += 3)
+    {
+        for(int16_t h10 = 100; h10 <= 1000; h10 += 7)
+        {
+            err = fabsf((dewPoint10(t10, h10, false) / 10.0f) - dewPointRef(t10 / 10.0f, h10 / 10.0f));
+            CHECK_MSG(err <= DP_MAX_ERR, "dew point off by %.2f C at %d %d", err, t10, h10);
+            worst = fmaxf(worst, err);
+            sum += err;
+            count += 1;
+        }
+    }
+    CHECK_MSG((sum / count) <= DP_MEAN_ERR, "dew point mean error %.3f C", sum / count);
+    fprintf(stderr, "dew point  - mean %.3f  max %.2f C\n", sum / count, worst);
+
+    // it's never above the temperature, and saturated air is at it
+    for(int16_t t10 = -400; t10 <= 800; t10 += 10)
+    {
+        CHECK(dewPoint10(t10, 1000, false) == t10);
+        CHECK(dewPoint10(t10, 500, false) < t10);
+    }
+}
+
+/*
+    Past the ends of the tables the nearest edge is used
+*/
+static void testEdges()
+{
+    CHECK(dewPoint10(-600, 500, false) == dewPoint10(-400, 500, false));
+    CHECK(dewPoint10(500, -10, false) == dewPoint10(500, 0, false));
+    CHECK(dewPoint10(500, 1200, false) == dewPoint10(500, 1000, false));
+    CHECK(heatIndex10(700, 500, false) == heatIndex10(HI_T_MAX, 500, false));
+    CHECK(convertFtoC10(320) == 0);
+    CHECK(convertFtoC10(2120) == 1000);
+    CHECK(convertFtoC10(-400) == -400);
+}
+
+int main()
+{
+    testHeatIndex();
+    testDewPoint();
+    testEdges();
+
+    return testResult("derived");
+}
@@ -0,0 +1,59 @@
+/* ************************************************************************ */
+/*
+    test-heap.cpp - the HEAP_LOW status. It's sent once when the free heap
+    drops below the threshold, again only after it has risen above the
+    hysteresis, and it isn't lost when the heap is low before there's a
+    device ID to send it with.
+*/
+#include "test.h"
+
+// the multicast port in test/data/multicfg.json
+#define MCAST_PORT  54391
+
+static int mcast = -1;
+
+// the number of HEAP_LOW messages that arrived
+static int heapLowCount()
+{
+char buf[1500];
+int count = 0;
+
+    while(peerRecv(mcast, buf, sizeof(buf), 50) > 0)
+    {
+        if(strstr(buf, "\"status\":\"HEAP_LOW\"") != NULL) count++;
+    }
+    return count;
+}
+
+int main()
+{
+    mcast = peerOpen(MCAST_PORT);
+    CHECK(mcast >= 0);
+
+    // low before the WiFi is connected, initHeapStats() can't send it
+    hostSetFreeHeap(HEAP_LOW_THRESHOLD - 1000);
+    testSetup();
+    CHECK(devID[0] != '\0');
+
+    // now that there's a device ID it's sent, once
+    updateHeapStats();
+    CHECK(heapLowCount() == 1);
+    updateHeapStats();
+    CHECK(heapLowCount() == 0);
+
+    // within the hysteresis it stays latched
+    hostSetFreeHeap(HEAP_LOW_THRESHOLD + HEAP_LOW_HYSTERESIS);
+    updateHeapStats();
+    hostSetFreeHeap(HEAP_LOW_THRESHOLD - 1000);
+    updateHeapStats();
+    CHECK(heapLowCount() == 0);
+
+    // above it, the next drop is sent
+    hostSetFreeHeap(HEAP_LOW_THRESHOLD + HEAP_LOW_HYSTERESIS + 1);
+    updateHeapStats();
+    hostSetFreeHeap(HEAP_LOW_THRESHOLD - 1000);
+    updateHeapStats();
+    CHECK(heapLowCount() == 1);
+
+    return testResult("heap");
+}
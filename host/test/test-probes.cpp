@@ -0,0 +1,87 @@
+/* ************************************************************************ */
+/*
+    test-probes.cpp - the probe slots have their own driver types. The
+    host build gives the second slot the random walk (see PROBE2_DRIVER
+    in CMakeLists.txt), so the first sensor and the first probe read the
+    simulated DHT and the second probe doesn't.
+*/
+#include <type_traits>
+
+#include <ArduinoJson.h>
+
+#include "sensor-dht.h"
+#include "dht-sim.h"
+
+#include "test.h"
+
+// the port in test/data/clientcfg.json
+#define COLLECTOR_PORT  54390
+
+#define STEP_MS     100
+#define RUN_MS      60000UL
+
+// SOAK_TEST uses the random walk for all of them
+#ifndef SOAK_TEST
+static_assert(!std::is_same<ProbeDriver1, ProbeDriver2>::value, "the probe slots should have different drivers");
+#endif
+
+int main()
+{
+char buf[1500];
+int collector = peerOpen(COLLECTOR_PORT);
+int packets = 0;
+int found[3] = { 0, 0, 0 };
+bool walked = false;
+float first = 0;
+
+    CHECK(collector >= 0);
+
+    hostSetMillis(1000);
+    dhtSimSet(215, 450);
+    testSetup();
+    CHECK(setupSensor("/sensorcfg-probes.json"));
+
+    for(unsigned long elapsed = 0; elapsed < RUN_MS; elapsed += STEP_MS)
+    {
+        sendSensorData();
+        hostAdvance(STEP_MS);
+
+        while(peerRecv(collector, buf, sizeof(buf), 0) > 0)
+        {
+            StaticJsonBuffer<400> json;
+            JsonObject &r = json.parseObject(buf);
+
+            CHECK_MSG(r.success(), "not JSON - %s", buf);
+            packets += 1;
+            if(r.containsKey("t"))
+            {
+                CHECK((float)r["t"] == 21.5f);
+                found[0] += 1;
+            }
+            JsonVariant p = r["p"];
+            for(int ix = 0; ix < (int)p.size(); ix++)
+            {
+                int num = p[ix][0];
+                float t = p[ix][1];
+
+                CHECK_MSG((num == 1) || (num == 2), "probe %d", num);
+                if((num < 1) || (num > 2)) continue;
+                found[num] += 1;
+                // the DHT, or the walk from 21.0 C
+                if(num == 1) CHECK(t == 21.5f);
+                else
+                {
+                    CHECK_MSG((t >= 15.0f) && (t <= 27.0f), "probe 2 t = %.1f", t);
+                    if(found[2] == 1) first = t;
+                    else if(t != first) walked = true;
+                }
+            }
+        }
+    }
+    // every sensor was read about once an interval, in the same packets
+    CHECK_MSG(packets >= 5, "%d packets", packets);
+    for(int ix = 0; ix < 3; ix++) CHECK_MSG(found[ix] >= 5, "sensor %d read %d times", ix, found[ix]);
+    CHECK(walked);
+
+    return testResult("probes");
+}
@@ -0,0 +1,200 @@
+/* ************************************************************************ */
+/*
+    test-rollover.cpp - runs the sensor schedule, the "STATS" windows and
+    the log shipper on the virtual clock while it rolls over, and checks
+    their timing on both sides of it.
+
+    The host's millis() wraps at 32 bits like the device's, the clock is
+    started just before it does. With SOAK_TEST the application's clock
+    is the one in esp8266-clock.cpp, it starts before the wrap by itself
+    and moves SOAK_STEP_MS each time soakTick() is called.
+
+        test-rollover           readings ("ALL") and the log shipper
+        test-rollover stats     "STATS" summaries
+*/
+#include <vector>
+
+#include <ArduinoJson.h>
+
+#include "sensor-dht.h"
+#include "dht-sim.h"
+#include "esp8266-log.h"
+#include "esp8266-logship.h"
+
+#include "test.h"
+
+// the ports in test/data/clientcfg-log.json
+#define COLLECTOR_PORT  54390
+#define LOG_PORT        54392
+
+#ifdef SOAK_TEST
+#define STEP_MS     SOAK_STEP_MS
+#define START_MS    SOAK_START_MS
+#else
+// milliseconds per pass through the loop
+#define STEP_MS     100
+// the clock starts this far before it rolls over
+#define START_MS    120000UL
+#endif
+// and runs until this long after it
+#define RUN_MS      (START_MS + 180000UL)
+
+#define INTERVAL    10000UL
+
+static int collector = -1;
+static int logs = -1;
+
+// when each packet arrived, relative to the start
+static std::vector<unsigned long> dataTimes;
+static std::vector<long> dataSeq;
+static std::vector<int> dataCount;
+static std::vector<unsigned long> logTimes;
+
+static unsigned long started = 0;
+
+/*
+    Collect what has arrived, the time is when it was received
+*/
+static void receive()
+{
+char buf[1500];
+
+    while(peerRecv(collector, buf, sizeof(buf), 0) > 0)
+    {
+        StaticJsonBuffer<300> json;
+        JsonObject &r = json.parseObject(buf);
+
+        CHECK_MSG(r.success(), "not JSON - %s", buf);
+        dataTimes.push_back(timeSince(appMillis(), started));
+        dataSeq.push_back(r["seq"]);
+        dataCount.push_back(r["n"]);
+    }
+    while(peerRecv(logs, buf, sizeof(buf), 0) > 0) logTimes.push_back(timeSince(appMillis(), started));
+}
+
+/*
+    The loop, without the parts that aren't being tested
+*/
+static void run(unsigned long ms, bool logging)
+{
+static int logCount = 0;
+
+    for(unsigned long elapsed = 0; elapsed < ms; elapsed += STEP_MS)
+    {
+        sendSensorData();
+        // more than the shipper is allowed to send (40 a second), 
+        // each one is different so they aren't counted as repeats
+        if(logging)
+        {
+            for(int ix = 0; ix < (int)(STEP_MS / 25); ix++) LOG_WARN("rollover - filler record %d for the log shipper", logCount++);
+        }
+        drainLog();
+        usleep(200);
+        receive();
+        hostAdvance(STEP_MS);
+        soakTick();
+    }
+}
+
+/*
+    The readings are an interval apart and are all sent, before, during
+    and after the rollover
+*/
+static void testSchedule()
+{
+unsigned long wrap = START_MS;
+
+    CHECK_MSG(dataTimes.size() >= (RUN_MS / INTERVAL) - 1, "%zu readings", dataTimes.size());
+    CHECK(!dataTimes.empty());
+    if(dataTimes.empty()) return;
+    for(size_t ix = 1; ix < dataTimes.size(); ix++)
+    {
+        unsigned long gap = dataTimes[ix] - dataTimes[ix - 1];
+
+        CHECK_MSG((gap >= INTERVAL) && (gap <= INTERVAL + 2 * STEP_MS), "gap %lu at %lu", gap, dataTimes[ix]);
+        CHECK(dataSeq[ix] == dataSeq[ix - 1] + 1);
+    }
+    // readings were sent on both sides of the rollover
+    CHECK((dataTimes.front() < wrap) && (dataTimes.back() > wrap));
+}
+
+/*
+    No more than the rate and burst allow in any window, and it keeps
+    sending at the rate after the rollover
+*/
+static void testLogShip()
+{
+const unsigned long window = 10000;
+unsigned long after = 0;
+
+    for(size_t ix = 0; ix < logTimes.size(); ix++)
+    {
+        size_t count = 0;
+
+        for(size_t iy = ix; (iy < logTimes.size()) && ((logTimes[iy] - logTimes[ix]) < window); iy++) count++;
+        CHECK_MSG(count <= (LOGSHIP_RATE * window / 1000) + LOGSHIP_BURST, "%zu packets in %lums at %lu", count, window, logTimes[ix]);
+        if(logTimes[ix] > START_MS) after += 1;
+    }
+    // the rate limit didn't stall at the rollover
+    unsigned long expected = LOGSHIP_RATE * (RUN_MS - START_MS) / 1000;
+    CHECK_MSG(after >= expected - 2, "%lu packets after the rollover, expected %lu", after, expected);
+}
+
+/*
+    The summaries are an interval apart and each one covers a full
+    window of samples
+*/
+static void testStats()
+{
+// a sample is taken on the first step after it's due
+unsigned long sample = ((SensorDriver::minInterval() + STEP_MS - 1) / STEP_MS) * STEP_MS;
+// and a window ends with a sample
+unsigned long window = ((INTERVAL + sample - 1) / sample) * sample;
+
+    CHECK_MSG(dataTimes.size() >= (RUN_MS / window) - 2, "%zu summaries", dataTimes.size());
+    CHECK(!dataTimes.empty());
+    if(dataTimes.empty()) return;
+    for(size_t ix = 0; ix < dataTimes.size(); ix++)
+    {
+        unsigned long gap = (ix > 0 ? dataTimes[ix] - dataTimes[ix - 1] : INTERVAL);
+
+        CHECK_MSG((gap >= INTERVAL) && (gap <= INTERVAL + sample + STEP_MS), "gap %lu at %lu", gap, dataTimes[ix]);
+        CHECK_MSG((dataCount[ix] >= (int)(INTERVAL / sample)) && (dataCount[ix] <= (int)(INTERVAL / sample) + 1),
+                  "n = %d at %lu", dataCount[ix], dataTimes[ix]);
+    }
+    CHECK((dataTimes.front() < START_MS) && (dataTimes.back() > START_MS));
+}
+
+int main(int argc, char *argv[])
+{
+bool stats = ((argc > 1) && (strcmp(argv[1], "stats") == 0));
+
+    hostSetMillis((uint32_t)(0UL - START_MS));
+    started = appMillis();
+
+    dhtSimSet(215, 450);
+    testSetup();
+
+    collector = peerOpen(COLLECTOR_PORT);
+    logs = peerOpen(LOG_PORT);
+    CHECK((collector >= 0) && (logs >= 0));
+
+    if(stats)
+    {
+        CHECK(setSensorReport("STATS"));
+        setSensorInterval(INTERVAL);
+        run(RUN_MS, false);
+        testStats();
+    }
+    else
+    {
+        CHECK(setupClient("/clientcfg-log.json"));
+        CHECK(initLogShip());
+        setSensorInterval(INTERVAL);
+        run(RUN_MS, true);
+        testSchedule();
+        testLogShip();
+        CHECK(getLogDropped() > 0);
+    }
+    return testResult(stats ? "rollover stats" : "rollover");
+}
@@ -0,0 +1,215 @@
+/* ************************************************************************ */
+/*
+    test-soak.cpp - runs the sketch's setup() and loop() for months of
+    virtual time, the clock rolls over at 32 bits more than once. It
+    checks that the readings are reported an interval apart, that the
+    heartbeat comes 4 intervals after the last packet, that the sequence
+    numbers only go up and that the heap doesn't grow.
+
+    The report mode is "CHG" and the simulated reading is changed every
+    few intervals, the heartbeat sends it in between. With SOAK_TEST the
+    sensor is the random walk and loop() moves the clock.
+*/
+#include <malloc.h>
+
+#include <atomic>
+#include <thread>
+
+#include "../../esp8266-dht-udp.ino"
+#include "dht-sim.h"
+
+#include "test.h"
+
+// the ports in test/data/clientcfg.json and multicfg.json
+#define COLLECTOR_PORT  54390
+#define MCAST_PORT      54391
+
+#ifdef SOAK_TEST
+// loop() moves the clock SOAK_STEP_MS
+#define STEP_MS     SOAK_STEP_MS
+#define START_MS    SOAK_START_MS
+#else
+// milliseconds per pass through loop()
+#define STEP_MS     5000
+// the clock starts this far before it rolls over
+#define START_MS    600000UL
+#endif
+
+#define DAY_MS      86400000ULL
+#define RUN_DAYS    100
+
+// the interval in test/data/sensorcfg.json
+#define INTERVAL    60000UL
+// the reading is changed this many intervals apart
+#define CHANGE_EVERY    10
+// bytes that the heap may grow by after the first day
+#define HEAP_SLACK  256
+
+static int collector = -1;
+static int mcast = -1;
+
+// the time since the loop started, the clock itself is 32 bits
+static uint64_t elapsed = 0;
+
+static unsigned long packets = 0;
+static unsigned long reports = 0;
+static unsigned long beats = 0;
+static long lastRseq = 0;
+static long lastSeq = 0;
+// when the last two data packets arrived
+static uint64_t lastData = 0;
+static uint64_t prevData = 0;
+static uint64_t firstReport = 0;
+
+static std::atomic<bool> answering(false);
+
+/*
+    Answer the REQ_IP that setup() sends, ready() waits for it. Each
+    one is answered, the device opens the port again when it repeats
+    the request and an earlier reply can be lost.
+*/
+static void answerReqIP()
+{
+char buf[1500];
+const char *reply = "{\"reply\":\"IP_ADDR\",\"ip\":\"127.0.0.1\",\"port\":54390}";
+
+    while(answering)
+    {
+        if(peerRecv(mcast, buf, sizeof(buf), 10) <= 0) continue;
+        if(strstr(buf, "\"status\":\"REQ_IP\"") != NULL) peerSend(mcast, UDP_CMD_PORT, reply, strlen(reply));
+    }
+}
+
+static long member(const char *buf, const char *name)
+{
+const char *p = strstr(buf, name);
+
+    return (p == NULL ? -1 : atol(p + strlen(name)));
+}
+
+/*
+    What was sent during this pass through the loop. A HEAP message
+    is a heartbeat, it follows the heartbeat's reading. The checks
+    are made as it goes, nothing is kept (it would be on the heap).
+*/
+static void receive()
+{
+char buf[1500];
+bool data = false;
+bool beat = false;
+
+    while(peerRecv(collector, buf, sizeof(buf), 0) > 0)
+    {
+        long rseq = member(buf, "\"rseq\":");
+        long seq = member(buf, "\"seq\":");
+
+        CHECK_MSG((packets == 0) || (rseq == lastRseq + 1), "rseq %ld after %ld", rseq, lastRseq);
+        CHECK_MSG(seq > lastSeq, "seq %ld after %ld", seq, lastSeq);
+        CHECK_MSG((packets == 0) || ((elapsed - lastData) <= heartrate + STEP_MS),
+                  "nothing sent for %llu ms on day %llu", (unsigned long long)(elapsed - lastData), (unsigned long long)(elapsed / DAY_MS));
+        lastRseq = rseq;
+        lastSeq = seq;
+        prevData = lastData;
+        lastData = elapsed;
+        packets += 1;
+        data = true;
+    }
+    while(peerRecv(mcast, buf, sizeof(buf), 0) > 0)
+    {
+        if(strstr(buf, "\"status\":\"HEAP\"") != NULL) beat = true;
+    }
+
+    if(beat)
+    {
+        CHECK_MSG(data, "a heartbeat without a reading on day %llu", (unsigned long long)(elapsed / DAY_MS));
+        CHECK_MSG((packets < 2) || (((elapsed - prevData) >= heartrate) && ((elapsed - prevData) <= heartrate + STEP_MS)),
+                  "heartbeat %llu ms after the last packet", (unsigned long long)(elapsed - prevData));
+        beats += 1;
+    }
+    else if(data)
+    {
+        // the first is the reading from setup(), it's sent by the
+        // first loop(). The rest are on the sensor's schedule.
+        if(reports <= 1) firstReport = elapsed;
+        CHECK_MSG(((elapsed - firstReport) % INTERVAL) == 0, "a report %llu ms off the interval",
+                  (unsigned long long)((elapsed - firstReport) % INTERVAL));
+        reports += 1;
+    }
+}
+
+static size_t heapUsed()
+{
+    return mallinfo2().uordblks;
+}
+
+int main()
+{
+unsigned long last;
+int wraps = 0;
+int changes = 0;
+size_t heapBase = 0;
+size_t heapMax = 0;
+
+    collector = peerOpen(COLLECTOR_PORT);
+    mcast = peerOpen(MCAST_PORT);
+    CHECK((collector >= 0) && (mcast >= 0));
+
+    hostSerialMute(true);
+    hostSetFSRoot(HOST_TEST_DATA);
+    hostSetMillis((uint32_t)(0UL - START_MS));
+    dhtSimSet(215, 450);
+
+    answering = true;
+    std::thread server(answerReqIP);
+    setup();
+    answering = false;
+    server.join();
+    CHECK(getServerIP() == IPAddress(127, 0, 0, 1));
+    CHECK(setSensorReport("CHG"));
+    CHECK(heartrate == INTERVAL * 4);
+
+    // what setup() sent
+    receive();
+    packets = reports = beats = 0;
+
+    last = appMillis();
+    for(elapsed = 0; elapsed < RUN_DAYS * DAY_MS; elapsed += STEP_MS)
+    {
+        loop();
+        receive();
+
+        if((elapsed % (CHANGE_EVERY * INTERVAL)) == 0)
+        {
+            dhtSimSet(((changes++ & 1) ? 215 : 260), 450);
+        }
+        // the first day's allocations are done once
+        if((elapsed >= DAY_MS) && ((elapsed % DAY_MS) == 0))
+        {
+            if(elapsed == DAY_MS) heapBase = heapUsed();
+            heapMax = max(heapMax, heapUsed());
+            if(getenv("HEAPDBG")) fprintf(stderr, "day %llu heap %zu\n", elapsed / DAY_MS, heapUsed());
+        }
+#ifndef SOAK_TEST
+        hostAdvance(STEP_MS);
+#endif
+        if(appMillis() < last) wraps += 1;
+        last = appMillis();
+    }
+
+    fprintf(stderr, "%d days - %d rollovers, %lu packets, %lu reports, %lu heartbeats, heap %zu to %zu\n",
+            RUN_DAYS, wraps, packets, reports, beats, heapBase, heapMax);
+
+    CHECK(wraps >= 2);
+    CHECK_MSG((elapsed - lastData) <= heartrate + STEP_MS, "nothing sent for the last %llu ms", (unsigned long long)(elapsed - lastData));
+    // a heartbeat every 4 intervals at least
+    CHECK(packets >= (RUN_DAYS * DAY_MS) / (INTERVAL * 4));
+    CHECK((reports > 0) && (beats > 0));
+#ifndef SOAK_TEST
+    // each change is reported, and beats twice before the next one
+    CHECK_MSG(reports >= (unsigned long)changes - 1, "%lu reports, %d changes", reports, changes);
+    CHECK_MSG(beats >= 2 * ((unsigned long)changes - 1), "%lu heartbeats, %d changes", beats, changes);
+#endif
+    CHECK_MSG(heapMax <= heapBase + HEAP_SLACK, "the heap grew from %zu to %zu", heapBase, heapMax);
+
+    return testResult("soak");
+}
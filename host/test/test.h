@@ -0,0 +1,105 @@
+/* ************************************************************************ */
+/*
+    test.h - checks for the host tests. A failed check prints where it is
+    and the test carries on, testResult() is returned from main(). The
+    peer functions are a UDP socket that stands in for the server.
+*/
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <Arduino.h>
+
+#include "esp8266-ino.h"
+#include "esp8266-heap.h"
+
+static int testFailures = 0;
+static int testChecks = 0;
+
+#define CHECK(cond) do { \
+    testChecks += 1; \
+    if(!(cond)) { testFailures += 1; fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); } \
+} while(0)
+
+#define CHECK_MSG(cond, ...) do { \
+    testChecks += 1; \
+    if(!(cond)) { testFailures += 1; fprintf(stderr, "%s:%d: CHECK(%s) failed - ", __FILE__, __LINE__, #cond); \
+                  fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); } \
+} while(0)
+
+static inline int testResult(const char *name)
+{
+    fprintf(stderr, "%s - %d checks, %d failed\n", name, testChecks, testFailures);
+    return (testFailures == 0 ? 0 : 1);
+}
+
+/* ************************************************************************ */
+/*
+    A UDP peer on 127.0.0.1, it stands in for the server. Port 0 picks
+    any free port.
+*/
+static inline int peerOpen(uint16_t port)
+{
+struct sockaddr_in addr;
+int sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        perror("peerOpen()");
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static inline void peerSend(int sock, uint16_t port, const void *data, size_t len)
+{
+struct sockaddr_in addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sendto(sock, data, len, 0, (struct sockaddr *)&addr, sizeof(addr));
+}
+
+/*
+    Wait up to `ms` for a packet, it's returned as a string. Returns the
+    length, or -1 if nothing arrived.
+*/
+static inline int peerRecv(int sock, char *buf, size_t size, int ms)
+{
+struct pollfd pfd = { sock, POLLIN, 0 };
+
+    if(poll(&pfd, 1, ms) <= 0) return -1;
+    ssize_t len = recv(sock, buf, size - 1, 0);
+    if(len < 0) return -1;
+    buf[len] = '\0';
+    return (int)len;
+}
+
+/* ************************************************************************ */
+/*
+    Start the application the way setup() does, without waiting for a
+    server to answer REQ_IP. The config files are in test/data.
+*/
+static inline void testSetup()
+{
+    hostSerialMute(true);
+    hostSetFSRoot(HOST_TEST_DATA);
+    setupStart();
+    initHeapStats();
+    setupConfig();
+    setupInit();
+}
@@ -5,8 +5,17 @@ written by Adafruit Industries
 */
 
 #include "DHT.h"
+// added : the application's time source, see esp8266-clock.h
+#include "../applib/esp8266-clock.h"
 
-#define MIN_INTERVAL 2000
+// https://github.com/jxmot/esp8266-dht-udp : try a little longer, begin()
+// back-dates the last read by this much so the first read isn't skipped
+//#define MIN_INTERVAL 2000
+#define MIN_INTERVAL 2500
+
+#ifdef LOOP_PROFILE
+uint32_t InterruptLock::maxCycles = 0;
+#endif
 
 DHT::DHT(uint8_t pin, uint8_t type, uint8_t count) {
   _pin = pin;
@@ -111,6 +120,36 @@ float DHT::readHumidity(bool force) {
   return f;
 }
 
+// added : read the temperature and humidity together as integer tenths
+// (a degree or percent) without using floating point. The DHT11 only
+// reports whole numbers, they're multiplied by 10.
+//boolean S == Scale.  True == Fahrenheit; False == Celcius
+bool DHT::readTenths(int16_t &t, int16_t &h, bool S, bool force) {
+  if (!read(force)) {
+    return false;
+  }
+  switch (_type) {
+  case DHT11:
+    t = data[2] * 10;
+    h = data[0] * 10;
+    break;
+  case DHT22:
+  case DHT21:
+    t = ((data[2] & 0x7F) << 8) | data[3];
+    if (data[2] & 0x80) {
+      t = -t;
+    }
+    h = (data[0] << 8) | data[1];
+    break;
+  default:
+    return false;
+  }
+  if (S) {
+    t = convertCtoF10(t);
+  }
+  return true;
+}
+
 //boolean isFahrenheit: True == Fahrenheit; False == Celcius
 float DHT::computeHeatIndex(float temperature, float percentHumidity, bool isFahrenheit) {
   // Using both Rothfusz and Steadman's equations
@@ -146,10 +185,8 @@ float DHT::computeHeatIndex(float temperature, float percentHumidity, bool isFah
 boolean DHT::read(bool force) {
   // Check if sensor was read less than two seconds ago and return early
   // to use last reading.
-  uint32_t currenttime = millis();
-// https://github.com/jxmot/esp8266-dht-udp : try a little longer
-//  if (!force && ((currenttime - _lastreadtime) < 2000)) {
-  if (!force && ((currenttime - _lastreadtime) < 2500)) {
+  uint32_t currenttime = appMillis();
+  if (!force && ((currenttime - _lastreadtime) < MIN_INTERVAL)) {
     return _lastresult; // return last correct measurement
   }
   _lastreadtime = currenttime;
@@ -157,6 +194,11 @@ boolean DHT::read(bool force) {
   // Reset 40 bits of received data to zero.
   data[0] = data[1] = data[2] = data[3] = data[4] = 0;
 
+// added : the simulated line needs no start signal
+#ifdef DHT_SIM
+  dhtSimStart(_type);
+#else
+
   // Send start signal.  See DHT datasheet for full signal diagram:
   //   http://www.adafruit.com/datasheets/Digital%20humidity%20and%20temperature%20sensor%20AM2302.pdf
 
@@ -169,13 +211,17 @@ boolean DHT::read(bool force) {
   pinMode(_pin, OUTPUT);
   digitalWrite(_pin, LOW);
   delay(20);
+#endif
 
   uint32_t cycles[80];
+  // added : the time taken to receive the reading
+  uint32_t started = ESP.getCycleCount();
   {
     // Turn off interrupts temporarily because the next sections are timing critical
     // and we don't want any interruptions.
     InterruptLock lock;
 
+#ifndef DHT_SIM
     // End the start signal by setting data line high for 40 microseconds.
     digitalWrite(_pin, HIGH);
     delayMicroseconds(40);
@@ -183,17 +229,22 @@ boolean DHT::read(bool force) {
     // Now start reading the data line to get the value from the DHT sensor.
     pinMode(_pin, INPUT_PULLUP);
     delayMicroseconds(10);  // Delay a bit to let sensor pull data line low.
+#endif
 
     // First expect a low signal for ~80 microseconds followed by a high signal
     // for ~80 microseconds again.
     if (expectPulse(LOW) == 0) {
       DEBUG_PRINTLN(F("DHT: Timeout waiting for start signal low pulse."));
+      _diag.startlow++;
       _lastresult = false;
+      _lasterror = DHT_ERR_TIMEOUT;
       return _lastresult;
     }
     if (expectPulse(HIGH) == 0) {
       DEBUG_PRINTLN(F("DHT: Timeout waiting for start signal high pulse."));
+      _diag.starthigh++;
       _lastresult = false;
+      _lasterror = DHT_ERR_TIMEOUT;
       return _lastresult;
     }
 
@@ -210,6 +261,7 @@ boolean DHT::read(bool force) {
       cycles[i+1] = expectPulse(HIGH);
     }
   } // Timing critical code is now complete.
+  _diag.lastus = (ESP.getCycleCount() - started) / clockCyclesPerMicrosecond();
 
   // Inspect pulses and determine which ones are 0 (high state cycle count < low
   // state cycle count), or 1 (high state cycle count > low state cycle count).
@@ -218,9 +270,14 @@ boolean DHT::read(bool force) {
     uint32_t highCycles = cycles[2*i+1];
     if ((lowCycles == 0) || (highCycles == 0)) {
       DEBUG_PRINTLN(F("DHT: Timeout waiting for pulse."));
+      _diag.bittimeout++;
       _lastresult = false;
+      _lasterror = DHT_ERR_TIMEOUT;
       return _lastresult;
     }
+    // added : count the bit's high/low ratio, in quarters
+    uint32_t bin = (highCycles * 4) / lowCycles;
+    _diag.ratio[(bin < DHT_RATIO_BINS) ? bin : (DHT_RATIO_BINS - 1)]++;
     data[i/8] <<= 1;
     // Now compare the low and high cycle times to see if the bit is a 0 or 1.
     if (highCycles > lowCycles) {
@@ -242,12 +299,16 @@ boolean DHT::read(bool force) {
 
   // Check we read 40 bits and that the checksum matches.
   if (data[4] == ((data[0] + data[1] + data[2] + data[3]) & 0xFF)) {
+    _diag.good++;
     _lastresult = true;
+    _lasterror = DHT_ERR_NONE;
     return _lastresult;
   }
   else {
     DEBUG_PRINTLN(F("DHT: Checksum failure!"));
+    _diag.checksum++;
     _lastresult = false;
+    _lasterror = DHT_ERR_CHECKSUM;
     return _lastresult;
   }
 }
@@ -273,7 +334,7 @@ uint32_t DHT::expectPulse(bool level) {
   // Otherwise fall back to using digitalRead (this seems to be necessary on ESP8266
   // right now, perhaps bugs in direct port access functions?).
   #else
-    while (digitalRead(_pin) == level) {
+    while (DHT_PIN_READ(_pin) == level) {
       if (count++ >= _maxcycles) {
         return 0; // Exceeded timeout, fail.
       }
@@ -12,6 +12,18 @@ written by Adafruit Industries
  #include "WProgram.h"
 #endif
 
+// added : LOOP_PROFILE enables timing of the interrupts-off window
+#include "../applib/prof-defs.h"
+// added : DHT_SIM replaces the data line with a simulation
+#include "../applib/dht-sim.h"
+
+// added : the data line is read with DHT_PIN_READ()
+#ifdef DHT_SIM
+  #define DHT_PIN_READ(pin) dhtSimRead()
+#else
+  #define DHT_PIN_READ(pin) digitalRead(pin)
+#endif
+
 
 // Uncomment to enable printing out nice debug messages.
 //#define DHT_DEBUG
@@ -34,6 +46,29 @@ written by Adafruit Industries
 #define DHT21 21
 #define AM2301 21
 
+// added : why the last read failed, see lastError()
+#define DHT_ERR_NONE      0
+#define DHT_ERR_TIMEOUT   1
+#define DHT_ERR_CHECKSUM  2
+
+// added : read diagnostics, see diag(). Each bit's high pulse is 
+// compared to its low pulse, a '0' is about 0.5 of it and a '1' about 
+// 1.4. The ratios are counted in quarters, bins 3 and 4 (0.75 to 1.25)
+// are the bits that were close to being decoded wrong.
+#define DHT_RATIO_BINS    8
+#define DHT_RATIO_MARGIN  3
+
+class DHTDiag {
+  public:
+   uint32_t good = 0;
+   uint32_t startlow = 0;     // no start signal low pulse
+   uint32_t starthigh = 0;    // no start signal high pulse
+   uint32_t bittimeout = 0;   // a timeout in one of the 40 bits
+   uint32_t checksum = 0;
+   uint32_t lastus = 0;       // microseconds to receive the last reading
+   uint32_t ratio[DHT_RATIO_BINS] = {0};
+};
+
 
 class DHT {
   public:
@@ -49,6 +84,17 @@ class DHT {
    float computeHeatIndex(float temperature, float percentHumidity, bool isFahrenheit=true);
    float readHumidity(bool force=false);
    boolean read(bool force=false);
+// added : integer readings in tenths
+   bool readTenths(int16_t &t, int16_t &h, bool S=false, bool force=false);
+// added : DHT_ERR_TIMEOUT or DHT_ERR_CHECKSUM after a failed read
+   uint8_t lastError(void) { return _lasterror; }
+// added : the read diagnostics since begin() or clearDiag()
+   const DHTDiag &diag(void) { return _diag; }
+   void clearDiag(void) { _diag = DHTDiag(); }
+   static inline int16_t convertCtoF10(int16_t c) {
+     // tenths of a degree C to tenths of a degree F, rounded
+     return ((c * 9) + (c < 0 ? -2 : 2)) / 5 + 320;
+   }
 
  private:
   uint8_t data[5];
@@ -59,7 +105,9 @@ class DHT {
     uint8_t _bit, _port;
   #endif
   uint32_t _lastreadtime, _maxcycles;
-  bool _lastresult;
+  bool _lastresult = false;
+  uint8_t _lasterror = DHT_ERR_NONE;
+  DHTDiag _diag;
 
   uint32_t expectPulse(bool level);
 
@@ -69,11 +117,26 @@ class InterruptLock {
   public:
    InterruptLock() {
     noInterrupts();
+#ifdef LOOP_PROFILE
+    _start = ESP.getCycleCount();
+#endif
    }
    ~InterruptLock() {
+#ifdef LOOP_PROFILE
+    uint32_t cycles = ESP.getCycleCount() - _start;
+    if (cycles > maxCycles) {
+      maxCycles = cycles;
+    }
+#endif
     interrupts();
    }
+#ifdef LOOP_PROFILE
+   // the longest time (in CPU cycles) that interrupts were disabled
+   static uint32_t maxCycles;
 
+ private:
+   uint32_t _start;
+#endif
 };
 
 #endif
@@ -10,7 +10,7 @@
 
 
 // these are known, but not referenced in the client application
-String ClientCfgData::labels[] = {"udp1","udp2","END"};
+String ClientCfgData::labels[] = {"udp1","udp2","log","END"};
 
 //////////////////////////////////////////////////////////////////////////////
 /*
@@ -42,7 +42,7 @@ void ClientCfgData::parseJSON(std::unique_ptr<char[]>& buf)
     // be modified accordingly -
     //
     //      https://arduinojson.org/assistant/
-    const size_t bufferSize = (3 * JSON_OBJECT_SIZE(2)) + 68;
+    const size_t bufferSize = JSON_OBJECT_SIZE(3) + (3 * JSON_OBJECT_SIZE(2)) + 100;
     StaticJsonBuffer<bufferSize> jsonBuffer;
 
     JsonObject& json = jsonBuffer.parseObject(buf.get());
@@ -74,7 +74,7 @@ bool ClientCfgData::getServer(String label, clisrvcfg &cfgout)
 {
 bool bRet = false;
 
-    for(int ix = 0; (ix < MAX_SRVCFG) && !bRet; ix++)
+    for(int ix = 0; (ix < MAX_SRVCFG) && (configs[ix] != NULL) && !bRet; ix++)
     {
         if(configs[ix]->label == label)
         {
@@ -9,6 +9,24 @@
 #include "SensorCfgData.h"
 #include <ArduinoJson.h>
 
+#include "../adafruit/DHT.h"
+
+//////////////////////////////////////////////////////////////////////////////
+/*
+    One entry of the "sensors" array, the missing settings are
+    copied from the first sensor's (`first`).
+*/
+static void parseProbe(JsonObject &json, int ix, const sensorconfig &first, probeconfig &probe)
+{
+    probe.pin = (json["sensors"][ix]["pin"].success() ? String((const char *)json["sensors"][ix]["pin"]) : first.pin);
+    probe.type = (json["sensors"][ix]["type"].success() ? String((const char *)json["sensors"][ix]["type"]) : first.type);
+    probe.interval = (json["sensors"][ix]["interval"].success() ? (unsigned long)json["sensors"][ix]["interval"] : first.interval);
+    probe.delta_t = (json["sensors"][ix]["delta_t"].success() ? (int)json["sensors"][ix]["delta_t"] : first.delta_t);
+    probe.delta_h = (json["sensors"][ix]["delta_h"].success() ? (int)json["sensors"][ix]["delta_h"] : first.delta_h);
+    probe.pin_id = SensorCfgData::parsePin(probe.pin);
+    probe.type_id = SensorCfgData::parseType(probe.type);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 /*
     Constructor
@@ -37,7 +55,8 @@ void SensorCfgData::parseJSON(std::unique_ptr<char[]>& buf)
     // be modified accordingly -
     //
     //      https://arduinojson.org/assistant/
-    const size_t bufferSize = JSON_OBJECT_SIZE(8) + 95;
+    const size_t bufferSize = JSON_OBJECT_SIZE(22) + JSON_ARRAY_SIZE(SENSOR_MAX) + 
+                              SENSOR_MAX * JSON_OBJECT_SIZE(5) + 380;
     StaticJsonBuffer<bufferSize> jsonBuffer;
 
     JsonObject& json = jsonBuffer.parseObject(buf.get());
@@ -53,9 +72,101 @@ void SensorCfgData::parseJSON(std::unique_ptr<char[]>& buf)
     sensorcfg.scale = String((const char *)json["scale"]);
     sensorcfg.interval = json["interval"];
     sensorcfg.error_interval = json["error_interval"];
+    if(json.containsKey("retries")) sensorcfg.retries = json["retries"];
+    if(json.containsKey("warmup")) sensorcfg.warmup = json["warmup"];
     sensorcfg.report = String((const char *)json["report"]);
     sensorcfg.delta_t = json["delta_t"];
     sensorcfg.delta_h = json["delta_h"];
+    // optional, adaptive sampling is off when they're missing
+    sensorcfg.interval_min = json["interval_min"];
+    sensorcfg.interval_max = json["interval_max"];
+    sensorcfg.slope_t = json["slope_t"];
+    sensorcfg.slope_h = json["slope_h"];
+    if(json.containsKey("backoff")) sensorcfg.backoff = json["backoff"];
+    if(sensorcfg.backoff < 2) sensorcfg.backoff = 2;
+    sensorcfg.stats_sample = json["stats_sample"];
+    sensorcfg.median = json["median"];
+    sensorcfg.max_rate_t = json["max_rate_t"];
+    sensorcfg.max_rate_h = json["max_rate_h"];
+    sensorcfg.ema = json["ema"];
+    sensorcfg.derived = json["derived"];
+
+    // optional, more than one sensor
+    sensorcfg.probe_count = 0;
+    for(int ix = 0; (ix < (int)json["sensors"].size()) && (ix < SENSOR_MAX); ix++)
+    {
+        probeconfig probe;
+
+        parseProbe(json, ix, sensorcfg, probe);
+        if(ix == 0)
+        {
+            sensorcfg.pin = probe.pin;
+            sensorcfg.type = probe.type;
+            sensorcfg.interval = probe.interval;
+            sensorcfg.delta_t = probe.delta_t;
+            sensorcfg.delta_h = probe.delta_h;
+        } else sensorcfg.probes[sensorcfg.probe_count++] = probe;
+    }
+
+    // parse the strings once, now
+    sensorcfg.type_id = parseType(sensorcfg.type);
+    sensorcfg.pin_id = parsePin(sensorcfg.pin);
+    sensorcfg.scale_id = parseScale(sensorcfg.scale);
+    // an unknown report type will report all readings
+    if(!parseReport(sensorcfg.report, sensorcfg.report_id)) sensorcfg.report_id = REPORT_ALL;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/*
+    Parsers for the string settings, these are also used when a setting
+    is changed at run-time.
+*/
+uint8_t SensorCfgData::parseType(String type)
+{
+uint8_t type_id = 0;
+
+    if(type == "DHT22") type_id = DHT22;
+    else if(type == "DHT11") type_id = DHT11;
+    else if(type == "DHT21") type_id = DHT21;
+
+    return type_id;
+}
+
+uint8_t SensorCfgData::parsePin(String pin)
+{
+uint8_t pin_id = 0;
+
+#ifdef ARDUINO_ESP8266_NODEMCU
+    if(pin == "D6") pin_id = D6;
+    else if(pin == "D4") pin_id = D4;
+    // for more than one sensor
+    else if(pin == "D1") pin_id = D1;
+    else if(pin == "D2") pin_id = D2;
+    else if(pin == "D5") pin_id = D5;
+    else if(pin == "D7") pin_id = D7;
+#endif
+#ifdef ARDUINO_ESP8266_ESP01
+    // not configurable, it will be GPIO2
+    pin_id = 2;
+#endif
+    return pin_id;
+}
+
+scaletype SensorCfgData::parseScale(String scale)
+{
+    return (scale == "F" ? SCALE_F : SCALE_C);
+}
+
+bool SensorCfgData::parseReport(String report, reporttype &report_id)
+{
+bool bRet = true;
+
+    if(report == "CHG") report_id = REPORT_CHG;
+    else if(report == "ALL") report_id = REPORT_ALL;
+    else if(report == "STATS") report_id = REPORT_STATS;
+    else bRet = false;
+
+    return bRet;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -12,6 +12,26 @@
 
 #include "ConfigData.h"
 
+// The parsed values of "scale" and "report"
+enum scaletype { SCALE_F = 0, SCALE_C };
+enum reporttype { REPORT_CHG = 0, REPORT_ALL, REPORT_STATS };
+
+// the most sensors on one device, see "sensors" below
+#define SENSOR_MAX 3
+
+// the settings of each additional sensor. Missing settings are
+// copied from the first sensor.
+class probeconfig {
+    public:
+        String pin = "";
+        String type = "";
+        unsigned long interval = 0;
+        int delta_t = 0;
+        int delta_h = 0;
+        uint8_t pin_id = 0;
+        uint8_t type_id = 0;
+};
+
 // Sensor Configuration 
 //
 // NOTE: Don't change the values here, these values are commentary
@@ -26,11 +46,53 @@ class sensorconfig {
         // retry interval when the sensor returns a NaN or
         // some other error
         unsigned long error_interval = 5000;
-        String report = "CHG or ALL";
-        // divided by 10 gives the amount of change in temp
-        // or humidity needed before reporting
+        // quick re-reads of the sensor after a failed read, before
+        // waiting error_interval
+        int retries = 2;
+        // milliseconds from start up to the first reading, the 
+        // sensor needs time to settle after power is applied
+        unsigned long warmup = 2000;
+        String report = "CHG, ALL or STATS";
+        // the amount of change in temp or humidity, in
+        // tenths, needed before reporting
         int delta_t = 1;
         int delta_h = 1;
+        // adaptive sampling, used when interval_min and interval_max
+        // are both set. The interval drops to interval_min when the
+        // temperature or humidity change faster than slope_t or 
+        // slope_h (tenths per minute, 0 = not checked) and grows by
+        // backoff times after each reading that doesn't, up to 
+        // interval_max.
+        unsigned long interval_min = 0;
+        unsigned long interval_max = 0;
+        int slope_t = 0;
+        int slope_h = 0;
+        int backoff = 2;
+        // "STATS" reporting, the interval between readings. One
+        // summary of the readings is sent every `interval`. 0 will
+        // use a tenth of `interval`.
+        unsigned long stats_sample = 0;
+        // the reading filter, see sensor-filter.h. 0 = off
+        int median = 0;
+        int max_rate_t = 0;
+        int max_rate_h = 0;
+        int ema = 0;
+        // add the heat index and dew point to the data messages,
+        // see sensor-derived.h
+        bool derived = false;
+        // more than one sensor, the "sensors" array. Each entry has
+        // a pin, type, interval, delta_t and delta_h. The first
+        // entry replaces the settings above and the rest are kept
+        // here, all of the other settings are shared.
+        probeconfig probes[SENSOR_MAX - 1];
+        uint8_t probe_count = 0;
+
+        // The strings above are parsed when the file is read, 
+        // the sensor code uses these instead.
+        uint8_t type_id = 0;        // DHT22, DHT11 or 0 if unknown
+        uint8_t pin_id = 0;         // the pin number
+        scaletype scale_id = SCALE_F;
+        reporttype report_id = REPORT_CHG;
 };
 
 // Sensor Configuration File Reader/Parser
@@ -52,6 +114,11 @@ class SensorCfgData : public ConfigData {
     public:
         bool getSensor(sensorconfig &cfgout);
 
+        static uint8_t parseType(String type);
+        static uint8_t parsePin(String pin);
+        static scaletype parseScale(String scale);
+        static bool parseReport(String report, reporttype &report_id);
+
     private:
         bool muteDebug;
         sensorconfig sensorcfg;
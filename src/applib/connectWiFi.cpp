@@ -9,6 +9,23 @@
 #include "connectWiFi.h"
 #include "MimicCfgData.h"
 
+void (*connectIdle)() = NULL;
+
+/*
+    Wait for `ms` milliseconds and let the application use the time,
+    stop waiting if `connect` is true and the connection is made.
+*/
+static void connectWait(unsigned long ms, bool connect)
+{
+unsigned long start = millis();
+
+    while(((uint32_t)(millis() - start) < ms) && !(connect && (WiFi.status() == WL_CONNECTED)))
+    {
+        delay(WAITCONNECTED_STEP);
+        if(connectIdle != NULL) connectIdle();
+    }
+}
+
 /*
     Construct the object and connect to the access point. Optionally return
     the current connection information.
@@ -112,7 +129,7 @@ bool ConnectWiFi::connectToAP(const char *ssid, const char *passw)
         // of our connection status...
         for(int x = 0; x < MAX_WAITCONNECTED; x++) 
         {
-            delay(WAITCONNECTED_DELAY);
+            connectWait(WAITCONNECTED_DELAY, true);
             if(WiFi.status() == WL_CONNECTED) 
             {
                 // connected, gather connection info and return
@@ -136,7 +153,7 @@ bool ConnectWiFi::connectToAP(const char *ssid, const char *passw)
         if(currwifi.attempts < MAX_ATTEMPTS) 
         {
             currwifi.attempts += 1;
-            delay(ATTEMPT_DELAY);
+            connectWait(ATTEMPT_DELAY, false);
         } else return(false); // failed to connect
     }
 }
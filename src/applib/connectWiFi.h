@@ -15,6 +15,9 @@
 // the connection status after a delay.
 #define MAX_WAITCONNECTED 5
 #define WAITCONNECTED_DELAY 1000
+// the delays are taken in steps this long, connectIdle is 
+// called after each one
+#define WAITCONNECTED_STEP 50
 
 // Maximum number of attempts to make a
 // connection to the access point.
@@ -49,3 +52,8 @@ class ConnectWiFi {
         conninfo    currwifi;
 };
 
+// optional, called while waiting for the connection so that the
+// application can do some work in the mean time. It must not take
+// more than a few hundred milliseconds.
+extern void (*connectIdle)();
+
@@ -0,0 +1,260 @@
+/* ************************************************************************ */
+/*
+    dht-sim.cpp - a simulated DHT data line, see dht-sim.h
+
+    The waveform follows the DHT22 data sheet. After the start signal the
+    sensor pulls the line low for 80us and releases it for 80us, then each
+    of the 40 bits is a 50us low pulse followed by a high pulse of 26us 
+    for a 0 or 70us for a 1. The last bit is followed by a 50us low pulse
+    and then the line stays high.
+*/
+#include "../adafruit/DHT.h"
+
+#ifdef DHT_SIM
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIM_RESPONSE_US 80
+#define SIM_LOW_US      50
+#define SIM_ZERO_US     26
+#define SIM_ONE_US      70
+// the length of a glitch and of a stall
+#define SIM_GLITCH_US   2
+#define SIM_STALL_US    20
+
+// response (2) + bits (80) + end (1) + a glitch (2)
+#define SIM_MAX_PULSES  85
+
+dhtsimcfg simcfg;
+
+// the values that will be sent
+int16_t sim_t10 = 215;
+int16_t sim_h10 = 450;
+
+// the waveform, pulse lengths in polls. Even numbered pulses
+// are low, odd numbered pulses are high.
+uint16_t simPulses[SIM_MAX_PULSES];
+int simCount = 0;
+int simNext = 0;
+uint16_t simLeft = 0;
+
+uint32_t simRand = 1;
+
+/*
+    A pseudo-random number from 0 to (range - 1), the sequence is 
+    the same each time so that results can be compared.
+*/
+uint32_t simRandom(uint32_t range)
+{
+    simRand = (simRand * 1103515245) + 12345;
+    return (simRand >> 16) % range;
+}
+
+void dhtSimConfig(const dhtsimcfg &cfg)
+{
+    simcfg = cfg;
+}
+
+void dhtSimSet(int16_t t10, int16_t h10)
+{
+    sim_t10 = t10;
+    sim_h10 = h10;
+}
+
+/*
+    Pack the values into the sensor's 5 bytes
+*/
+void simEncode(uint8_t type, uint8_t *data)
+{
+    if(type == DHT11)
+    {
+        data[0] = sim_h10 / 10;
+        data[1] = 0;
+        data[2] = sim_t10 / 10;
+        data[3] = 0;
+    } else {
+        int16_t t10 = (sim_t10 < 0 ? -sim_t10 : sim_t10);
+
+        data[0] = sim_h10 >> 8;
+        data[1] = sim_h10 & 0xff;
+        data[2] = (t10 >> 8) | (sim_t10 < 0 ? 0x80 : 0);
+        data[3] = t10 & 0xff;
+    }
+    data[4] = data[0] + data[1] + data[2] + data[3];
+}
+
+/*
+    Add a pulse, the length is in microseconds. Jitter is applied, 
+    and no pulse is shorter than one poll.
+*/
+void simPulse(int us)
+{
+    if(simcfg.jitter > 0) us += (int)simRandom((simcfg.jitter * 2) + 1) - simcfg.jitter;
+    simPulses[simCount++] = (us > 0 ? us * DHT_SIM_POLLS_PER_US : 1);
+}
+
+/*
+    Build the waveform for the next read
+*/
+void dhtSimStart(uint8_t type)
+{
+uint8_t data[5];
+
+    simEncode(type, data);
+    if(simRandom(100) < simcfg.badsum) data[4] += 1;
+
+    simCount = 0;
+    simPulse(SIM_RESPONSE_US);
+    simPulse(SIM_RESPONSE_US);
+
+    for(int ix = 0; ix < 40; ix++)
+    {
+        bool one = (data[ix / 8] & (0x80 >> (ix % 8))) != 0;
+        // a slow pull-up delays the start of each high pulse
+        simPulse(SIM_LOW_US + simcfg.rise);
+        simPulse((one ? SIM_ONE_US : SIM_ZERO_US) - simcfg.rise);
+    }
+    simPulse(SIM_LOW_US + simcfg.rise);
+
+    // an interrupt while polling, part of one pulse isn't counted
+    if(simRandom(100) < simcfg.stall)
+    {
+        int ix = 2 + simRandom(80);
+        uint16_t lost = SIM_STALL_US * DHT_SIM_POLLS_PER_US;
+        simPulses[ix] = (simPulses[ix] > lost ? simPulses[ix] - lost : 1);
+    }
+
+    // a spike of the opposite level in the middle of one pulse
+    if(simRandom(100) < simcfg.glitch)
+    {
+        int ix = 2 + simRandom(80);
+        uint16_t half = (simPulses[ix] + 1) / 2;
+
+        memmove(&simPulses[ix + 2], &simPulses[ix], (simCount - ix) * sizeof(simPulses[0]));
+        simPulses[ix] = half;
+        simPulses[ix + 1] = SIM_GLITCH_US * DHT_SIM_POLLS_PER_US;
+        simPulses[ix + 2] = (simPulses[ix + 2] > half ? simPulses[ix + 2] - half : 1);
+        simCount += 2;
+    }
+
+    simNext = 0;
+    simLeft = simPulses[0];
+}
+
+/*
+    One poll of the line
+*/
+int dhtSimRead()
+{
+int level;
+
+    // after the last pulse the line is pulled up
+    if(simNext >= simCount) return HIGH;
+
+    level = (simNext & 1 ? HIGH : LOW);
+    if(--simLeft == 0)
+    {
+        if(++simNext < simCount) simLeft = simPulses[simNext];
+    }
+    return level;
+}
+
+#ifdef DHT_SIM_BENCH
+/*
+    Decode DHT_SIM_BENCH_READS random readings and print the results
+*/
+void simBenchStep(DHT &dht, uint8_t type)
+{
+int ok = 0;
+int fail = 0;
+int wrong = 0;
+uint32_t cycles = 0;
+uint32_t start;
+int16_t t10;
+int16_t h10;
+
+    for(int ix = 0; ix < DHT_SIM_BENCH_READS; ix++)
+    {
+        // DHT11 : 0 to 50 C, whole numbers. Others : -20.0 to 60.0 C
+        if(type == DHT11) dhtSimSet(simRandom(51) * 10, simRandom(81) * 10 + 200);
+        else dhtSimSet((int)simRandom(801) - 200, simRandom(1001));
+
+        start = ESP.getCycleCount();
+        bool good = dht.readTenths(t10, h10, false, true);
+        cycles += ESP.getCycleCount() - start;
+
+        if(!good) fail += 1;
+        else if((t10 == sim_t10) && (h10 == sim_h10)) ok += 1;
+        else wrong += 1;
+
+        yield();
+    }
+    Serial.printf("DHT%-2d %6d %4d %5d %6d %6d  %4d %4d %5d  %5lu\n", type,
+                  simcfg.jitter, simcfg.rise, simcfg.stall, simcfg.glitch, simcfg.badsum,
+                  ok, fail, wrong, (unsigned long)(cycles / DHT_SIM_BENCH_READS / clockCyclesPerMicrosecond()));
+}
+
+/*
+    Run the decoder against a range of impairments. "wrong" counts reads
+    that passed the checksum but returned the wrong values.
+*/
+void dhtSimBench()
+{
+const uint8_t types[] = {DHT11, DHT22, DHT21};
+const uint8_t levels[] = {0, 4, 8, 12, 16, 20};
+dhtsimcfg saved = simcfg;
+dhtsimcfg cfg;
+DHT dht;
+
+    Serial.println();
+    Serial.println("dhtSimBench() - " + String(DHT_SIM_BENCH_READS) + " reads per line, us = microseconds per read");
+    Serial.println("type  jitter rise stall glitch badsum    ok fail wrong     us");
+
+    for(unsigned int ix = 0; ix < sizeof(types); ix++)
+    {
+        dht.begin(0, types[ix]);
+        for(unsigned int iy = 0; iy < sizeof(levels); iy++)
+        {
+            cfg = dhtsimcfg();
+            cfg.jitter = levels[iy];
+            dhtSimConfig(cfg);
+            simBenchStep(dht, types[ix]);
+        }
+    }
+
+    dht.begin(0, DHT22);
+    for(unsigned int iy = 1; iy < sizeof(levels); iy++)
+    {
+        cfg = dhtsimcfg();
+        cfg.rise = levels[iy];
+        dhtSimConfig(cfg);
+        simBenchStep(dht, DHT22);
+    }
+
+    cfg = dhtsimcfg();
+    cfg.stall = 100;
+    dhtSimConfig(cfg);
+    simBenchStep(dht, DHT22);
+
+    cfg = dhtsimcfg();
+    cfg.glitch = 100;
+    dhtSimConfig(cfg);
+    simBenchStep(dht, DHT22);
+
+    cfg = dhtsimcfg();
+    cfg.badsum = 100;
+    dhtSimConfig(cfg);
+    simBenchStep(dht, DHT22);
+
+    Serial.println();
+    dhtSimConfig(saved);
+}
+#endif // DHT_SIM_BENCH
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DHT_SIM
@@ -0,0 +1,58 @@
+/* ************************************************************************ */
+/*
+    dht-sim.h - a simulated DHT data line, used for testing the decoder in
+    DHT::read() without a sensor.
+
+    When DHT_SIM is defined the DHT library reads the line with dhtSimRead()
+    instead of digitalRead(). Each call is one poll of the line, the pulse
+    lengths are counted in polls (DHT_SIM_POLLS_PER_US) and not in time, 
+    just as expectPulse() counts them. The waveform for a read is built by
+    dhtSimStart() in the sensor type's format from the values set with 
+    dhtSimSet() and the impairments set with dhtSimConfig().
+
+    When DHT_SIM_BENCH is also defined dhtSimBench() decodes simulated 
+    reads at a range of impairments and prints the error rates and the 
+    time taken, it's called during start up.
+*/
+#pragma once
+
+#include <stdint.h>
+
+// Uncomment to replace the DHT data line with the simulation
+//#define DHT_SIM
+// Uncomment to run the decoder benchmark during start up (needs DHT_SIM)
+//#define DHT_SIM_BENCH
+
+#ifdef DHT_SIM
+// the number of polls of the line per microsecond
+#define DHT_SIM_POLLS_PER_US    4
+// reads per benchmark step
+#define DHT_SIM_BENCH_READS     200
+
+// impairments, applied to every simulated read
+class dhtsimcfg {
+    public:
+        uint8_t jitter = 0;     // +/- microseconds added to every pulse
+        uint8_t rise = 0;       // slow pull-up, microseconds taken from each high pulse
+        uint8_t stall = 0;      // percent of reads with a stall in one pulse
+        uint8_t glitch = 0;     // percent of reads with a short spike in one pulse
+        uint8_t badsum = 0;     // percent of reads with a bad checksum
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void dhtSimConfig(const dhtsimcfg &);
+extern void dhtSimSet(int16_t t10, int16_t h10);
+extern void dhtSimStart(uint8_t type);
+extern int dhtSimRead();
+#ifdef DHT_SIM_BENCH
+extern void dhtSimBench();
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DHT_SIM
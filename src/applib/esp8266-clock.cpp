@@ -0,0 +1,34 @@
+/* ************************************************************************ */
+/*
+    esp8266-clock.cpp - the virtual clock used by SOAK_TEST, see 
+    esp8266-clock.h
+*/
+#include "esp8266-clock.h"
+
+#ifdef SOAK_TEST
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+unsigned long soakClock = (uint32_t)(0UL - SOAK_START_MS);
+
+unsigned long appMillis()
+{
+    return soakClock;
+}
+
+/*
+    Called at the start of each pass through loop(), it wraps at 32 
+    bits like millis() on the device
+*/
+void soakTick()
+{
+    soakClock = (uint32_t)(soakClock + SOAK_STEP_MS);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOAK_TEST
@@ -0,0 +1,67 @@
+/* ************************************************************************ */
+/*
+    esp8266-clock.h - the application's time source.
+
+    The application reads the time with appMillis() instead of millis(),
+    normally it's the same thing. When SOAK_TEST is defined it is a 
+    virtual clock that starts shortly before the 32 bit rollover and is
+    moved forward by SOAK_STEP_MS on every pass through loop(). Months of
+    operation can then be run in a few hours, and the rollover is crossed
+    within minutes of starting. See src/applib/nodejs/soak-udp.js.
+
+    Deadlines must be checked with timeReached(), comparisons such as 
+    `deadline < millis()` fail when the clock rolls over (every 49.7 days).
+    Elapsed times are timeSince(). Both only look at the low 32 bits, so
+    they work the same where `unsigned long` is wider (the host build).
+*/
+#pragma once
+
+#if ARDUINO >= 100
+ #include "Arduino.h"
+#else
+ #include "WProgram.h"
+#endif
+
+// Uncomment to run the application against the virtual clock. The sensor
+// is not read, a slowly changing reading is generated instead. 
+//#define SOAK_TEST
+#ifdef SOAK_TEST
+// virtual milliseconds per pass through loop(), should be well 
+// below the sensor interval
+#define SOAK_STEP_MS    1000
+// the virtual clock starts this many milliseconds before it rolls over
+#define SOAK_START_MS   600000UL
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef SOAK_TEST
+extern unsigned long appMillis();
+extern void soakTick();
+#else
+#define appMillis() millis()
+#define soakTick()
+#endif
+
+/*
+    Returns true if `now` is at or past `when`. This is correct across a
+    rollover as long as the two times are less than 24.8 days apart.
+*/
+static inline bool timeReached(unsigned long now, unsigned long when)
+{
+    return (int32_t)(uint32_t)(now - when) >= 0;
+}
+
+/*
+    The milliseconds from `then` to `now`, across a rollover
+*/
+static inline unsigned long timeSince(unsigned long now, unsigned long then)
+{
+    return (uint32_t)(now - then);
+}
+
+#ifdef __cplusplus
+}
+#endif
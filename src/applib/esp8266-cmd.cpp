@@ -0,0 +1,313 @@
+/* ************************************************************************ */
+/*
+    esp8266-cmd.cpp - UDP command channel, allows a server to control a
+    running device.
+
+    Commands are dispatched through a table that is indexed by the opcode,
+    there are no string comparisons needed to find the handler. Each
+    handler is passed the argument portion of the packet and a buffer where
+    it can place additional JSON members for the reply.
+
+    The reply to a command looks like this -
+
+        {"dev_id":"ESP_49ECF6","reply":"I","status":"OK","interval":60000}
+
+    Where "status" is one of "OK", "FAIL" or "UNKNOWN".
+*/
+#include "esp8266-ino.h"
+#include "esp8266-cmd.h"
+#include "sensor-dht.h"
+#include "sensor-filter.h"
+#include "sensor-diag.h"
+#include "esp8266-log.h"
+#include "esp8266-ota.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Deadlines are checked with timeReached(), a time can't be longer 
+// than LONG_MAX on the device (2^31 - 1 ms, 24.8 days). The heartbeat
+// is 4 sensor intervals, so the interval is limited to a quarter of it.
+#define CMD_MAX_TIME        0x7FFFFFFFL
+#define CMD_MAX_INTERVAL    (CMD_MAX_TIME / 4)
+
+// command handler, returns true if the command was successful.
+// `extra` is where the handler can place additional JSON members
+// (without a leading comma) that will be added to the reply.
+typedef bool (*cmdfunc)(char *args, char *extra, int extralen);
+
+bool cmdReboot(char *args, char *extra, int extralen);
+bool cmdDelta(char *args, char *extra, int extralen);
+bool cmdInterval(char *args, char *extra, int extralen);
+bool cmdReport(char *args, char *extra, int extralen);
+bool cmdMute(char *args, char *extra, int extralen);
+bool cmdRead(char *args, char *extra, int extralen);
+bool cmdStats(char *args, char *extra, int extralen);
+bool cmdFilter(char *args, char *extra, int extralen);
+bool cmdDiag(char *args, char *extra, int extralen);
+#ifdef USE_OTA
+bool cmdOTA(char *args, char *extra, int extralen);
+#endif
+
+void runCmd(char *cmd, int len);
+
+// the command table, one entry for each letter. The opcode
+// minus CMD_FIRST is the index of its handler.
+const cmdfunc cmdtable[CMD_COUNT] = {
+    NULL,           // A
+    cmdReboot,      // B - CMD_REBOOT
+    NULL,           // C
+    cmdDelta,       // D - CMD_DELTA
+    NULL,           // E
+    cmdFilter,      // F - CMD_FILTER
+    NULL,           // G
+    cmdDiag,        // H - CMD_DIAG
+    cmdInterval,    // I - CMD_INTERVAL
+    NULL,           // J
+    NULL,           // K
+    NULL,           // L
+    cmdReport,      // M - CMD_REPORT
+    NULL,           // N
+#ifdef USE_OTA
+    cmdOTA,         // O - CMD_OTA
+#else
+    NULL,           // O
+#endif
+    NULL,           // P
+    cmdMute,        // Q - CMD_MUTE
+    cmdRead,        // R - CMD_READ
+    cmdStats,       // S - CMD_STATS
+    NULL,           // T
+    NULL,           // U
+    NULL,           // V
+    NULL,           // W
+    NULL,           // X
+    NULL,           // Y
+    NULL            // Z
+};
+
+// replies are assembled here
+char cmdReplyBuffer[UDP_PAYLOAD_SIZE_WRITE];
+
+// set by cmdReboot(), the reboot happens after the reply is sent
+bool rebootPending = false;
+
+/* ************************************************************************ */
+/*
+    Open the UDP port that will receive commands. If the server was
+    queried for its address then the port is already open, in that
+    case it will be re-opened.
+*/
+void initCmd()
+{
+    if((connWiFi != NULL) && connWiFi->IsConnected())
+    {
+        beginUDP(UDP_CMD_PORT);
+        if(!checkDebugMute()) Serial.println("initCmd() - listening on port " + String(UDP_CMD_PORT));
+    }
+}
+
+/*
+    Check for a received command and run it, this is called from
+    loop(). Returns the length of the packet that was received, or
+    0 if nothing was received.
+*/
+int handleComm()
+{
+int len;
+
+    if((len = recvUDP()) > 0)
+    {
+        // recvUDP() will not read a packet that's too long
+        if(len < UDP_PAYLOAD_SIZE) runCmd((char *)&readBuffer[0], len);
+        else LOG_WARN("handleComm() - too long, len = %d", len);
+    }
+    return len;
+}
+
+/*
+    Find the command's handler, run it and reply with the results
+*/
+void runCmd(char *cmd, int len)
+{
+conninfo conn;
+char extra[UDP_PAYLOAD_SIZE_WRITE];
+cmdfunc func = NULL;
+bool success = false;
+char op = cmd[0];
+
+    extra[0] = '\0';
+
+    if((op >= CMD_FIRST) && (op <= CMD_LAST)) func = cmdtable[op - CMD_FIRST];
+    // keep the reply valid JSON
+    else op = '?';
+
+    if(func != NULL) success = func(&cmd[1], extra, sizeof(extra));
+
+    LOG_DBG("runCmd() - %s : %d", cmd, success);
+
+    if((connWiFi != NULL) && connWiFi->GetConnInfo(&conn))
+    {
+        int replen = snprintf(cmdReplyBuffer, sizeof(cmdReplyBuffer),
+                              "{\"dev_id\":\"%s\",\"reply\":\"%c\",\"status\":\"%s\"%s%s}",
+                              conn.hostname.c_str(), op,
+                              (func == NULL ? "UNKNOWN" : (success ? "OK" : "FAIL")),
+                              (extra[0] != '\0' ? "," : ""), extra);
+
+        if(replen < (int)sizeof(cmdReplyBuffer)) replyUDP(cmdReplyBuffer, replen);
+        else LOG_WARN("runCmd() - reply NOT sent, too long");
+    }
+
+    if(rebootPending)
+    {
+        // give the reply a chance to get out
+        delay(100);
+        ESP.restart();
+    }
+}
+
+/* ************************************************************************ */
+/*
+    Command Handlers
+*/
+bool cmdReboot(char *args, char *extra, int extralen)
+{
+    rebootPending = true;
+    return true;
+}
+
+bool cmdDelta(char *args, char *extra, int extralen)
+{
+char *next;
+char *last;
+
+    long delta_t = strtol(args, &next, 10);
+    long delta_h = strtol(next, &last, 10);
+
+    // both values are required
+    if((next == args) || (last == next) || (delta_t < 0) || (delta_h < 0)) return false;
+
+    setSensorDelta(delta_t, delta_h);
+    snprintf(extra, extralen, "\"delta_t\":%ld,\"delta_h\":%ld", delta_t, delta_h);
+    return true;
+}
+
+bool cmdInterval(char *args, char *extra, int extralen)
+{
+    long interval = strtol(args, NULL, 10);
+
+    // the sensor can't be read more often than this
+    if((interval < (long)SensorDriver::minInterval()) || (interval > CMD_MAX_INTERVAL)) return false;
+
+    setSensorInterval(interval);
+    snprintf(extra, extralen, "\"interval\":%lu", getSensorInterval());
+    return true;
+}
+
+bool cmdReport(char *args, char *extra, int extralen)
+{
+#ifdef SENSOR_PROFILE
+    // the mode is compiled in (see sensor-dht.h) and can't be changed
+    return false;
+#else
+char mode[7];
+
+    // expecting " CHG", " ALL" or " STATS", one character more is 
+    // read so that a longer word isn't cut down to a valid one
+    if(sscanf(args, " %6s", mode) != 1) return false;
+    if(!setSensorReport(String(mode))) return false;
+
+    snprintf(extra, extralen, "\"report\":\"%s\"", mode);
+    return true;
+#endif
+}
+
+bool cmdMute(char *args, char *extra, int extralen)
+{
+    if(a_cfgdat == NULL) return false;
+
+    a_cfgdat->setDebugMute(strtol(args, NULL, 10) != 0);
+    setLogMute(checkDebugMute());
+    snprintf(extra, extralen, "\"mute\":%d", checkDebugMute());
+    return true;
+}
+
+bool cmdRead(char *args, char *extra, int extralen)
+{
+sensornow tmp;
+
+    readSensorNow(tmp);
+    return sendSensorNow(tmp);
+}
+
+bool cmdStats(char *args, char *extra, int extralen)
+{
+livesensor tmp;
+int num = 0;
+int used;
+
+    // the first sensor, or a probe's number
+    sscanf(args, " %d", &num);
+    if((num < 0) || (num >= SENSOR_MAX) || !sensorInUse(num)) return false;
+
+    getSensorState(tmp, num);
+    used = fmtSensorNum(extra, extralen, num);
+    if(used >= extralen) return false;
+    snprintf(&extra[used], extralen - used,
+             "\"seq\":%u,\"nancount\":%d,\"errcount\":%d,\"interval\":%lu,\"uptime\":%lu,\"heap\":%u",
+             tmp.seq, tmp.nancount, tmp.errcount, (num == 0 ? getSensorInterval() : tmp.interval), appMillis(), ESP.getFreeHeap());
+    return true;
+}
+
+bool cmdFilter(char *args, char *extra, int extralen)
+{
+filterstats tmp;
+
+    getFilterStats(tmp);
+    snprintf(extra, extralen, "\"accepted\":%u,\"rejected\":%u,\"resets\":%u",
+             tmp.accepted, tmp.rejected, tmp.resets);
+    return true;
+}
+
+bool cmdDiag(char *args, char *extra, int extralen)
+{
+char what = '\0';
+int num = 0;
+
+    // nothing for the counters, " R" for the ratio histogram
+    // or " C" to clear them. Either can be followed by a probe's
+    // number, or it can be on its own.
+    if(sscanf(args, " %d", &num) != 1) sscanf(args, " %c %d", &what, &num);
+    if((num < 0) || (num >= SENSOR_MAX) || !sensorInUse(num)) return false;
+
+    if(what == 'R') fmtSensorRatio(extra, extralen, num);
+    else if((what == 'C') || (what == '\0'))
+    {
+        if(what == 'C') clearSensorDiag(num);
+        fmtSensorDiag(extra, extralen, num);
+    }
+    else return false;
+    return true;
+}
+
+#ifdef USE_OTA
+bool cmdOTA(char *args, char *extra, int extralen)
+{
+char *next;
+long dur;
+
+    // no argument uses `otadur` from the OTA configuration
+    dur = strtol(args, &next, 10);
+    if(next == args) dur = -1;
+    else if((dur < 0) || (dur > CMD_MAX_TIME)) return false;
+
+    if(!openOTA(dur < 0 ? getOTADuration() : dur)) return false;
+    snprintf(extra, extralen, "\"ota\":%lu", getOTAWindow());
+    return true;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
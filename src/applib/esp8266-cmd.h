@@ -0,0 +1,46 @@
+/* ************************************************************************ */
+/*
+    esp8266-cmd.h - UDP command channel, allows a server to control a
+    running device.
+
+    A command packet is plain text. The first character is the opcode and
+    it is optionally followed by space separated arguments. For example -
+
+        "I 60000"   - set the sensor read interval to 60 seconds
+        "D 5 10"    - set delta_t to 5 and delta_h to 10
+        "M ALL"     - set the report mode
+
+    Every command is answered with a reply sent via replyUDP().
+*/
+#pragma once
+
+#include "udp-defs.h"
+
+// command opcodes, they're also the index (minus 'A') into
+// the command table in esp8266-cmd.cpp
+#define CMD_READ        'R'     // force a sensor read & report
+#define CMD_INTERVAL    'I'     // I <milliseconds>
+#define CMD_DELTA       'D'     // D <delta_t> <delta_h>
+#define CMD_REPORT      'M'     // M <CHG | ALL | STATS>
+#define CMD_STATS       'S'     // request device & sensor stats
+#define CMD_FILTER      'F'     // request the reading filter's counters
+#define CMD_DIAG        'H'     // H [R | C], request the DHT read diagnostics
+#define CMD_MUTE        'Q'     // Q <1 = mute | 0 = unmute>
+#define CMD_OTA         'O'     // O [milliseconds], open the OTA window (0 closes it), USE_OTA only
+#define CMD_REBOOT      'B'     // reboot the device
+
+// the opcode range covered by the command table
+#define CMD_FIRST   'A'
+#define CMD_LAST    'Z'
+#define CMD_COUNT   ((CMD_LAST - CMD_FIRST) + 1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void initCmd();
+
+#ifdef __cplusplus
+}
+#endif
+
@@ -0,0 +1,99 @@
+/* ************************************************************************ */
+/*
+    esp8266-heap.cpp - heap and fragmentation telemetry.
+
+    The free heap is sampled on each pass through loop() so that the 
+    lowest value since boot can be kept. The snapshot is serialized 
+    into a static buffer with snprintf() (see sendStatusFmt()), sending
+    it does not use the heap that it's measuring.
+*/
+#include "esp8266-ino.h"
+#include "esp8266-heap.h"
+#include "esp8266-log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+heapstats heap;
+
+// true while the HEAP_LOW status is in effect
+bool heapLow = false;
+
+bool sendHeapMsg(const char *status);
+
+/*
+    Save the reset reason and take the first sample
+*/
+void initHeapStats()
+{
+    heap.reset = ESP.getResetInfoPtr()->reason;
+    heap.minfree = ESP.getFreeHeap();
+    updateHeapStats();
+}
+
+/*
+    Sample the free heap, keep track of the lowest value and 
+    send a HEAP_LOW status when it crosses the threshold.
+*/
+void updateHeapStats()
+{
+    heap.freeheap = ESP.getFreeHeap();
+    if(heap.freeheap < heap.minfree) heap.minfree = heap.freeheap;
+
+    // it's only latched when the status was sent, there's no
+    // device ID until the WiFi is connected
+    if(!heapLow && (heap.freeheap < HEAP_LOW_THRESHOLD)) heapLow = sendHeapMsg("HEAP_LOW");
+    else if(heapLow && (heap.freeheap > (HEAP_LOW_THRESHOLD + HEAP_LOW_HYSTERESIS))) heapLow = false;
+}
+
+/*
+    Get a complete snapshot of the heap metrics
+*/
+void getHeapStats(heapstats &_heap)
+{
+    heap.freeheap = ESP.getFreeHeap();
+    if(heap.freeheap < heap.minfree) heap.minfree = heap.freeheap;
+    heap.maxblock = ESP.getMaxFreeBlockSize();
+    heap.frag = ESP.getHeapFragmentation();
+    _heap = heap;
+}
+
+/*
+    Format the heap metrics as JSON members (without the enclosing
+    braces) into `buf`. Returns the length, or a value >= len if
+    the buffer was too small.
+*/
+int fmtHeapStats(char *buf, int len)
+{
+heapstats tmp;
+
+    getHeapStats(tmp);
+    return snprintf(buf, len, "\"free\":%u,\"min\":%u,\"max\":%u,\"frag\":%u,\"reset\":%u",
+                    tmp.freeheap, tmp.minfree, tmp.maxblock, tmp.frag, tmp.reset);
+}
+
+/*
+    Multi-cast the heap metrics as a status message, sent with
+    each heartbeat - 
+
+        {"dev_id":"ESP_49ECF6","status":"HEAP","free":40112,"min":38800,"max":37920,"frag":4,"reset":0}
+*/
+bool sendHeapStats()
+{
+    return sendHeapMsg("HEAP");
+}
+
+/*
+    Send a status message containing the heap metrics. The heap
+    isn't used, it might be low already. HEAP_LOW is only latched
+    when it was sent.
+*/
+bool sendHeapMsg(const char *status)
+{
+    return sendStatusFmt(status, fmtHeapStats);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,38 @@
+/* ************************************************************************ */
+/*
+    esp8266-heap.h - heap and fragmentation telemetry.
+
+    NOTE: getHeapFragmentation() and getMaxFreeBlockSize() require version
+    2.5.0 (or newer) of the ESP8266 Arduino core.
+*/
+#pragma once
+
+// A HEAP_LOW status is sent when the free heap drops below this
+// many bytes. It's sent again only after the free heap has risen 
+// above (HEAP_LOW_THRESHOLD + HEAP_LOW_HYSTERESIS).
+#define HEAP_LOW_THRESHOLD  8192
+#define HEAP_LOW_HYSTERESIS 2048
+
+// a snapshot of the heap metrics
+class heapstats {
+    public:
+        uint32_t freeheap = 0;  // ESP.getFreeHeap()
+        uint32_t minfree = 0;   // lowest free heap seen since boot
+        uint32_t maxblock = 0;  // ESP.getMaxFreeBlockSize()
+        uint8_t frag = 0;       // ESP.getHeapFragmentation(), 0 - 100%
+        uint32_t reset = 0;     // reset reason, see rst_reason in user_interface.h
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void initHeapStats();
+extern void updateHeapStats();
+extern void getHeapStats(heapstats &);
+extern int fmtHeapStats(char *buf, int len);
+extern bool sendHeapStats();
+
+#ifdef __cplusplus
+}
+#endif
@@ -15,6 +15,8 @@
     (c) 2017 Jim Motyl - https://github.com/jxmot/esp8266-dht-udp
 */
 #include "esp8266-ino.h"
+#include "esp8266-log.h"
+#include "sensor-dht.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -55,15 +57,22 @@ SensorCfgData *sens_cfgdat = NULL;
 // error message string
 String errMsg;
 
+// the device ID, see connectWiFi()
+char devID[DEVID_SIZE] = "";
+
 // pointer to the WiFi connection object
 ConnectWiFi *connWiFi = NULL;
 
+// the appMillis() time when setup() started
+unsigned long bootTime = 0;
+
 /* ************************************************************************ */
 /*
     Print a start up message to the serial port
 */
 void setupStart()
 {
+    bootTime = appMillis();
     Serial.begin(DEFAULT_SERIAL_BAUD);
     Serial.println();
     Serial.println();
@@ -72,18 +81,20 @@ void setupStart()
 }
 
 /*
-    Read and parse the configuration files
+    Read and parse the configuration files. The sensor is started
+    before the WiFi connection is made, it warms up and takes its
+    first reading while the connection is made (see sampleSensor()).
 */
 void setupConfig()
 {
 #ifdef CONFIG_DEMO
     if(setupApp("/appcfg.json")) 
     {
-        if(setupWiFi("/wificfg.json")) 
+        if(!setupSensor("/sensorcfg.json")) toggInterv = ERR_TOGGLE_INTERVAL;
+        else if(setupWiFi("/wificfg.json")) 
         {
             if(!setupClient("/clientcfg.json")) toggInterv = ERR_TOGGLE_INTERVAL;
             else if(!setupMultiCast("/multicfg.json")) toggInterv = ERR_TOGGLE_INTERVAL;
-            else if(!setupSensor("/sensorcfg.json")) toggInterv = ERR_TOGGLE_INTERVAL;
 #else
     if(setupApp("/_appcfg.json")) 
     {
@@ -94,11 +105,11 @@ void setupConfig()
         // this code block is to serve as a gentle reminder that there can
         // be additional differences between modes. For example, some config 
         // operations might not be necessary in CONFIG_DEMO.
-        if(setupWiFi(a_cfgdat->getWifiConfig())) 
+        if(!setupSensor(a_cfgdat->getSensorConfig())) toggInterv = ERR_TOGGLE_INTERVAL;
+        else if(setupWiFi(a_cfgdat->getWifiConfig())) 
         {
             if(!setupClient(a_cfgdat->getClientConfig())) toggInterv = ERR_TOGGLE_INTERVAL;
             else if(!setupMultiCast(a_cfgdat->getMcastConfig())) toggInterv = ERR_TOGGLE_INTERVAL;
-            else if(!setupSensor(a_cfgdat->getSensorConfig())) toggInterv = ERR_TOGGLE_INTERVAL;
 #endif
         } else toggInterv = ERR_TOGGLE_INTERVAL;
     } else  toggInterv = ERR_TOGGLE_INTERVAL;
@@ -241,6 +252,7 @@ bool bRet = false;
         {
             // success, display the config data
             printAppCfg();
+            setLogMute(a_cfgdat->getDebugMute());
             bRet = true;
         }
     } else printError(func, errMsg);
@@ -447,7 +459,7 @@ clisrvcfg cfg;
 // 
 // To DO: Obtain these strings from a config file, and/or
 //        seek a better method.
-const String labels[] = {"udp1","udp2","END"};
+const String labels[] = {"udp1","udp2","log","END"};
 
     if(!checkDebugMute())
     {
@@ -484,6 +496,14 @@ conninfo conn;
     // attempt to connect with the specified access point...
     connWiFi = new ConnectWiFi(ssid.c_str(), pass.c_str());
 
+    // save the device ID for code that builds messages 
+    // without using String
+    if(connWiFi->GetConnInfo(&conn)) 
+    {
+        strncpy(devID, conn.hostname.c_str(), DEVID_SIZE - 1);
+        devID[DEVID_SIZE - 1] = '\0';
+    }
+
     // debug stuff
     if(!checkDebugMute())
     {
@@ -573,6 +593,10 @@ bool bRet = false;
         else 
         {
             bRet = true;
+            // start the sensor now, and take the first reading
+            // while the WiFi connects
+            startSensor();
+            connectIdle = sampleSensor;
 
             // debug stuff
             // success, display the config data
@@ -643,13 +667,12 @@ ipreply r;
 
 #ifdef QUERY_SERVER
 /*
-    TODO: constants should be defined or configurable
+    TODO: constants should be configurable
 */
 void sendQuery(String query) 
 {
-    int port = 43210;
-    beginUDP(port);
-    sendStatus(query, String(port));
+    beginUDP(UDP_CMD_PORT);
+    sendStatus(query, String(UDP_CMD_PORT));
 }
 
 #define MAX_WAIT 8
@@ -685,6 +708,8 @@ bool bRet = false;
             }
             if(!checkDebugMute()) Serial.print(".");
             delay(250);
+            // the first sensor reading, see setupSensor()
+            if(connectIdle != NULL) connectIdle();
             waitcount += 1;
             if(waitcount >= MAX_WAIT)
             {
@@ -707,21 +732,52 @@ void sendStatus(String status, String msg)
 conninfo conn;
 String statusData;
 
-    // connected?
-    if(connWiFi->GetConnInfo(&conn)) 
+    // connected? a sensor fault can be found before the 
+    // connection is made, see setupSensor()
+    if((connWiFi != NULL) && connWiFi->GetConnInfo(&conn)) 
     {
         statusData = "{\"dev_id\":\"" + conn.hostname + "\"";
         statusData = statusData + ",\"status\":\"" + status + "\"";
         if(strlen(msg.c_str()) > 0) statusData = statusData + ",\"msg\":\"" + msg + "\"";
         statusData = statusData + "}";
 
-        if(!checkDebugMute()) Serial.println("sendStatus() - " + statusData);
+        LOG_DBG("sendStatus() - %s", statusData.c_str());
 
         if(strlen(statusData.c_str()) <= UDP_PAYLOAD_SIZE) multiUDP((char *)statusData.c_str(), strlen(statusData.c_str()));
-        else if(!checkDebugMute()) Serial.println("sendStatus() - NOT sent, too long");
+        else LOG_WARN("sendStatus() - NOT sent, too long");
     }
 }
 
+// the messages sent by sendStatusFmt() are assembled here
+char statusBuffer[UDP_PAYLOAD_SIZE_WRITE];
+
+/*
+    Send a status message via UDP multicast, the rest of its members 
+    are formatted by `fmt` (see fmtHeapStats()). It's assembled in a 
+    static buffer with snprintf(), the heap isn't used. Returns true 
+    if it was sent.
+*/
+bool sendStatusFmt(const char *status, int (*fmt)(char *, int))
+{
+int len;
+
+    if(devID[0] == '\0') return false;
+
+    len = snprintf(statusBuffer, sizeof(statusBuffer), "{\"dev_id\":\"%s\",\"status\":\"%s\",", devID, status);
+    if(len >= (int)sizeof(statusBuffer)) return false;
+
+    len += fmt(&statusBuffer[len], sizeof(statusBuffer) - len);
+    // leave room for the closing brace
+    if(len >= (int)sizeof(statusBuffer) - 1) return false;
+
+    statusBuffer[len++] = '}';
+    statusBuffer[len] = '\0';
+
+    LOG_DBG("%s", statusBuffer);
+
+    return (multiUDP(statusBuffer, len) > 0);
+}
+
 #ifdef __cplusplus
 }
 #endif
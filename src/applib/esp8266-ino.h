@@ -28,6 +28,7 @@
 #include "connectWiFi.h"
 
 #include "esp8266-udp.h"
+#include "esp8266-clock.h"
 
 // The on-board LED is used for indicating the post-setup state. The LED 
 // will be toggled using one of two intervals (OFF/ON). The intent is to
@@ -76,6 +77,7 @@ extern bool checkDebugMute();
 
 extern void ready();
 extern void sendStatus(String status, String msg = "");
+extern bool sendStatusFmt(const char *status, int (*fmt)(char *, int));
 
 extern int handleComm();
 
@@ -90,9 +92,17 @@ extern SensorCfgData *sens_cfgdat;
 // error message string
 extern String errMsg;
 
+// the device ID (hostname), saved after the WiFi connection is 
+// made so that it can be used without copying conninfo
+#define DEVID_SIZE 33
+extern char devID[];
+
 // pointer to the WiFi connection object -
 extern ConnectWiFi *connWiFi;
 
+// the appMillis() time when setup() started
+extern unsigned long bootTime;
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,201 @@
+/* ************************************************************************ */
+/*
+    esp8266-log.cpp - leveled logging into a ring buffer.
+
+    Each record is a single line - 
+
+        <millis> <level> <message>\n
+
+    For example - "123456 D sendUDP() - len = 52"
+
+    If a record will not fit in the ring it is dropped, the number of
+    dropped records is counted and reported by drainLog() once there's
+    room again.
+*/
+#include <stdarg.h>
+
+#include "esp8266-ino.h"
+#include "esp8266-log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOG_RING_MASK (LOG_RING_SIZE - 1)
+
+// muted until the application configuration is read
+bool logMute = true;
+
+int serialSink(const char *buf, int len);
+
+char logRing[LOG_RING_SIZE];
+// where the next record is written, and where the next
+// byte will be taken from by drainLog()
+uint16_t logHead = 0;
+uint16_t logTail = 0;
+
+// records dropped since the last report, and in total
+unsigned long logDropped = 0;
+unsigned long logDroppedTotal = 0;
+
+logsink logOut = serialSink;
+
+/*
+    The default sink, only writes what the Serial port can 
+    accept without blocking.
+*/
+int serialSink(const char *buf, int len)
+{
+    int avail = Serial.availableForWrite();
+
+    if(len > avail) len = avail;
+    if(len > 0) Serial.write((const uint8_t *)buf, len);
+    return len;
+}
+
+void setLogMute(bool mute)
+{
+    logMute = mute;
+}
+
+void setLogSink(logsink sink)
+{
+    logOut = (sink == NULL ? serialSink : sink);
+}
+
+unsigned long getLogDropped()
+{
+    return logDroppedTotal;
+}
+
+/*
+    Copy a complete record into the ring, or drop it if there
+    isn't room.
+*/
+void logPut(const char *rec, int len)
+{
+    int room = (LOG_RING_SIZE - 1) - ((logHead - logTail) & LOG_RING_MASK);
+
+    if(len > room)
+    {
+        logDropped += 1;
+        logDroppedTotal += 1;
+        return;
+    }
+
+    for(int ix = 0; ix < len; ix++)
+    {
+        logRing[logHead] = rec[ix];
+        logHead = (logHead + 1) & LOG_RING_MASK;
+    }
+}
+
+/*
+    Format a record and place it in the ring
+*/
+void logWrite(char level, const char *fmt, ...)
+{
+char rec[LOG_LINE_SIZE];
+va_list args;
+int len;
+
+    len = snprintf(rec, sizeof(rec), "%lu %c ", appMillis(), level);
+
+    va_start(args, fmt);
+    len += vsnprintf(&rec[len], sizeof(rec) - len, fmt, args);
+    va_end(args);
+
+    // truncated? leave room for the newline
+    if(len > (int)sizeof(rec) - 2) len = sizeof(rec) - 2;
+    rec[len++] = '\n';
+
+    logPut(rec, len);
+}
+
+/*
+    Give as much of the ring to the sink as it will take, this is
+    called from loop() after the work for that pass is done. Returns
+    the number of bytes that remain in the ring.
+*/
+int drainLog()
+{
+    while(logTail != logHead)
+    {
+        // the sink is given the contiguous part of the ring
+        int len = (logHead > logTail ? logHead : LOG_RING_SIZE) - logTail;
+        int sent = logOut(&logRing[logTail], len);
+
+        if(sent <= 0) break;
+        logTail = (logTail + sent) & LOG_RING_MASK;
+    }
+    logOut(NULL, 0);
+
+    // report any drops after the ring has been emptied
+    if((logTail == logHead) && (logDropped > 0))
+    {
+        unsigned long dropped = logDropped;
+        logDropped = 0;
+        LOG_WARN("log - %lu records dropped", dropped);
+        // unused when LOG_LEVEL is below LOG_LEVEL_WARN
+        (void)dropped;
+    }
+    return (logHead - logTail) & LOG_RING_MASK;
+}
+
+#ifdef LOG_BENCH
+/*
+    Compare the time taken by the original method of logging with the
+    time taken by LOG_DBG(). Each pass logs a burst of messages like the
+    ones from a single sensor read & send. Debug output is enabled for
+    both, and the ring buffer is drained between passes (that time is 
+    measured separately, it happens when the loop is idle).
+*/
+#define LOG_BENCH_PASSES 20
+#define LOG_BENCH_BURST  6
+
+void logBench()
+{
+uint32_t start;
+uint32_t strcycles = 0;
+uint32_t logcycles = 0;
+uint32_t draincycles = 0;
+String addr = "192.168.0.7";
+int port = 48431;
+bool mute = logMute;
+
+    logMute = false;
+
+    for(int ix = 0; ix < LOG_BENCH_PASSES; ix++)
+    {
+        Serial.flush();
+        start = ESP.getCycleCount();
+        for(int iy = 0; iy < LOG_BENCH_BURST; iy++)
+            Serial.println("sendUDP("+String(iy)+") - sending to " + addr + ":" + port);
+        strcycles += ESP.getCycleCount() - start;
+
+        Serial.flush();
+        start = ESP.getCycleCount();
+        for(int iy = 0; iy < LOG_BENCH_BURST; iy++)
+            LOG_DBG("sendUDP(%d) - sending to %s:%d", iy, addr.c_str(), port);
+        logcycles += ESP.getCycleCount() - start;
+
+        start = ESP.getCycleCount();
+        while(drainLog() > 0) yield();
+        draincycles += ESP.getCycleCount() - start;
+    }
+    Serial.flush();
+
+    Serial.println();
+    Serial.println("logBench() - microseconds per burst of " + String(LOG_BENCH_BURST) + ", " + String(LOG_BENCH_PASSES) + " passes");
+    Serial.println("String + Serial.println() = " + String(strcycles / LOG_BENCH_PASSES / clockCyclesPerMicrosecond()));
+    Serial.println("LOG_DBG()                 = " + String(logcycles / LOG_BENCH_PASSES / clockCyclesPerMicrosecond()));
+    Serial.println("drainLog() when idle      = " + String(draincycles / LOG_BENCH_PASSES / clockCyclesPerMicrosecond()));
+    Serial.println();
+
+    logMute = mute;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
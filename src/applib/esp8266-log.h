@@ -0,0 +1,86 @@
+/* ************************************************************************ */
+/*
+    esp8266-log.h - leveled logging into a ring buffer.
+
+    The LOG_* macros format their message (printf style) into a fixed size
+    ring buffer. Nothing is written to the Serial port until drainLog() is
+    called, that's done at the end of loop() and it only writes what the
+    Serial port will accept without blocking. The records can be sent to
+    a collector instead, see esp8266-logship.h.
+
+    Levels above LOG_LEVEL are removed by the compiler, their arguments are
+    not evaluated. LOG_INFO and LOG_DBG are also muted at run-time by the
+    "debugmute" setting in the application configuration.
+*/
+#pragma once
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERR   1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+// the highest level that is compiled
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+// the ring buffer size, must be a power of 2
+#define LOG_RING_SIZE   1024
+// the longest single log record, longer ones are truncated
+#define LOG_LINE_SIZE   128
+
+// Uncomment to run logBench() at start up, it compares the time taken
+// by String & Serial.println() with the time taken by LOG_DBG().
+//#define LOG_BENCH
+
+#if LOG_LEVEL >= LOG_LEVEL_ERR
+#define LOG_ERR(...)    logWrite('E', __VA_ARGS__)
+#else
+#define LOG_ERR(...)    do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...)   logWrite('W', __VA_ARGS__)
+#else
+#define LOG_WARN(...)   do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...)   do { if(!logMute) logWrite('I', __VA_ARGS__); } while(0)
+#else
+#define LOG_INFO(...)   do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DBG(...)    do { if(!logMute) logWrite('D', __VA_ARGS__); } while(0)
+#else
+#define LOG_DBG(...)    do {} while(0)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A log sink is given the oldest unsent portion of the ring buffer and
+// returns the number of bytes it accepted, 0 if it can't take any now.
+// It's also called with a length of 0 after each drain, a sink that 
+// buffers can use that to send what it's holding.
+typedef int (*logsink)(const char *buf, int len);
+
+// a copy of the debug mute setting, see setLogMute()
+extern bool logMute;
+
+extern void setLogMute(bool mute);
+extern void setLogSink(logsink sink);
+extern void logWrite(char level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+extern int drainLog();
+extern unsigned long getLogDropped();
+
+#ifdef LOG_BENCH
+extern void logBench();
+#endif
+
+#ifdef __cplusplus
+}
+#endif
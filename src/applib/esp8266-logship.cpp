@@ -0,0 +1,221 @@
+/* ************************************************************************ */
+/*
+    esp8266-logship.cpp - ships the log records (see esp8266-log.h) to a
+    collector via UDP.
+
+    Records are collected into packets of up to LOGSHIP_PACKET_SIZE bytes.
+    The first line of a packet is the device ID, followed by one record 
+    per line, each one prefixed with a sequence number - 
+
+        ESP_49ECF6
+        1021 123456 D sendUDP() - len = 52
+        1022 123460 D sendUDP(52) - sending to 192.168.0.7:54321
+        1023 128011 D last message repeated 6 times
+
+    The sequence number increments for each record that is sent, a gap
+    indicates lost records. A message that is the same as the previous
+    one is counted instead of sent, the count is sent when a different
+    message is logged or when LOGSHIP_FLUSH_MS has passed.
+*/
+#include "esp8266-ino.h"
+#include "esp8266-log.h"
+#include "esp8266-logship.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int shipSink(const char *buf, int len);
+
+clisrvcfg shipCfg;
+// true if the server's address is used
+bool shipToServer = false;
+
+char shipPacket[LOGSHIP_PACKET_SIZE];
+int shipLen = 0;
+// when the first record was placed in the packet
+unsigned long shipFirst = 0;
+uint32_t shipSeq = 0;
+
+// the record being received from the ring, it's held here if
+// there's no room for it in the packet
+char shipLine[LOG_LINE_SIZE];
+int shipLineLen = 0;
+bool shipLinePending = false;
+
+// the message portion of the last record, for finding repeats
+char shipLast[LOG_LINE_SIZE] = "";
+char shipLastLevel = 'D';
+unsigned long shipLastTime = 0;
+uint16_t shipRepeats = 0;
+
+// the rate limit, in thousandths of a packet
+long shipTokens = LOGSHIP_BURST * 1000L;
+unsigned long shipRefill = 0;
+
+/* ************************************************************************ */
+/*
+    Read the collector's configuration and take over the log output
+*/
+bool initLogShip()
+{
+    if((c_cfgdat == NULL) || !c_cfgdat->getServer("log", shipCfg) || (shipCfg.port == 0)) return false;
+
+    // use the UDP server's address if the configured one isn't valid
+    shipToServer = !shipCfg.ipaddr.fromString(shipCfg.addr);
+
+    shipRefill = appMillis();
+    setLogSink(shipSink);
+
+    LOG_INFO("initLogShip() - shipping to %s:%d", (shipToServer ? "server" : shipCfg.addr.c_str()), shipCfg.port);
+    return true;
+}
+
+/*
+    Send the packet if the rate limit allows it, returns false if it
+    has to wait.
+*/
+bool shipSend()
+{
+    unsigned long now = appMillis();
+    unsigned long dt = timeSince(now, shipRefill);
+
+    // the bucket is full after this long, a longer time would
+    // overflow the multiplication
+    if(dt > ((LOGSHIP_BURST * 1000UL) / LOGSHIP_RATE)) dt = (LOGSHIP_BURST * 1000UL) / LOGSHIP_RATE;
+
+    shipTokens += dt * LOGSHIP_RATE;
+    if(shipTokens > (LOGSHIP_BURST * 1000L)) shipTokens = LOGSHIP_BURST * 1000L;
+    shipRefill = now;
+
+    if(shipTokens < 1000) return false;
+
+    // a failed send keeps the packet and its token, it's
+    // tried again with the next record or flush
+    if(sendToUDP((shipToServer ? getServerIP() : shipCfg.ipaddr), shipCfg.port, shipPacket, shipLen) <= 0) return false;
+
+    shipTokens -= 1000;
+    shipLen = 0;
+    return true;
+}
+
+/*
+    Add a record to the packet, the packet is sent first if there's
+    not enough room. Returns false if the record could not be added.
+*/
+bool shipAppend(unsigned long ms, char level, const char *msg)
+{
+char rec[LOG_LINE_SIZE + 16];
+int len;
+
+    len = snprintf(rec, sizeof(rec), "%u %lu %c %s\n", shipSeq, ms, level, msg);
+    if(len >= (int)sizeof(rec)) len = sizeof(rec) - 1;
+
+    if(((shipLen + len) > LOGSHIP_PACKET_SIZE) && !shipSend()) return false;
+
+    if(shipLen == 0)
+    {
+        shipLen = snprintf(shipPacket, LOGSHIP_PACKET_SIZE, "%s\n", devID);
+        shipFirst = appMillis();
+    }
+    memcpy(&shipPacket[shipLen], rec, len);
+    shipLen += len;
+    shipSeq += 1;
+    return true;
+}
+
+/*
+    Add the "repeated" record if there are any repeats
+*/
+bool shipRepeated()
+{
+char msg[40];
+
+    if(shipRepeats == 0) return true;
+
+    snprintf(msg, sizeof(msg), "last message repeated %u times", shipRepeats);
+    if(!shipAppend(shipLastTime, shipLastLevel, msg)) return false;
+
+    shipRepeats = 0;
+    return true;
+}
+
+/*
+    Handle a complete record from the ring - "<millis> <level> <message>"
+*/
+bool shipRecord(char *line)
+{
+char *msg;
+unsigned long ms = strtoul(line, &msg, 10);
+char level = (msg[0] == ' ' ? msg[1] : '?');
+
+    // skip to the message
+    msg = (msg[0] == ' ' && msg[1] != '\0' && msg[2] == ' ' ? &msg[3] : msg);
+
+    if(strcmp(msg, shipLast) == 0)
+    {
+        shipRepeats += 1;
+        shipLastTime = ms;
+        return true;
+    }
+    // the repeats must be sent before the new message
+    if(!shipRepeated() || !shipAppend(ms, level, msg)) return false;
+
+    strncpy(shipLast, msg, sizeof(shipLast) - 1);
+    shipLast[sizeof(shipLast) - 1] = '\0';
+    shipLastLevel = level;
+    shipLastTime = ms;
+    return true;
+}
+
+/*
+    Send what's waiting once it's old enough
+*/
+void shipFlush()
+{
+    if((shipRepeats > 0) && (timeSince(appMillis(), shipLastTime) >= LOGSHIP_FLUSH_MS)) shipRepeated();
+    if((shipLen > 0) && (timeSince(appMillis(), shipFirst) >= LOGSHIP_FLUSH_MS)) shipSend();
+}
+
+/*
+    The log sink, it takes bytes from the ring and assembles them into
+    records. Returns the number of bytes taken. It's also called with
+    a length of 0 so that partial packets can be sent.
+*/
+int shipSink(const char *buf, int len)
+{
+int taken = 0;
+
+    // a record that didn't fit in the last packet goes first
+    if(shipLinePending)
+    {
+        if(!shipRecord(shipLine)) return 0;
+        shipLinePending = false;
+    }
+
+    while(taken < len)
+    {
+        char c = buf[taken++];
+
+        if(c != '\n')
+        {
+            if(shipLineLen < (int)sizeof(shipLine) - 1) shipLine[shipLineLen++] = c;
+            continue;
+        }
+        shipLine[shipLineLen] = '\0';
+        shipLineLen = 0;
+
+        if(!shipRecord(shipLine))
+        {
+            // hold on to it and try again later
+            shipLinePending = true;
+            break;
+        }
+    }
+    shipFlush();
+    return taken;
+}
+
+#ifdef __cplusplus
+}
+#endif
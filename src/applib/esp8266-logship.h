@@ -0,0 +1,33 @@
+/* ************************************************************************ */
+/*
+    esp8266-logship.h - ships the log records (see esp8266-log.h) to a
+    collector via UDP.
+
+    The collector is configured in the client configuration file with the
+    "log" label. A port of 0 disables shipping, and if the address is not
+    a valid IP address the address of the UDP server is used.
+*/
+#pragma once
+
+// The maximum size of a log packet, this is well under the 1472 
+// byte UDP payload limit of a typical 1500 byte MTU.
+#define LOGSHIP_PACKET_SIZE 512
+
+// a partially filled packet is sent after this many milliseconds
+#define LOGSHIP_FLUSH_MS    2000
+
+// Rate limit, packets per second and the maximum burst. When the limit
+// is reached the records wait in the ring buffer, if that fills then 
+// records are dropped.
+#define LOGSHIP_RATE        2
+#define LOGSHIP_BURST       4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern bool initLogShip();
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,8 +2,12 @@
 /*
    esp8266-ota.cpp - support for OTA updates
 
+   See esp8266-ota.h for details.
 */
 // required include files...
+#include "esp8266-ota.h"
+
+#ifdef USE_OTA
 #include <ArduinoOTA.h>
 #include "esp8266-ino.h"
 #include "OTACfgData.h"
@@ -15,7 +19,18 @@ extern "C" {
 OTACfgData *o_cfgdat = NULL;
 otacfg cfg;
 
-unsigned long otaWaitUntil;
+// true after ArduinoOTA.begin()
+bool otaReady = false;
+// when the window closes, 0 if it's closed
+unsigned long otaWaitUntil = 0;
+
+// the transfer in progress, or the last one. The times are from
+// millis(), the transfer holds up the loop so the virtual clock
+// (SOAK_TEST) doesn't move.
+unsigned long otaXferStart = 0;
+unsigned int otaXferBytes = 0;
+
+String otaXferStats();
 
 bool setupOTA(const String otaCfgFile)
 {
@@ -84,24 +99,25 @@ void initOTA()
     if(connWiFi->IsConnected() && setupOTA("/_otacfg.json"))
 #endif
     {
-        otaWaitUntil = millis() + cfg.otadur;
-
         setOTAOptions();
 
         ArduinoOTA.onStart([]() {
             if(!checkDebugMute()) Serial.println("\nOTA Start");
+            otaXferStart = millis();
+            otaXferBytes = 0;
             sendStatus("OTA_START");
         });
     
         ArduinoOTA.onEnd([]() {
             if(!checkDebugMute()) Serial.println("\nOTA End");
-            sendStatus("OTA_END");
+            sendStatus("OTA_END", otaXferStats());
         });
     
         // although this is shown in examples, it doesn't seem to ever
         // occur.
         ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
-            if(!checkDebugMute()) Serial.printf("OTA Progress: %u%%\r", (progress / (total / 100)));
+            otaXferBytes = progress;
+            if(!checkDebugMute() && (total >= 100)) Serial.printf("OTA Progress: %u%%\r", (progress / (total / 100)));
         });
     
         ArduinoOTA.onError([](ota_error_t error) {
@@ -139,34 +155,91 @@ void initOTA()
                     errcode = "OTA_END_ERROR";
                     break;
             }
-            sendStatus(errcode);
+            // sent as the status, the message has what was received
+            sendStatus(errcode, otaXferStats());
         });
     
         ArduinoOTA.begin();
+        otaReady = true;
         if(!checkDebugMute()) Serial.println("OTA Ready - IP address: " + WiFi.localIP().toString());
-        if(!checkDebugMute()) Serial.println("OTA Ready - Duration  : " + String(cfg.otadur));
-        sendStatus("OTA_READY", String(cfg.otadur / 1000));
+
+        // the first window, the application starts now instead of
+        // at the end of it
+        openOTA(cfg.otadur);
 
     } else Serial.println("OTA WiFi NOT Ready");
 }
 
-bool waitForOTA()
+/*
+    Open the OTA window for `dur` milliseconds, or close it if `dur`
+    is 0. Returns false if OTA isn't ready.
+*/
+bool openOTA(unsigned long dur)
 {
-    if(connWiFi->IsConnected())
+    if(!otaReady) return false;
+
+    if(dur == 0)
+    {
         if(otaWaitUntil != 0)
-            if(otaWaitUntil > millis())
-            {
-                ArduinoOTA.handle();
-                return true;
-            } else {
-                if(!checkDebugMute()) Serial.println("OTA Stopped Waiting");
-                sendStatus("OTA_STOP");
-                otaWaitUntil = 0;
-            }
+        {
+            if(!checkDebugMute()) Serial.println("OTA Stopped Waiting");
+            sendStatus("OTA_STOP");
+        }
+        otaWaitUntil = 0;
+    }
+    else
+    {
+        // 0 means closed
+        otaWaitUntil = (appMillis() + dur) | 1;
+        if(!checkDebugMute()) Serial.println("OTA Ready - Duration  : " + String(dur));
+        sendStatus("OTA_READY", String(dur / 1000));
+    }
+    return true;
+}
+
+/*
+    The milliseconds left before the window closes, 0 if it's closed
+*/
+unsigned long getOTAWindow()
+{
+    if((otaWaitUntil == 0) || timeReached(appMillis(), otaWaitUntil)) return 0;
+    return timeSince(otaWaitUntil, appMillis());
+}
+
+/*
+    The configured window, `otadur`
+*/
+unsigned long getOTADuration()
+{
+    return cfg.otadur;
+}
+
+/*
+    Called from loop() after the application's work is done. When the
+    window is open it checks for an update, ArduinoOTA.handle() returns
+    right away unless a transfer begins. The transfer is received before
+    it returns, so sampling, the heartbeat and commands stop until it's
+    done. The device restarts if it was successful.
+*/
+void handleOTA()
+{
+    if(otaWaitUntil == 0) return;
+
+    if(timeReached(appMillis(), otaWaitUntil)) openOTA(0);
+    else if((connWiFi != NULL) && connWiFi->IsConnected()) ArduinoOTA.handle();
+}
+
+/*
+    The size, duration and throughput of the last transfer
+*/
+String otaXferStats()
+{
+unsigned long ms = timeSince(millis(), otaXferStart);
 
-    return false;
+    return String(otaXferBytes) + " bytes in " + String(ms) + " ms, " + String(ms > 0 ? (unsigned long)(((uint64_t)otaXferBytes * 1000) / ms) : 0UL) + " B/s";
 }
 
 #ifdef __cplusplus
 }
 #endif
+#endif // USE_OTA
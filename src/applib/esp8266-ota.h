@@ -2,16 +2,33 @@
 /*
    esp8266-ota.h - support for OTA updates
 
+   OTA runs alongside the application. It only listens for an update while
+   its window is open, the window is opened for `otadur` when the device
+   starts and can be opened again with the `O` command. Sampling continues
+   while the window is open. A transfer is received within handleOTA(),
+   which doesn't return until it's done, so the loop stops (no sampling,
+   no heartbeat, no commands) until the transfer ends or fails.
 */
 #pragma once
 
+// disabled OTA due to unreliability in regards to
+// seeing the device on the Arduino IDE
+//#define USE_OTA
+
+#ifdef USE_OTA
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 extern void initOTA();
-extern bool waitForOTA();
+extern bool openOTA(unsigned long dur);
+extern unsigned long getOTAWindow();
+extern unsigned long getOTADuration();
+extern void handleOTA();
 
 #ifdef __cplusplus
 }
 #endif
+
+#endif // USE_OTA
@@ -0,0 +1,204 @@
+/* ************************************************************************ */
+/*
+    esp8266-prof.cpp - loop latency and yield-gap instrumentation.
+
+    Each report is sent as one UDP packet per phase - 
+
+        {"dev_id":"ESP_49ECF6","prof":0,"n":5873,"max":271453,"gap":271602,"irq":4512,"b0":4,"hist":[5790,12,0,1,...]}
+
+    Where "prof" is the phase number, "n" is the number of samples, "max"
+    is the longest duration in microseconds, "b0" is the index of the 
+    first bucket in "hist" (leading empty buckets are not sent). "gap" is
+    the longest time between the start of one loop() and the start of 
+    the next (the longest the application went without yielding to the 
+    system, it includes any delay() calls) and "irq" is the longest time 
+    that interrupts were disabled. Those two are only sent for PROF_LOOP.
+
+    If the buckets don't all fit in one packet the histogram is sent in
+    parts, each one has the buckets from its own "b0" on. "part" is the
+    packet's number from 0 and "parts" is the number of them, "gap" and
+    "irq" are only in part 0 (and with a long device ID they might be 
+    all that's in it) -
+
+        {"dev_id":"ESP_49ECF6","prof":0,"n":5873,"max":271453,"gap":271602,"irq":4512,"b0":0,"hist":[...],"part":0,"parts":2}
+        {"dev_id":"ESP_49ECF6","prof":0,"n":5873,"max":271453,"b0":11,"hist":[...],"part":1,"parts":2}
+*/
+#include "esp8266-ino.h"
+#include "esp8266-prof.h"
+#include "esp8266-log.h"
+
+#ifdef LOOP_PROFILE
+#include "../adafruit/DHT.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+class profphase {
+    public:
+        uint32_t start = 0;
+        uint32_t count = 0;
+        uint32_t maxus = 0;
+        uint32_t hist[PROF_BUCKETS] = {};
+};
+
+profphase phases[PROF_PHASES];
+
+// longest time between loop() starts
+uint32_t loopGap = 0;
+uint32_t lastLoopStart = 0;
+
+unsigned long nextReport = PROF_REPORT_INTERVAL;
+
+char profBuffer[UDP_PAYLOAD_SIZE_WRITE];
+
+// room kept at the end of profBuffer for ],"part":NN,"parts":NN}
+#define PROF_TAIL_SIZE  24
+
+/*
+    Convert a duration (microseconds) into a histogram bucket index
+*/
+int profBucket(uint32_t us)
+{
+    int bucket = (us == 0 ? 0 : (32 - __builtin_clz(us)));
+    return (bucket < PROF_BUCKETS ? bucket : (PROF_BUCKETS - 1));
+}
+
+void profBegin(int phase)
+{
+    phases[phase].start = ESP.getCycleCount();
+
+    if(phase == PROF_LOOP)
+    {
+        if(lastLoopStart != 0)
+        {
+            uint32_t gap = (phases[phase].start - lastLoopStart) / clockCyclesPerMicrosecond();
+            if(gap > loopGap) loopGap = gap;
+        }
+        lastLoopStart = phases[phase].start;
+    }
+}
+
+void profEnd(int phase)
+{
+    uint32_t us = (ESP.getCycleCount() - phases[phase].start) / clockCyclesPerMicrosecond();
+    int bucket = profBucket(us);
+
+    phases[phase].count += 1;
+    if(us > phases[phase].maxus) phases[phase].maxus = us;
+    phases[phase].hist[bucket] += 1;
+}
+
+/*
+    Format one packet of a phase's histogram, from bucket `first` up to
+    `last` or as many as fit. `head` is true for the first packet, it 
+    has "gap" and "irq" and if no bucket fits after them they are sent
+    on their own. `next` is set to the first bucket that wasn't included.
+    Returns the length without the closing brace, or 0 if there's no 
+    room for the histogram.
+*/
+int profFormat(int phase, int first, int last, bool head, int &next)
+{
+profphase &p = phases[phase];
+int room = sizeof(profBuffer) - PROF_TAIL_SIZE;
+int base;
+int len;
+int ix;
+int n;
+
+    next = first;
+    len = snprintf(profBuffer, room, "{\"dev_id\":\"%s\",\"prof\":%d,\"n\":%u,\"max\":%u",
+                   devID, phase, p.count, p.maxus);
+
+    if((phase == PROF_LOOP) && head && (len < room))
+    {
+        len += snprintf(&profBuffer[len], room - len, ",\"gap\":%u,\"irq\":%u",
+                        loopGap, (uint32_t)(InterruptLock::maxCycles / clockCyclesPerMicrosecond()));
+    }
+    if(len >= room) return 0;
+    base = len;
+
+    len += snprintf(&profBuffer[len], room - len, ",\"b0\":%d,\"hist\":[", first);
+
+    // the buckets that fit, a bucket that doesn't is not sent cut short
+    for(ix = first; (len < room) && (ix <= last); ix++)
+    {
+        n = snprintf(&profBuffer[len], room - len, (ix == first ? "%u" : ",%u"), p.hist[ix]);
+        if(n >= (room - len)) break;
+        len += n;
+    }
+
+    if(ix == first)
+    {
+        profBuffer[base] = '\0';
+        return ((phase == PROF_LOOP) && head ? base : 0);
+    }
+    next = ix;
+    profBuffer[len++] = ']';
+    profBuffer[len] = '\0';
+    return len;
+}
+
+/*
+    Format and send one phase, in as many packets as it takes. Returns
+    the number of packets sent.
+*/
+int profSend(int phase)
+{
+profphase &p = phases[phase];
+int first = 0;
+int last = PROF_BUCKETS - 1;
+int parts = 0;
+int part;
+int sent = 0;
+int len;
+int ix;
+
+    // skip the empty buckets at either end
+    while((first < last) && (p.hist[first] == 0)) first++;
+    while((last > first) && (p.hist[last] == 0)) last--;
+
+    // count the packets first, each one says how many there are
+    for(ix = first; ix <= last; parts++)
+    {
+        if(profFormat(phase, ix, last, (parts == 0), ix) == 0)
+        {
+            LOG_WARN("profSend() - phase %d, no room for the histogram", phase);
+            return 0;
+        }
+    }
+
+    for(part = 0, ix = first; part < parts; part++)
+    {
+        len = profFormat(phase, ix, last, (part == 0), ix);
+        if(parts > 1) len += snprintf(&profBuffer[len], sizeof(profBuffer) - len, ",\"part\":%d,\"parts\":%d}", part, parts);
+        else len += snprintf(&profBuffer[len], sizeof(profBuffer) - len, "}");
+
+        if(sendUDP(profBuffer, len) > 0) sent += 1;
+    }
+    return sent;
+}
+
+/*
+    Send the histograms if it's time, and start over
+*/
+void profReport()
+{
+    if(!timeReached(appMillis(), nextReport)) return;
+
+    for(int ix = 0; ix < PROF_PHASES; ix++)
+    {
+        if(phases[ix].count > 0) profSend(ix);
+        phases[ix] = profphase();
+    }
+    loopGap = 0;
+    InterruptLock::maxCycles = 0;
+
+    nextReport = appMillis() + PROF_REPORT_INTERVAL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // LOOP_PROFILE
@@ -0,0 +1,55 @@
+/* ************************************************************************ */
+/*
+    esp8266-prof.h - loop latency and yield-gap instrumentation.
+
+    Durations are measured with the CPU cycle counter and kept in fixed
+    histograms, one for the whole loop and one for each phase. Bucket N
+    counts durations of 2^(N-1) to (2^N)-1 microseconds, the last bucket
+    also counts anything longer.
+
+    The histograms are sent to the server every PROF_REPORT_INTERVAL and
+    then cleared. See LOOP_PROFILE in prof-defs.h.
+*/
+#pragma once
+
+#include "prof-defs.h"
+
+// the phases that are timed
+#define PROF_LOOP       0   // all of loop()
+#define PROF_READ       1   // sensor read
+#define PROF_SERIAL     2   // serialize the sensor data
+#define PROF_SEND       3   // send the sensor data
+#define PROF_HEART      4   // heartbeat
+#define PROF_OTA        5   // OTA handling
+#define PROF_PHASES     6
+
+#define PROF_BUCKETS    20
+
+// milliseconds between reports
+#define PROF_REPORT_INTERVAL 60000
+
+#ifdef LOOP_PROFILE
+
+#define PROF_BEGIN(phase)   profBegin(phase)
+#define PROF_END(phase)     profEnd(phase)
+#define PROF_REPORT()       profReport()
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void profBegin(int phase);
+extern void profEnd(int phase);
+extern void profReport();
+
+#ifdef __cplusplus
+}
+#endif
+
+#else
+
+#define PROF_BEGIN(phase)
+#define PROF_END(phase)
+#define PROF_REPORT()
+
+#endif
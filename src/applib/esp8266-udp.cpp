@@ -13,6 +13,7 @@
 #include <WiFiUdp.h>
 
 #include "esp8266-ino.h"
+#include "esp8266-log.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,6 +29,9 @@ unsigned char writeBuffer[UDP_PAYLOAD_SIZE_WRITE];
 // Arduino UDP object
 WiFiUDP udp;
 
+// the time that the last packet was sent, see sendSensorData()
+unsigned long lastTransmit = 0;
+
 srvcfg      udpServer;
 clisrvcfg   udpClient;
 
@@ -65,6 +69,10 @@ int iRet = 0;
     }
     if(!checkDebugMute()) Serial.println("initUDP() - success = " + String(success));
 
+    // nothing has been sent yet, the clock might not start at 0 
+    // (SOAK_TEST) and sendSensorData() waits for lastTransmit
+    lastTransmit = appMillis();
+
     if(success) iRet = UDP_PAYLOAD_SIZE;
     else iRet = 0;
 
@@ -105,7 +113,7 @@ int iRet = 0;
         }
     }
 
-    if(!checkDebugMute()) Serial.println("sendUDP() - len = " + String(len));
+    LOG_DBG("sendUDP() - len = %d", len);
 
     // set the entire write buffer contents to 0
     memset(writeBuffer, 0, UDP_PAYLOAD_SIZE_WRITE);
@@ -123,10 +131,11 @@ int iRet = 0;
         // write & send the UDP packet...
         iRet = udp.write(writeBuffer, len);
 
-        if(!checkDebugMute()) Serial.println("sendUDP("+String(iRet)+") - sending to " + udpClient.addr + ":" + udpClient.port);
+        LOG_DBG("sendUDP(%d) - sending to %s:%d", iRet, udpClient.addr.c_str(), udpClient.port);
     
         // finish & send the packet
         if(udp.endPacket() == 0) iRet = -1;
+        lastTransmit = appMillis();
 
     } else memset(writeBuffer, 0, UDP_PAYLOAD_SIZE_WRITE);
 
@@ -141,7 +150,7 @@ int replyUDP(char *payload, int len)
 {
 int iRet = 0;
 
-    if(!checkDebugMute()) Serial.println("replyUDP() - len = " + String(len));
+    LOG_DBG("replyUDP() - len = %d", len);
 
     // set the entire write buffer contents to 0
     memset(writeBuffer, 0, UDP_PAYLOAD_SIZE_WRITE);
@@ -159,10 +168,11 @@ int iRet = 0;
         // write & send the UDP packet...
         iRet = udp.write(writeBuffer, len);
 
-        if(!checkDebugMute()) Serial.println("replyUDP("+String(iRet)+") - reply to " + IPAddress(udp.remoteIP()).toString() + ":" + udp.remotePort());
+        LOG_DBG("replyUDP(%d) - reply to %s:%u", iRet, IPAddress(udp.remoteIP()).toString().c_str(), udp.remotePort());
     
         // finish & send the packet
         if(udp.endPacket() == 0) iRet = -1;
+        lastTransmit = appMillis();
     }
     return iRet;
 }
@@ -193,19 +203,50 @@ int readLen = 0;
     return readLen;
 }
 
+/*
+    Send a UDP packet to a specific address and port. There's no size 
+    limit other than the MTU and nothing is logged, this is used by the
+    log shipper.
+*/
+int sendToUDP(IPAddress ip, int port, char *payload, int len)
+{
+int iRet = 0;
+
+    if(len > 0)
+    {
+        udp.beginPacket(ip, port);
+        iRet = udp.write((uint8_t *)payload, len);
+        if(udp.endPacket() == 0) iRet = -1;
+        lastTransmit = appMillis();
+    }
+    return iRet;
+}
+
+/*
+    The address of the server that sensor data is sent to, it might 
+    have been obtained with REQ_IP.
+*/
+IPAddress getServerIP()
+{
+    return udpClient.ipaddr;
+}
+
 /*
     Send a payload to a multi-cast address
 */
 int multiUDP(char *payload, int len)
 {
 mcastcfg cfg;
+int iRet = 0;
 
     if(m_cfgdat->getCfg(cfg))
     {
         udp.beginPacketMulticast(cfg.ipaddr, cfg.port, WiFi.localIP());
-        udp.write(payload, len);
-        udp.endPacket();
+        iRet = udp.write(payload, len);
+        if(udp.endPacket() == 0) iRet = -1;
+        lastTransmit = appMillis();
     }
+    return iRet;
 }
 
 #ifdef __cplusplus
@@ -5,6 +5,8 @@
 */
 #pragma once
 
+#include <IPAddress.h>
+
 #include "udp-defs.h"
 
 #ifdef __cplusplus
@@ -17,11 +19,15 @@ extern void beginUDP(int port);
 extern int sendUDP(char *payload, int len, char *endpoint = NULL);
 extern int replyUDP(char *payload, int len);
 extern int recvUDP();
+extern int sendToUDP(IPAddress ip, int port, char *payload, int len);
+extern IPAddress getServerIP();
 
 extern int multiUDP(char *payload, int len);
 
 extern unsigned char readBuffer[];
 extern unsigned char writeBuffer[];
+// the appMillis() time of the last packet sent
+extern unsigned long lastTransmit;
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,12 @@
+/*
+    UDP Command Client Configuration
+*/
+module.exports = {
+    // edit the address to match the IP address 
+    // of the device that will be commanded.
+    host : '192.168.0.50',
+    // see UDP_CMD_PORT in udp-defs.h
+    port : 43210,
+    // milliseconds to wait for a reply
+    timeout : 3000
+};
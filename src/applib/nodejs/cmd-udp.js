@@ -0,0 +1,111 @@
+/* ************************************************************************ */
+/*
+    cmd-udp.js - sends commands to a running device and displays the
+    reply. See esp8266-cmd.h for the available commands.
+
+    Usage - 
+
+        node cmd-udp.js "I 60000" [config file]
+
+            Send a single command and display the reply.
+
+        node cmd-udp.js test [config file]
+
+            Run each command (except reboot) against the device and check
+            its reply. The exit code is 0 if all of the checks passed.
+
+    NOTE: The "test" will leave the device with the settings it applies,
+    reboot the device afterwards to restore its configuration.
+*/
+const command = process.argv[2];
+// an option argument can specify an alternative configuration file. 
+var cmdCfgFile = process.argv[3];
+
+if((cmdCfgFile === undefined) || (cmdCfgFile === ''))
+    cmdCfgFile = './cmd-udp-cfg.js';
+
+if((command === undefined) || (command === '')) {
+    console.log('usage: node cmd-udp.js "<command>" | test [config file]');
+    process.exit(1);
+}
+
+// read the IP address and port # of the device
+const cfg = require(cmdCfgFile);
+
+// create a socket for sending commands and receiving replies
+const client = require('dgram').createSocket('udp4');
+
+/*
+    The commands that are ran in "test" mode, and the reply
+    status that's expected for each one.
+*/
+const tests = [
+    {cmd: 'S',       status: 'OK'},
+    {cmd: 'F',       status: 'OK', check: (r) => r.rejected !== undefined},
+    {cmd: 'H',       status: 'OK', check: (r) => Array.isArray(r.fail) && (r.fail.length === 4)},
+    {cmd: 'H R',     status: 'OK', check: (r) => Array.isArray(r.ratio) && (r.ratio.length === 8)},
+    {cmd: 'H X',     status: 'FAIL'},
+    {cmd: 'I 60000', status: 'OK', check: (r) => r.interval === 60000},
+    {cmd: 'I 10',    status: 'FAIL'},
+    {cmd: 'D 5 10',  status: 'OK', check: (r) => (r.delta_t === 5) && (r.delta_h === 10)},
+    {cmd: 'D 5',     status: 'FAIL'},
+    {cmd: 'M ALL',   status: 'OK', check: (r) => r.report === 'ALL'},
+    {cmd: 'M XYZ',   status: 'FAIL'},
+    {cmd: 'M CHG',   status: 'OK', check: (r) => r.report === 'CHG'},
+    {cmd: 'Q 0',     status: 'OK', check: (r) => r.mute === 0},
+    {cmd: 'R',       status: 'OK'},
+    {cmd: 'X',       status: 'UNKNOWN'},
+    {cmd: '1',       status: 'UNKNOWN', check: (r) => r.reply === '?'}
+];
+
+/*
+    Send a command and call `done` with the parsed reply, or with
+    `null` if there was no reply.
+*/
+function sendCmd(cmd, done) {
+    var timer = setTimeout(() => {
+        client.removeAllListeners('message');
+        done(null);
+    }, cfg.timeout);
+
+    client.once('message', (payload, remote) => {
+        clearTimeout(timer);
+        var message = payload.filter(letter => letter !== 0).toString();
+        console.log(`reply : [${message}] from ${remote.address}:${remote.port}`);
+        try {
+            done(JSON.parse(message));
+        } catch(err) {
+            done(null);
+        }
+    });
+
+    const msg = Buffer.from(cmd);
+    client.send(msg, 0, msg.length, cfg.port, cfg.host, (err) => {
+        if(err) throw err;
+    });
+};
+
+/*
+    Run the tests one after the other, and keep count
+    of the failures.
+*/
+function runTests(ix, failed) {
+    if(ix >= tests.length) {
+        console.log(`${tests.length - failed} of ${tests.length} passed`);
+        process.exit(failed === 0 ? 0 : 1);
+    }
+    sendCmd(tests[ix].cmd, (reply) => {
+        var pass = (reply !== null) && (reply.status === tests[ix].status) && 
+                   ((tests[ix].check === undefined) || tests[ix].check(reply));
+        console.log(`${pass ? 'PASS' : 'FAIL'} - "${tests[ix].cmd}"`);
+        runTests(ix + 1, failed + (pass ? 0 : 1));
+    });
+};
+
+if(command === 'test') runTests(0, 0);
+else {
+    sendCmd(command, (reply) => {
+        if(reply === null) console.log('no reply');
+        process.exit(reply === null ? 1 : 0);
+    });
+}
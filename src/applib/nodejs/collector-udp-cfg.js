@@ -0,0 +1,46 @@
+/*
+    UDP Collector Configuration
+*/
+module.exports = {
+    // sensor data, the "udp1" port in clientcfg.json
+    host : '0.0.0.0',
+    port : 54321,
+    // status messages and REQ_IP, match multicfg.json
+    mcast : {addr : '224.0.0.1', port : 54000},
+    // the address sent in the REQ_IP reply, '' = the first
+    // IPv4 address found on this host
+    ip : '',
+    // parse threads, 0 = one per CPU core. With node 22.12 or later
+    // each one receives the data on its own socket.
+    workers : 0,
+    // bytes in each parse thread's queue of packets
+    ring : 1048576,
+    // the most devices that can be kept in the latest-value table
+    devices : 100000,
+    // the latest-value queries, see collector-udp.js
+    query : {host : '127.0.0.1', port : 54080},
+    // saved readings, see tsdb.js. '' = don't save them. The partly
+    // filled blocks are written every `flush` seconds, they'll be 
+    // lost if the collector stops before then.
+    store : {dir : '', segment : 67108864, flush : 3600},
+    // hourly and daily min/max/mean/last, see rollup.js. Each device
+    // takes (hours + days) x 44 bytes, devices = 0 to turn them off.
+    rollup : {devices : 2000, hours : 336, days : 400},
+    // the sites for the loss counters, each one is a name and a network.
+    // e.g. {name : 'lab', net : '192.168.1.0/24'}, up to 255 sites
+    sites : [],
+    // seconds between throughput reports
+    report : 5,
+    // true = display every message
+    verbose : false,
+
+    // used by "node collector-udp.js bench"
+    bench : {
+        // sending threads
+        senders : 2,
+        // seconds to send
+        duration : 10,
+        // devices per sender, each sender cycles through them
+        devices : 500
+    }
+};
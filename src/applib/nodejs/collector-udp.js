@@ -0,0 +1,538 @@
+/* ************************************************************************ */
+/*
+    collector-udp.js - a collector for a large number of devices.
+
+    Each parse thread has its own socket on the data port (dgram's
+    reusePort, node 22.12 and later), the kernel spreads the devices over
+    them by their address and port. The main thread receives the
+    multi-cast status messages, answers REQ_IP, and passes each one to a
+    parse thread through a shared memory ring. With an older node the
+    main thread receives the sensor data too and passes it on the same
+    way. All packets from a device (its address and port) go to the same
+    parse thread. The parse threads keep
+    the latest reading and status of each device in a shared table (see
+    latest-table.js), which is available from a local HTTP server -
+
+        GET /latest             - all of the devices
+        GET /latest/ESP_49ECF6  - one device, 404 if it's unknown
+
+    The parse threads also keep hourly and daily rollups of each device's
+    readings (see rollup.js) -
+
+        GET /rollup/ESP_49ECF6/hour?from=2025-01-01&to=2025-01-02
+        GET /rollup/ESP_49ECF6/day?from=2025-01-01
+        GET /rollup/ESP_49ECF6?from=2025-01-01T06:00Z&to=2025-03-01
+
+    The first two return the min/max/mean/last of each hour or day, the
+    last one returns them for the whole range. `from` defaults to the
+    oldest bucket and `to` to now.
+
+    Reports that have "boot" and "rseq" are checked for loss, reordering
+    and duplicates (see gap-table.js) -
+
+        GET /loss               - the totals for each site
+        GET /loss/ESP_49ECF6    - one device
+
+    A device's site is found from its address with the `sites` list in
+    the configuration file, addresses that aren't in the list are in the
+    "other" site.
+
+    A device with more than one sensor sends the readings of the others
+    in "p", each of those sensors is kept as its own device with the
+    number added to the device's name, e.g. ESP_49ECF6.1. Its "seq" is
+    the report's "rseq".
+
+    Each response has an X-Query-Us header, the microseconds it took to
+    read the table, the rollups or the counters.
+
+    When `store.dir` is set the readings are also saved (see tsdb.js),
+    each parse thread has its own store in a sub-folder of `store.dir`.
+
+    Messages are classified as -
+
+        data    - {"dev_id":"ESP_49ECF6","seq":1,"t":71.5,"h":37.40}
+        beat    - a heartbeat reading, it also has "last"
+        stats   - a "STATS" mode summary, "n" readings with t and h
+                  as [min, max, mean, stddev]
+        status  - {"dev_id":"ESP_49ECF6","status":"APP_READY",...}
+        prof    - a profiling report, see esp8266-prof.cpp
+        reply   - a reply to a command, see esp8266-cmd.cpp
+        bad     - not valid JSON
+
+    Usage -
+
+        node collector-udp.js [config file]
+
+            Run the collector.
+
+        node collector-udp.js bench [config file]
+
+            Run the collector and a local load generator for a fixed time,
+            then report the throughput and the loss. Run it again with a
+            different number of workers to compare.
+*/
+const dgram = require('dgram');
+const http = require('http');
+const os = require('os');
+const path = require('path');
+const {Worker, isMainThread, workerData, parentPort} = require('worker_threads');
+const LatestTable = require('./latest-table.js');
+const TSStore = require('./tsdb.js');
+const Rollups = require('./rollup.js');
+const GapTable = require('./gap-table.js');
+
+var mode = 'collect';
+var argix = 2;
+
+if(process.argv[2] === 'bench') {
+    mode = 'bench';
+    argix = 3;
+}
+
+// an option argument can specify an alternative configuration file.
+var collCfgFile = process.argv[argix];
+
+if((collCfgFile === undefined) || (collCfgFile === ''))
+    collCfgFile = './collector-udp-cfg.js';
+
+const cfg = require(collCfgFile);
+
+// the first site is for the addresses that aren't in cfg.sites
+const SITES = ['other'].concat(cfg.sites.map(site => site.name));
+
+// the counters kept by each parse thread
+const KINDS = ['data', 'beat', 'stats', 'status', 'prof', 'reply', 'bad'];
+// packets in a ring are from the data port or the status port
+const FROM_DATA = 0;
+const FROM_STATUS = 1;
+// marks the end of the data in the ring, the next packet is at the start
+const RING_WRAP = 0xffff;
+
+// dgram's reusePort, each parse thread can have its own data socket
+function hasReusePort() {
+    var [major, minor] = process.versions.node.split('.').map(Number);
+    return (major > 23) || ((major === 23) && (minor >= 1)) || ((major === 22) && (minor >= 12));
+}
+
+/*
+    Parse a packet, the device's payload might end with a NUL
+*/
+function parse(payload) {
+    var len = payload.length;
+    while((len > 0) && (payload[len - 1] === 0)) len -= 1;
+    try {
+        return JSON.parse(payload.toString('latin1', 0, len));
+    } catch(err) {
+        return null;
+    }
+}
+
+function classify(msg) {
+    if(msg === null) return 'bad';
+    if(msg.status !== undefined) return 'status';
+    if(msg.prof !== undefined) return 'prof';
+    if(msg.reply !== undefined) return 'reply';
+    if(msg.last !== undefined) return 'beat';
+    if(Array.isArray(msg.t) && Array.isArray(msg.h)) return 'stats';
+    return 'data';
+}
+
+/* ************************************************************************ */
+/*
+    Ring - a single producer, single consumer queue of packets in a
+    SharedArrayBuffer. The first 16 bytes are the head (next write) and
+    the tail (next read) offsets, each packet is a 16 bit length, a byte
+    for the port it came to, a byte for the site it came from, and the
+    payload. Packets start on a 4 byte boundary.
+*/
+class Ring {
+    constructor(size) {
+        this.buffer = (size instanceof SharedArrayBuffer ? size : new SharedArrayBuffer(16 + (size & ~3)));
+        this.ptrs = new Int32Array(this.buffer, 0, 4);
+        this.data = Buffer.from(this.buffer, 16);
+        this.size = this.data.length;
+    }
+
+    // returns false if there's no room, the packet is dropped
+    push(payload, from, site) {
+        var head = this.ptrs[0];
+        var tail = Atomics.load(this.ptrs, 1);
+        var need = (4 + payload.length + 3) & ~3;
+        var free = (tail > head ? tail - head : this.size - head + tail) - 4;
+
+        if(head + need > this.size) {
+            // it doesn't fit at the end, start over at the beginning
+            if((tail > head) || (tail < (need + 4))) return false;
+            this.data.writeUInt16LE(RING_WRAP, head);
+            head = 0;
+        } else if(need > free) return false;
+
+        this.data.writeUInt16LE(payload.length, head);
+        this.data[head + 2] = from;
+        this.data[head + 3] = site;
+        payload.copy(this.data, head + 4);
+        Atomics.store(this.ptrs, 0, (head + need) % this.size);
+        Atomics.notify(this.ptrs, 0);
+        return true;
+    }
+
+    // waits up to `ms` for a packet, returns null if there isn't one
+    pop(ms) {
+        var tail = this.ptrs[1];
+        var head = Atomics.load(this.ptrs, 0);
+
+        if(tail === head) {
+            Atomics.wait(this.ptrs, 0, head, ms);
+            head = Atomics.load(this.ptrs, 0);
+            if(tail === head) return null;
+        }
+        var len = this.data.readUInt16LE(tail);
+        if(len === RING_WRAP) {
+            tail = 0;
+            len = this.data.readUInt16LE(0);
+        }
+        var pkt = {from: this.data[tail + 2], site: this.data[tail + 3], payload: Buffer.from(this.data.subarray(tail + 4, tail + 4 + len))};
+        Atomics.store(this.ptrs, 1, (tail + ((4 + len + 3) & ~3)) % this.size);
+        return pkt;
+    }
+}
+
+/* ************************************************************************ */
+/*
+    Parse thread
+*/
+function runParser() {
+    const ring = new Ring(workerData.ring);
+    const table = new LatestTable(workerData.table);
+    const counts = new Int32Array(workerData.counts);
+    const rollups = (workerData.rollups === null ? null : new Rollups(table, workerData.rollups));
+    const gaps = new GapTable(table, workerData.gaps);
+    var store = null;
+    var flushed = Date.now();
+
+    if(cfg.store.dir !== '') store = new TSStore(path.join(cfg.store.dir, 'p' + workerData.index), {segment: cfg.store.segment});
+
+    // write the partly filled blocks now and then
+    function flush() {
+        if((store !== null) && ((Date.now() - flushed) >= (cfg.store.flush * 1000))) {
+            store.flush();
+            flushed = Date.now();
+        }
+    }
+
+    if(workerData.receive) {
+        // the ring only has the status messages, it's emptied often
+        // enough that this thread is free to receive the data
+        const server = dgram.createSocket({type: 'udp4', reusePort: true});
+        server.on('error', (err) => {
+            console.log(err.stack);
+            process.exit(1);
+        });
+        server.on('message', (payload, rinfo) => handle({from: FROM_DATA, site: siteOf(rinfo.address), payload: payload}));
+        server.bind(cfg.port, cfg.host);
+        setInterval(() => {
+            var pkt;
+            while((pkt = ring.pop(0)) !== null) handle(pkt);
+            flush();
+        }, 50);
+        return;
+    }
+
+    for(;;) {
+        var pkt = ring.pop(1000);
+
+        flush();
+        if(pkt !== null) handle(pkt);
+    }
+
+    function handle(pkt) {
+        var msg = parse(pkt.payload);
+        var kind = classify(msg);
+
+        // the end of a fleet-udp.js run, it isn't from a device
+        if((msg !== null) && (msg.fleet !== undefined)) return;
+
+        Atomics.add(counts, KINDS.indexOf(kind), 1);
+        if(cfg.verbose) console.log(`${kind} - ${pkt.payload.toString('latin1')}`);
+
+        if((msg === null) || (typeof msg.dev_id !== 'string')) return;
+        if((kind === 'data') || (kind === 'beat')) {
+            var now = Date.now();
+            // a report with only the other sensors' readings has no "t"
+            if(msg.t !== undefined) {
+                var t10 = Math.round(msg.t * 10);
+                var h10 = Math.round(msg.h * 10);
+                table.update(msg.dev_id, msg.seq, msg.t, msg.h, undefined, now);
+                if(store !== null) store.append(msg.dev_id, now, msg.seq, t10, h10);
+                if(rollups !== null) rollups.add(msg.dev_id, now, t10, h10);
+            }
+            // each of the other sensors is a device of its own, "ESP_49ECF6.1"
+            if(Array.isArray(msg.p)) msg.p.forEach(([num, t, h]) => {
+                var id = `${msg.dev_id}.${num}`;
+                var t10 = Math.round(t * 10);
+                var h10 = Math.round(h * 10);
+                table.update(id, msg.rseq, t, h, undefined, now);
+                if(store !== null) store.append(id, now, msg.rseq, t10, h10);
+                if(rollups !== null) rollups.add(id, now, t10, h10);
+            });
+            if((msg.boot !== undefined) && (msg.rseq !== undefined)) gaps.add(msg.dev_id, msg.boot >>> 0, msg.rseq >>> 0, pkt.site);
+        }
+        else if(kind === 'stats') {
+            var now = Date.now();
+            var [tmin, tmax, tmean] = msg.t.map(v => Math.round(v * 10));
+            var [hmin, hmax, hmean] = msg.h.map(v => Math.round(v * 10));
+            // the mean stands in for the reading
+            table.update(msg.dev_id, msg.seq, tmean / 10, hmean / 10, undefined, now);
+            if(store !== null) store.append(msg.dev_id, now, msg.seq, tmean, hmean);
+            if(rollups !== null) rollups.addSummary(msg.dev_id, now, msg.n, tmin, tmax, tmean, hmin, hmax, hmean);
+            if((msg.boot !== undefined) && (msg.rseq !== undefined)) gaps.add(msg.dev_id, msg.boot >>> 0, msg.rseq >>> 0, pkt.site);
+        }
+        else if(kind === 'status') table.update(msg.dev_id, undefined, 0, 0, msg.status, Date.now());
+    }
+}
+
+/* ************************************************************************ */
+/*
+    Main thread - receive, answer REQ_IP, queries and reports
+*/
+function findIP() {
+    if(cfg.ip !== '') return cfg.ip;
+
+    var nifs = os.networkInterfaces();
+    for(var name in nifs) {
+        for(var ix = 0; ix < nifs[name].length; ix++) {
+            if((nifs[name][ix].family === 'IPv4') && !nifs[name][ix].internal) return nifs[name][ix].address;
+        }
+    }
+    return '127.0.0.1';
+}
+
+// IPv4 address to an unsigned integer
+function ipToInt(addr) {
+    return addr.split('.').reduce((acc, part) => (acc * 256) + (parseInt(part) & 0xff), 0);
+}
+
+const siteNets = cfg.sites.map((site) => {
+    var [net, bits] = site.net.split('/');
+    var mask = (bits === undefined ? 0xffffffff : (parseInt(bits) === 0 ? 0 : (0xffffffff << (32 - parseInt(bits))) >>> 0));
+    return {net: (ipToInt(net) & mask) >>> 0, mask: mask};
+});
+const siteCache = new Map();
+
+// the site of an address, an index into SITES
+function siteOf(addr) {
+    var site = siteCache.get(addr);
+    if(site === undefined) {
+        var ip = ipToInt(addr);
+        site = siteNets.findIndex(entry => ((ip & entry.mask) >>> 0) === entry.net) + 1;
+        siteCache.set(addr, site);
+    }
+    return site;
+}
+
+// pick the parse thread for a device
+function route(rinfo, count) {
+    var hash = rinfo.port;
+    for(var ix = 0; ix < rinfo.address.length; ix++) hash = Math.imul(hash ^ rinfo.address.charCodeAt(ix), 0x01000193);
+    return (hash >>> 0) % count;
+}
+
+// a query parameter as milliseconds, a date or a number
+function queryTime(url, name, dflt) {
+    var value = url.searchParams.get(name);
+    if(value === null) return dflt;
+    return (/^\d+$/.test(value) ? parseInt(value) : Date.parse(value));
+}
+
+function startQuery(table, rollups, gaps) {
+    const server = http.createServer((req, res) => {
+        var start = process.hrtime.bigint();
+        var url = new URL(req.url, 'http://localhost');
+        var parts = url.pathname.split('/').filter(part => part !== '');
+        var body = null;
+
+        if((parts.length === 1) && (parts[0] === 'latest')) body = table.snapshot();
+        else if((parts.length === 2) && (parts[0] === 'latest')) body = table.get(decodeURIComponent(parts[1]));
+        else if((rollups !== null) && (parts[0] === 'rollup') && (parts.length >= 2) && (parts.length <= 3)) {
+            var from = queryTime(url, 'from', 0);
+            var to = queryTime(url, 'to', Date.now());
+            var id = decodeURIComponent(parts[1]);
+            if(isNaN(from) || isNaN(to)) body = null;
+            else if(parts.length === 2) body = rollups.summary(id, from, to);
+            else if((parts[2] === 'hour') || (parts[2] === 'day')) body = rollups.query(id, parts[2], from, to);
+        } else if((parts.length === 1) && (parts[0] === 'loss')) body = gaps.sites(SITES);
+        else if((parts.length === 2) && (parts[0] === 'loss')) {
+            body = gaps.get(decodeURIComponent(parts[1]));
+            if(body !== null) body.site = SITES[body.site];
+        }
+
+        var usecs = Number(process.hrtime.bigint() - start) / 1000;
+        if(body === null) {
+            res.writeHead(404, {'X-Query-Us': usecs.toFixed(1)});
+            res.end();
+            return;
+        }
+        res.writeHead(200, {'Content-Type': 'application/json', 'X-Query-Us': usecs.toFixed(1)});
+        res.end(JSON.stringify(body));
+    });
+    server.listen(cfg.query.port, cfg.query.host);
+}
+
+function runMain() {
+    const nworkers = (cfg.workers > 0 ? cfg.workers : os.cpus().length);
+    const hostip = findIP();
+    const table = new LatestTable(cfg.devices);
+    const rollups = (cfg.rollup.devices > 0 ? new Rollups(table, cfg.rollup) : null);
+    const gaps = new GapTable(table);
+    const rings = [];
+    const counts = [];
+    const receive = hasReusePort();
+    var dropped = 0;
+    var lastsum = 0;
+
+    for(var ix = 0; ix < nworkers; ix++) {
+        rings.push(new Ring(cfg.ring));
+        counts.push(new Int32Array(new SharedArrayBuffer(KINDS.length * 4)));
+        new Worker(__filename, {argv: process.argv.slice(2),
+                                workerData: {role: 'parser', index: ix, receive: receive, ring: rings[ix].buffer, table: table.buffer, counts: counts[ix].buffer,
+                                             rollups: (rollups === null ? null : rollups.buffer), gaps: gaps.buffer}});
+    }
+
+    function totals() {
+        var sum = {all: 0, dropped: dropped};
+        KINDS.forEach((kind, ix) => {
+            sum[kind] = counts.reduce((acc, list) => acc + Atomics.load(list, ix), 0);
+            sum.all += sum[kind];
+        });
+        return sum;
+    }
+
+    // the parse threads receive the data themselves if they can
+    const server = (receive ? null : dgram.createSocket('udp4'));
+    if(server !== null) {
+        server.on('error', (err) => {
+            console.log(err.stack);
+            process.exit(1);
+        });
+        server.on('message', (payload, rinfo) => {
+            if(!rings[route(rinfo, nworkers)].push(payload, FROM_DATA, siteOf(rinfo.address))) dropped += 1;
+        });
+    }
+    function listening() {
+        mcast.bind(cfg.mcast.port);
+        startQuery(table, rollups, gaps);
+        console.log(`collector listening ${cfg.host}:${cfg.port} with ${nworkers} parse threads, data received by the ${receive ? 'parse threads' : 'main thread'}, ` +
+                    `REQ_IP replies with ${hostip}, queries at http://${cfg.query.host}:${cfg.query.port}/latest`);
+        if(mode === 'bench') runBench(totals, table);
+    }
+
+    const mcast = dgram.createSocket({type: 'udp4', reuseAddr: true});
+    mcast.on('listening', () => {
+        try {
+            mcast.addMembership(cfg.mcast.addr);
+        } catch(err) {
+            console.log(`can't join ${cfg.mcast.addr} - ${err.message}`);
+        }
+    });
+    mcast.on('message', (payload, remote) => {
+        var msg = parse(payload);
+
+        // the reply format is in ParseIPReply.cpp
+        if((msg !== null) && (msg.status === 'REQ_IP')) {
+            var reply = Buffer.from(JSON.stringify({reply: 'IP_ADDR', ip: hostip, port: cfg.port}));
+            mcast.send(reply, 0, reply.length, parseInt(msg.msg) || remote.port, remote.address);
+        }
+        if(!rings[route(remote, nworkers)].push(payload, FROM_STATUS, siteOf(remote.address))) dropped += 1;
+    });
+
+    if(receive) listening();
+    else server.bind(cfg.port, cfg.host, listening);
+
+    if(mode !== 'bench') {
+        setInterval(() => {
+            var sum = totals();
+            console.log(`${((sum.all - lastsum) / cfg.report).toFixed(0)} pkt/s - data ${sum.data}  beat ${sum.beat}  stats ${sum.stats}  status ${sum.status}  prof ${sum.prof}  reply ${sum.reply}  bad ${sum.bad}  dropped ${sum.dropped}`);
+            lastsum = sum.all;
+        }, cfg.report * 1000);
+    }
+}
+
+/* ************************************************************************ */
+/*
+    Benchmark - sender threads in this process
+*/
+function runBench(totals, table) {
+    var sent = 0;
+    var done = 0;
+    var start = Date.now();
+
+    for(var ix = 0; ix < cfg.bench.senders; ix++) {
+        var sender = new Worker(__filename, {argv: process.argv.slice(2), workerData: {role: 'sender', sender: ix}});
+        sender.on('message', (count) => {
+            sent += count;
+            if(++done === cfg.bench.senders) finish();
+        });
+    }
+
+    function finish() {
+        var elapsed = (Date.now() - start) / 1000;
+
+        // let the parse threads catch up
+        setTimeout(() => {
+            var sum = totals();
+            var received = sum.all;
+            console.log(`sent ${sent} in ${elapsed.toFixed(1)}s (${(sent / elapsed).toFixed(0)} pkt/s)`);
+            console.log(`parsed ${received} (${(received / elapsed).toFixed(0)} pkt/s) from ${table.snapshot().length} devices, dropped ${sum.dropped} in the rings, lost ${sent - received} (${(((sent - received) * 100) / Math.max(sent, 1)).toFixed(2)}%)`);
+            console.log(`data ${sum.data}  beat ${sum.beat}  bad ${sum.bad}`);
+            process.exit(0);
+        }, 1000);
+    }
+}
+
+/*
+    A sending thread, it cycles through its devices sending data and
+    heartbeat messages as fast as the sockets will take them. Each
+    device has its own socket so that the devices are spread over
+    the parse threads.
+*/
+function runSender() {
+    const devices = [];
+    const end = Date.now() + (cfg.bench.duration * 1000);
+    var count = 0;
+    var next = 0;
+    var bound = 0;
+
+    for(var ix = 0; ix < cfg.bench.devices; ix++) {
+        var id = 'ESP_' + ((workerData.sender << 16) + ix).toString(16).toUpperCase().padStart(6, '0');
+        var msg = {dev_id: id, seq: ix, t: '71.50', h: '37.40'};
+        var data = Buffer.from(JSON.stringify(msg));
+        msg.last = {t: '71.40', h: '37.50'};
+        var sock = dgram.createSocket('udp4');
+        devices.push({sock: sock, packets: [data, Buffer.from(JSON.stringify(msg))]});
+        sock.bind(0, () => {
+            if(++bound === cfg.bench.devices) burst();
+        });
+    }
+
+    function burst() {
+        if(Date.now() >= end) {
+            devices.forEach((dev) => dev.sock.close());
+            parentPort.postMessage(count);
+            return;
+        }
+        for(var ix = 0; ix < 64; ix++) {
+            var dev = devices[next % devices.length];
+            // skip a device whose socket is still busy
+            if(dev.sock.getSendQueueCount() === 0) {
+                dev.sock.send(dev.packets[count & 1], cfg.port, '127.0.0.1');
+                count += 1;
+            }
+            next += 1;
+        }
+        setImmediate(burst);
+    }
+}
+
+if(isMainThread) runMain();
+else if(workerData.role === 'parser') runParser();
+else runSender();
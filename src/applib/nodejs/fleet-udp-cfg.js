@@ -0,0 +1,53 @@
+/*
+    Fleet Load Generator Configuration
+*/
+module.exports = {
+    // the number of devices, each one has its own 127.x.y.z address
+    devices : 1000,
+    // devices per host-device process, they run one at a time
+    // so a process uses one core
+    perproc : 250,
+    // milliseconds between passes through a device's loop()
+    loop : 100,
+    // seconds over which the devices are started
+    ramp : 10,
+    // seconds to run, 0 = until Ctrl-C
+    duration : 120,
+    // seconds between progress reports
+    report : 5,
+
+    // the application built for the host, see "Host Build" in
+    // the README. The path is relative to this folder.
+    device : '../../../host/build/host-device',
+    // the config files for the devices are written here
+    cfgdir : require('os').tmpdir() + '/fleet-udp',
+
+    // where the data is sent until a device has discovered the
+    // server. The devices always send REQ_IP, see queryServer().
+    collector : {host : '127.0.0.1', port : 54321},
+    // where the devices send their status messages and REQ_IP. The
+    // host build sends multicast as unicast, so this is the sink's
+    // address.
+    mcast : {addr : '127.0.0.1', port : 54000},
+
+    // the sensor settings, written to each device's sensorcfg.json.
+    // The interval can be shortened to simulate a larger fleet.
+    sensor : {
+        interval : 60000,
+        error_interval : 5000,
+        // quick re-reads after a failed reading
+        retries : 2,
+        // milliseconds from start up to the first reading
+        warmup : 2000,
+        scale : 'F',
+        report : 'CHG',
+        delta_t : 5,
+        delta_h : 5,
+        // percent of readings that fail with a bad checksum
+        nanrate : 1
+    },
+
+    // used by "node fleet-udp.js sink", it counts the packets sent
+    // to the collector port and answers REQ_IP
+    sink : {host : '0.0.0.0', ip : '127.0.0.1'}
+};
@@ -0,0 +1,299 @@
+/* ************************************************************************ */
+/*
+    fleet-udp.js - a load generator, it runs a fleet of devices against
+    a collector.
+
+    Each device is the application itself built for the host (see "Host
+    Build" in the README). A host-device process runs a block of them
+    (`perproc`), each one with its own copy of the application's state.
+    Each device has its own 127.x.y.z address and hostname (its device
+    ID), and they share a set of config files that are written from this
+    configuration. The devices discover the server with REQ_IP, then send
+    their readings, heartbeats and status messages the same way a real
+    device does.
+
+    Usage -
+
+        node fleet-udp.js [config file]
+
+            Run the fleet. The number of devices that have discovered
+            the server is reported while it runs, with the percentiles
+            of the time it took them (p50, p99 and p100). When it stops
+            each device reports how many packets it sent to the
+            collector, the fleet adds them up and tells the collector.
+
+        node fleet-udp.js sink [config file]
+
+            Count the packets that arrive at the collector port and
+            answer REQ_IP. When the fleet stops the sink reports the
+            loss.
+
+    NOTE: Build the host application first -
+
+        cmake -S host -B host/build && cmake --build host/build
+*/
+const dgram = require('dgram');
+const fs = require('fs');
+const path = require('path');
+const spawn = require('child_process').spawn;
+
+var mode = 'fleet';
+var argix = 2;
+
+if(process.argv[2] === 'sink') {
+    mode = 'sink';
+    argix = 3;
+}
+
+// an option argument can specify an alternative configuration file.
+var fleetCfgFile = process.argv[argix];
+
+if((fleetCfgFile === undefined) || (fleetCfgFile === ''))
+    fleetCfgFile = './fleet-udp-cfg.js';
+
+const cfg = require(fleetCfgFile);
+
+// see UDP_CMD_PORT in esp8266-udp.h, the device listens
+// for the reply to REQ_IP on it
+const UDP_CMD_PORT = 43210;
+
+/* ************************************************************************ */
+/*
+    Fleet
+*/
+var started = 0;
+
+// the device's address, 127.1.0.1 and up. host-device gives the
+// devices in a block the addresses that follow the first one.
+function deviceAddr(index) {
+    var addr = 0x7F010001 + index;
+    return [addr >>> 24, (addr >>> 16) & 0xFF, (addr >>> 8) & 0xFF, addr & 0xFF].join('.');
+}
+
+// the device IDs are this followed by the low 3 bytes of the address
+const DEVICE_NAME = 'ESP_';
+
+// the config files that the devices read, see setupConfig()
+function writeConfig(dir) {
+    var files = {
+        'appcfg.json': {appname: 'fleet-udp', debugmute: true, wificonfig: '/wificfg.json', clientconfig: '/clientcfg.json',
+                        mcastconfig: '/multicfg.json', sensorconfig: '/sensorcfg.json'},
+        'wificfg.json': {apoints: [{ssid: 'host', pass: 'host'}], apcount: 1},
+        'clientcfg.json': {udp1: {addr: cfg.collector.host, port: cfg.collector.port},
+                           udp2: {addr: cfg.collector.host, port: cfg.collector.port},
+                           log: {addr: cfg.collector.host, port: 0}},
+        'multicfg.json': {addr: cfg.mcast.addr, port: cfg.mcast.port},
+        'sensorcfg.json': {type: 'DHT22', pin: 'D6', scale: cfg.sensor.scale, interval: cfg.sensor.interval,
+                           error_interval: cfg.sensor.error_interval, retries: cfg.sensor.retries, warmup: cfg.sensor.warmup,
+                           report: cfg.sensor.report, delta_t: cfg.sensor.delta_t, delta_h: cfg.sensor.delta_h}
+    };
+
+    fs.mkdirSync(dir, {recursive: true});
+    Object.keys(files).forEach((name) => fs.writeFileSync(path.join(dir, name), JSON.stringify(files[name], null, 4)));
+}
+
+// the p50, p99 and p100 of a list of milliseconds
+function percentiles(times) {
+    var sorted = times.slice().sort((a, b) => a - b);
+    var pick = (p) => sorted[Math.max(Math.ceil((p / 100) * sorted.length) - 1, 0)];
+
+    if(sorted.length === 0) return 'none yet';
+    return `p50 ${pick(50)}ms, p99 ${pick(99)}ms, p100 ${pick(100)}ms`;
+}
+
+/*
+    A host-device process that runs `count` devices, starting with
+    device number `first`
+*/
+class Block {
+    constructor(first, count, exe, dir) {
+        this.first = first;
+        this.count = count;
+        this.exe = exe;
+        this.dir = dir;
+        this.proc = null;
+        this.partial = '';
+        // milliseconds to discover the server, by device ID
+        this.discover = {};
+        // {dev_id, sent, failed} from each device when it stops
+        this.results = [];
+    }
+
+    start(ramp) {
+        this.proc = spawn(this.exe, ['-f', this.dir, '-i', deviceAddr(this.first), '-n', DEVICE_NAME, '-d', String(this.count),
+                                     '-l', String(cfg.loop), '-r', String(ramp), '-b', String(cfg.sensor.nanrate),
+                                     '-c', String(cfg.collector.port)],
+                          {stdio: ['ignore', 'pipe', 'inherit']});
+        this.proc.stdout.on('data', (data) => {
+            var lines = (this.partial + data.toString()).split('\n');
+            this.partial = lines.pop();
+            lines.forEach((line) => this.line(line.trim()));
+        });
+        this.proc.on('exit', () => {
+            this.line(this.partial.trim());
+            this.proc = null;
+        });
+    }
+
+    // the lines that aren't from host-device are the devices' output
+    line(line) {
+        var msg;
+        if(!line.startsWith('{"dev_id"')) return;
+        try {
+            msg = JSON.parse(line);
+        } catch(err) {
+            return;
+        }
+        if(msg.discover !== undefined) this.discover[msg.dev_id] = msg.discover;
+        else if(msg.sent !== undefined) this.results.push(msg);
+    }
+
+    running() {
+        return (this.proc !== null);
+    }
+
+    stop() {
+        if(this.proc !== null) this.proc.kill('SIGTERM');
+    }
+}
+
+function runFleet() {
+    var exe = path.resolve(__dirname, cfg.device);
+    var blocks = [];
+    var reporter;
+    var stopping = false;
+    var count = Math.ceil(cfg.devices / cfg.perproc);
+
+    if(!fs.existsSync(exe)) {
+        console.log(`${exe} not found, build the host application first - cmake -S host -B host/build && cmake --build host/build`);
+        process.exit(1);
+    }
+    writeConfig(cfg.cfgdir);
+
+    // each block starts its devices over its share of the ramp
+    started = Date.now();
+    for(var ix = 0; ix < count; ix++) {
+        var first = ix * cfg.perproc;
+        var block = new Block(first, Math.min(cfg.perproc, cfg.devices - first), exe, cfg.cfgdir);
+        blocks.push(block);
+        setTimeout(block.start.bind(block, Math.floor((cfg.ramp * 1000) / count)), (cfg.ramp * 1000 * ix) / count);
+    }
+    console.log(`fleet of ${cfg.devices} in ${count} processes started, REQ_IP to ${cfg.mcast.addr}:${cfg.mcast.port}, collector port ${cfg.collector.port}`);
+
+    function discovered() {
+        return blocks.reduce((all, block) => all.concat(Object.values(block.discover)), []);
+    }
+
+    reporter = setInterval(() => {
+        var times = discovered();
+        console.log(`${((Date.now() - started) / 1000).toFixed(0)}s - ${blocks.filter((block) => block.running()).length}/${count} processes, ` +
+                    `${times.length}/${cfg.devices} devices discovered the server, ${percentiles(times)}`);
+    }, cfg.report * 1000);
+
+    // tell the collector how many packets it should have received,
+    // it will be ignored if it isn't a sink
+    function finish() {
+        var elapsed = (Date.now() - started) / 1000;
+        var results = blocks.reduce((all, block) => all.concat(block.results), []);
+        var sent = results.reduce((sum, r) => sum + r.sent, 0);
+        var failed = results.reduce((sum, r) => sum + r.failed, 0);
+        var times = discovered();
+
+        console.log(`discovery - ${times.length}/${cfg.devices} devices, ${percentiles(times)}`);
+        console.log(`sent ${sent} packets to the collector in ${elapsed.toFixed(1)}s, ${(sent / elapsed).toFixed(1)} pkt/s average, ` +
+                    `${failed} send errors, ${results.length}/${cfg.devices} devices reported`);
+
+        var sock = dgram.createSocket('udp4');
+        var msg = Buffer.from(JSON.stringify({fleet: 'END', sent: sent}));
+        sock.send(msg, 0, msg.length, cfg.collector.port, cfg.collector.host, () => process.exit(0));
+    }
+
+    function stop() {
+        if(stopping) return;
+        stopping = true;
+        clearInterval(reporter);
+        blocks.forEach((block) => block.stop());
+
+        // wait for the devices to report, at most 5 seconds
+        var waited = 0;
+        var waiting = setInterval(() => {
+            waited += 100;
+            if(blocks.some((block) => block.running()) && (waited < 5000)) return;
+            clearInterval(waiting);
+            blocks.forEach((block) => { if(block.running()) block.proc.kill('SIGKILL'); });
+            finish();
+        }, 100);
+    }
+
+    if(cfg.duration > 0) setTimeout(stop, cfg.duration * 1000);
+    process.on('SIGINT', stop);
+    process.on('SIGTERM', stop);
+}
+
+/* ************************************************************************ */
+/*
+    Sink - counts what the fleet sends to the collector port
+*/
+function runSink() {
+    var count = 0;
+    var lastcount = 0;
+    var devices = {};
+    var answered = 0;
+    var data = dgram.createSocket('udp4');
+    var mcast = dgram.createSocket({type: 'udp4', reuseAddr: true});
+
+    data.on('message', (payload, remote) => {
+        var msg;
+        try {
+            msg = JSON.parse(payload.toString());
+        } catch(err) {
+            return;
+        }
+        if(msg.fleet === 'END') {
+            var lost = msg.sent - count;
+            console.log(`fleet END - sent ${msg.sent}, received ${count}, lost ${lost} (${((lost * 100) / Math.max(msg.sent, 1)).toFixed(2)}%) from ${Object.keys(devices).length} devices`);
+            count = lastcount = 0;
+            devices = {};
+            return;
+        }
+        count += 1;
+        devices[msg.dev_id] = true;
+    });
+
+    // answer REQ_IP with our address and the collector port, the
+    // device waits for it on UDP_CMD_PORT
+    mcast.on('message', (payload, remote) => {
+        var msg;
+        try {
+            msg = JSON.parse(payload.toString());
+        } catch(err) {
+            return;
+        }
+        if(msg.status !== 'REQ_IP') return;
+        var reply = Buffer.from(JSON.stringify({reply: 'IP_ADDR', ip: cfg.sink.ip, port: cfg.collector.port}));
+        mcast.send(reply, 0, reply.length, UDP_CMD_PORT, remote.address);
+        answered += 1;
+    });
+
+    mcast.on('listening', () => {
+        var first = parseInt(cfg.mcast.addr.split('.')[0]);
+        if((first < 224) || (first > 239)) return;
+        try {
+            mcast.addMembership(cfg.mcast.addr);
+        } catch(err) {
+            console.log(`sink - can't join ${cfg.mcast.addr}, REQ_IP must be sent directly to port ${cfg.mcast.port}`);
+        }
+    });
+
+    setInterval(() => {
+        if(count !== lastcount) console.log(`sink - ${((count - lastcount) / cfg.report).toFixed(1)} pkt/s, ${count} total, ${Object.keys(devices).length} devices, ${answered} REQ_IP answered`);
+        lastcount = count;
+    }, cfg.report * 1000);
+
+    data.bind(cfg.collector.port, cfg.sink.host);
+    mcast.bind(cfg.mcast.port);
+    console.log(`sink listening on ${cfg.sink.host}:${cfg.collector.port}, REQ_IP on ${cfg.mcast.addr}:${cfg.mcast.port}`);
+}
+
+if(mode === 'sink') runSink();
+else runFleet();
@@ -0,0 +1,325 @@
+/* ************************************************************************ */
+/*
+    gap-table.js - lost, reordered and duplicated reports for each device,
+    found with the "boot" and "rseq" in each report. "rseq" counts the
+    reports sent since the device started, "boot" is a random number
+    chosen at start up.
+
+    Each device has a window of the last WINDOW_BITS report numbers, one
+    bit for each report that has arrived. A report number that leaves the
+    window without its bit set is counted as lost. A report that arrives
+    after a later one, but while it's still in the window, is counted as
+    reordered. A report that's already in the window is a duplicate, and
+    one that's older than the window is late (it was counted as lost).
+    When "boot" changes the reports missing from the window are lost, and
+    so are the reports before the first one from the new boot.
+
+    The records are kept in a SharedArrayBuffer, one for each slot in the
+    collector's latest-value table (see latest-table.js). Each record is
+    18 x Int32 -
+
+        0       version, odd while the record is being written
+        1       boot, 0 = no reports yet
+        2       the highest rseq
+        3       site, an index into the collector's list of sites
+        4 - 9   received, lost, reordered, duplicates, late, reboots
+        10 - 17 the window, WINDOW_BITS bits
+
+    As in the table, each device has one writer and readers use the
+    version as a sequence lock.
+
+    Run "node gap-table.js check" to check the counters against a
+    simulated network that loses, reorders and duplicates reports.
+*/
+const LatestTable = require('./latest-table.js');
+
+const WINDOW_BITS = 256;
+const WINDOW_INTS = WINDOW_BITS / 32;
+
+const REC_INTS = 10 + WINDOW_INTS;
+const REC_VERSION = 0;
+const REC_BOOT = 1;
+const REC_HIGH = 2;
+const REC_SITE = 3;
+const REC_COUNTS = 4;
+const REC_WINDOW = 10;
+
+const COUNTS = ['received', 'lost', 'reordered', 'duplicates', 'late', 'reboots'];
+const RECEIVED = REC_COUNTS;
+const LOST = REC_COUNTS + 1;
+const REORDERED = REC_COUNTS + 2;
+const DUPLICATES = REC_COUNTS + 3;
+const LATE = REC_COUNTS + 4;
+const REBOOTS = REC_COUNTS + 5;
+
+function popcount(v) {
+    v = v - ((v >>> 1) & 0x55555555);
+    v = (v & 0x33333333) + ((v >>> 2) & 0x33333333);
+    return (Math.imul((v + (v >>> 4)) & 0x0f0f0f0f, 0x01010101) >>> 24);
+}
+
+class GapTable {
+    /*
+        `table` is the collector's LatestTable, `buffer` is optional, a
+        SharedArrayBuffer from another thread's GapTable.
+    */
+    constructor(table, buffer) {
+        this.table = table;
+        this.recInts = table.recs.length / table.slots;
+        this.buffer = (buffer instanceof SharedArrayBuffer ? buffer : new SharedArrayBuffer(table.slots * REC_INTS * 4));
+        this.recs = new Int32Array(this.buffer);
+    }
+
+    base(id, add) {
+        var slot = this.table.find(id, add);
+        return (slot < 0 ? -1 : (slot / this.recInts) * REC_INTS);
+    }
+
+    testBit(base, rseq) {
+        var bit = rseq % WINDOW_BITS;
+        return (this.recs[base + REC_WINDOW + (bit >> 5)] & (1 << (bit & 31))) !== 0;
+    }
+
+    setBit(base, rseq) {
+        var bit = rseq % WINDOW_BITS;
+        this.recs[base + REC_WINDOW + (bit >> 5)] |= (1 << (bit & 31));
+    }
+
+    clearBit(base, rseq) {
+        var bit = rseq % WINDOW_BITS;
+        this.recs[base + REC_WINDOW + (bit >> 5)] &= ~(1 << (bit & 31));
+    }
+
+    // the report numbers in the window that haven't arrived
+    missing(base) {
+        var set = 0;
+        for(var ix = 0; ix < WINDOW_INTS; ix++) set += popcount(this.recs[base + REC_WINDOW + ix]);
+        return WINDOW_BITS - set;
+    }
+
+    /*
+        Start the window at `rseq`, the numbers before `first` are marked
+        as arrived. Returns the number of reports from `first` that are
+        already older than the window.
+    */
+    restart(base, boot, rseq, first) {
+        this.recs[base + REC_BOOT] = boot | 0;
+        this.recs[base + REC_HIGH] = rseq | 0;
+        for(var ix = 0; ix < WINDOW_INTS; ix++) this.recs[base + REC_WINDOW + ix] = -1;
+        for(var num = Math.max(first, rseq - WINDOW_BITS + 1); num < rseq; num++) this.clearBit(base, num);
+        return Math.max(0, rseq - WINDOW_BITS - first + 1);
+    }
+
+    /*
+        Count a report, `boot` and `rseq` are from the report and `site`
+        is where it came from. Only one thread may add a given device's
+        reports. Returns false if there's no room for the device.
+    */
+    add(id, boot, rseq, site) {
+        var base = this.base(id, true);
+        if(base < 0) return false;
+
+        var recs = this.recs;
+        var version = recs[base + REC_VERSION];
+        var prevBoot = recs[base + REC_BOOT] >>> 0;
+        var high = recs[base + REC_HIGH] >>> 0;
+
+        Atomics.store(recs, base + REC_VERSION, version + 1);
+        recs[base + REC_SITE] = site;
+        if(prevBoot !== boot) {
+            if(prevBoot !== 0) {
+                // the device restarted, anything missing won't arrive
+                // and its reports before this one are missing
+                recs[base + LOST] += this.missing(base) + this.restart(base, boot, rseq, 1);
+                recs[base + REBOOTS] += 1;
+            } else this.restart(base, boot, rseq, rseq);
+            recs[base + RECEIVED] += 1;
+        } else if(rseq > high) {
+            var gap = rseq - high;
+            if(gap > WINDOW_BITS) {
+                // the whole window is replaced
+                recs[base + LOST] += this.missing(base) + (gap - WINDOW_BITS);
+                for(var ix = 0; ix < WINDOW_INTS; ix++) recs[base + REC_WINDOW + ix] = 0;
+            } else {
+                // the bits for high+1 to rseq are reused, they were for
+                // the report numbers WINDOW_BITS earlier
+                for(var num = high + 1; num <= rseq; num++) {
+                    if(!this.testBit(base, num)) recs[base + LOST] += 1;
+                    this.clearBit(base, num);
+                }
+            }
+            this.setBit(base, rseq);
+            recs[base + REC_HIGH] = rseq | 0;
+            recs[base + RECEIVED] += 1;
+        } else if((high - rseq) >= WINDOW_BITS) {
+            recs[base + LATE] += 1;
+        } else if(this.testBit(base, rseq)) {
+            recs[base + DUPLICATES] += 1;
+        } else {
+            this.setBit(base, rseq);
+            recs[base + REORDERED] += 1;
+            recs[base + RECEIVED] += 1;
+        }
+        Atomics.store(recs, base + REC_VERSION, version + 2);
+        return true;
+    }
+
+    // a consistent copy of a record, null if the device has no reports
+    read(base) {
+        for(;;) {
+            var version = Atomics.load(this.recs, base + REC_VERSION);
+            if(version & 1) continue;
+            if(this.recs[base + REC_BOOT] === 0) return null;
+
+            var rec = {boot: this.recs[base + REC_BOOT] >>> 0, rseq: this.recs[base + REC_HIGH] >>> 0, site: this.recs[base + REC_SITE]};
+            COUNTS.forEach((name, ix) => rec[name] = this.recs[base + REC_COUNTS + ix]);
+            rec.missing = this.missing(base);
+            if(Atomics.load(this.recs, base + REC_VERSION) === version) return rec;
+        }
+    }
+
+    get(id) {
+        var base = this.base(id, false);
+        if(base < 0) return null;
+        var rec = this.read(base);
+        if(rec !== null) rec.loss = lossRate(rec);
+        return rec;
+    }
+
+    /*
+        The totals for each site, `sites` is the list of site names. Each
+        site also has the number of devices.
+    */
+    sites(sites) {
+        var totals = {};
+        sites.forEach((name) => {
+            totals[name] = {devices: 0};
+            COUNTS.forEach((count) => totals[name][count] = 0);
+            totals[name].missing = 0;
+        });
+        for(var base = 0; base < this.recs.length; base += REC_INTS) {
+            if(this.recs[base + REC_BOOT] === 0) continue;
+            var rec = this.read(base);
+            if((rec === null) || (sites[rec.site] === undefined)) continue;
+            var sum = totals[sites[rec.site]];
+            sum.devices += 1;
+            COUNTS.forEach((count) => sum[count] += rec[count]);
+            sum.missing += rec.missing;
+        }
+        sites.forEach((name) => totals[name].loss = lossRate(totals[name]));
+        return totals;
+    }
+}
+
+// lost / (received + lost), the missing reports aren't included until they leave the window
+function lossRate(rec) {
+    var expected = rec.received + rec.lost;
+    return (expected === 0 ? 0 : Number((rec.lost / expected).toFixed(6)));
+}
+
+module.exports = GapTable;
+
+/* ************************************************************************ */
+/*
+    Check - node gap-table.js check
+
+    Devices send reports through a simulated network that drops some,
+    duplicates some and delays some by a few places. The network knows
+    exactly what it did, the counters must agree once the windows have
+    moved past the delayed reports.
+*/
+if((require.main === module) && (process.argv[2] === 'check')) {
+    const ndev = 1000;
+    const reports = 2000;
+    const table = new LatestTable(ndev);
+    const gaps = new GapTable(table);
+    var fails = 0;
+
+    function check(id, name, got, want) {
+        if(got === want) return;
+        console.log(`${id} - ${name} is ${got}, expected ${want}`);
+        fails += 1;
+    }
+
+    var began = performance.now();
+    var added = 0;
+    for(var dev = 0; dev < ndev; dev++) {
+        var id = 'ESP_' + (0xD00000 + dev).toString(16).toUpperCase();
+        var boot = 0x10000 + dev;
+        var want = {received: 0, lost: 0, reordered: 0, duplicates: 0, reboots: 0};
+        var delayed = [];
+        var drop = (dev % 10) / 100;
+        var rseq = 0;
+        var highest = 0;
+        var dropped = [];
+
+        // the reports lost after the last one that arrived can't be seen
+        function endBoot() {
+            delayed.forEach((pkt) => {
+                deliver(pkt.num);
+                want.received += 1;
+            });
+            delayed = [];
+            want.lost -= dropped.filter((num) => num > highest).length;
+            dropped = [];
+        }
+
+        // it's only reordered if a later report has arrived
+        function deliver(num) {
+            gaps.add(id, boot, num, dev % 3);
+            added += 1;
+            if(num < highest) want.reordered += 1;
+            highest = Math.max(highest, num);
+        }
+
+        for(var ix = 1; ix <= reports; ix++) {
+            rseq += 1;
+            // a reboot now and then, the first report after it is lost too
+            if((dev % 7 === 0) && (ix === reports / 2)) {
+                endBoot();
+                boot += 1;
+                rseq = 1;
+                highest = 0;
+                want.reboots += 1;
+                want.lost += 1;
+                continue;
+            }
+            // the first report is where the counting starts
+            var roll = (ix === 1 ? 0.5 : Math.random());
+            if(roll < drop) {
+                want.lost += 1;
+                dropped.push(rseq);
+            } else if(roll < drop + 0.02) {
+                // overtaken by the next 1 to 5 reports
+                delayed.push({num: rseq, after: ix + 1 + Math.floor(Math.random() * 5)});
+            } else {
+                deliver(rseq);
+                want.received += 1;
+                if(roll > 0.99) {
+                    deliver(rseq);
+                    want.duplicates += 1;
+                }
+            }
+            delayed = delayed.filter((pkt) => {
+                if(pkt.after > ix) return true;
+                deliver(pkt.num);
+                want.received += 1;
+                return false;
+            });
+        }
+        endBoot();
+        // the report numbers still in the window are counted when the window moves
+        var got = gaps.get(id);
+        var lost = got.lost + got.missing;
+        check(id, 'received', got.received, want.received);
+        check(id, 'lost', lost, want.lost);
+        check(id, 'reordered', got.reordered, want.reordered);
+        check(id, 'duplicates', got.duplicates, want.duplicates);
+        check(id, 'reboots', got.reboots, want.reboots);
+    }
+    var ms = performance.now() - began;
+    console.log(`${added} reports from ${ndev} devices - ${((ms * 1000) / added).toFixed(3)} us each`);
+    console.log(gaps.sites(['site-0', 'site-1', 'site-2']));
+    console.log(`${fails} counters differ`);
+    process.exit(fails === 0 ? 0 : 1);
+}
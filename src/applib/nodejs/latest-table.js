@@ -0,0 +1,267 @@
+/* ************************************************************************ */
+/*
+    latest-table.js - the latest reading and status of each device, kept
+    in a SharedArrayBuffer so that it can be updated by the collector's
+    parse threads and read by the query server without locks.
+
+    The table is open-addressed (linear probing) and keyed by a hash of
+    "dev_id". Each record is 64 bytes (16 x Int32) -
+
+        0       version, odd while the record is being written
+        1       key hash, 0 = empty slot
+        2       seq, unsigned
+        3       t x 100
+        4       h x 100
+        5, 6    last seen, milliseconds (high, low)
+        7       status, an index into STATUS
+        8 - 15  dev_id, up to 32 characters
+
+    Each record has one writer, the collector sends all of a device's
+    packets to the same parse thread. New records are claimed with a
+    compare-and-exchange of the key hash, so different threads can add
+    devices at the same time. Readers copy a record and retry if the
+    version changed while they were copying it (a sequence lock).
+
+    Run "node latest-table.js bench" to benchmark it with 100k devices.
+*/
+const REC_INTS = 16;
+const REC_VERSION = 0;
+const REC_HASH = 1;
+const REC_SEQ = 2;
+const REC_T = 3;
+const REC_H = 4;
+const REC_SEEN_HI = 5;
+const REC_SEEN_LO = 6;
+const REC_STATUS = 7;
+const REC_ID = 8;
+const ID_MAX = 32;
+
+// the status messages that are known, see sendStatus() calls in the application
+const STATUS = ['', 'OTHER', 'APP_READY', 'HEART', 'REQ_IP', 'SENSOR_FAULT', 'SENSOR_ERROR',
+                'SENSOR_RECOVER', 'HEAP', 'HEAP_LOW', 'ERROR', 'TICK', 'TOCK',
+                'OTA_READY', 'OTA_START', 'OTA_END', 'OTA_STOP', 'SENSOR_DIAG'];
+
+// FNV-1a, never 0
+function hashId(id) {
+    var hash = 0x811c9dc5;
+    for(var ix = 0; ix < id.length; ix++) {
+        hash ^= id.charCodeAt(ix);
+        hash = Math.imul(hash, 0x01000193);
+    }
+    return (hash === 0 ? 1 : hash);
+}
+
+class LatestTable {
+    /*
+        `size` is the maximum number of devices, or a SharedArrayBuffer
+        from another thread's table.
+    */
+    constructor(size) {
+        if(size instanceof SharedArrayBuffer) this.buffer = size;
+        else {
+            // keep the table no more than half full
+            var slots = 1024;
+            while(slots < (size * 2)) slots *= 2;
+            this.buffer = new SharedArrayBuffer(slots * REC_INTS * 4);
+        }
+        this.recs = new Int32Array(this.buffer);
+        this.bytes = new Uint8Array(this.buffer);
+        this.slots = this.recs.length / REC_INTS;
+        this.mask = this.slots - 1;
+    }
+
+    sameId(base, id) {
+        for(var ix = 0; ix < ID_MAX; ix++) {
+            var code = (Atomics.load(this.recs, base + REC_ID + (ix >> 2)) >>> ((ix & 3) * 8)) & 0xff;
+            if(ix >= id.length) return (code === 0);
+            if(code !== (id.charCodeAt(ix) & 0xff)) return false;
+        }
+        return true;
+    }
+
+    readId(base) {
+        var start = (base + REC_ID) * 4;
+        var end = this.bytes.indexOf(0, start);
+        if((end < 0) || (end > (start + ID_MAX))) end = start + ID_MAX;
+        return String.fromCharCode.apply(null, this.bytes.subarray(start, end));
+    }
+
+    /*
+        Find a device's record, returns the index of its first Int32
+        or -1. When `add` is true a missing device is added, -1 is
+        returned only if the table is full.
+    */
+    find(id, add) {
+        var hash = hashId(id);
+        var slot = hash & this.mask;
+
+        for(var probes = 0; probes < this.slots; probes++) {
+            var base = slot * REC_INTS;
+            var key = Atomics.load(this.recs, base + REC_HASH);
+
+            if(key === 0) {
+                if(!add) return -1;
+                if(Atomics.compareExchange(this.recs, base + REC_HASH, 0, hash) === 0) {
+                    // ours, the version stays 0 until the id is in place
+                    for(var ix = 0; ix < ID_MAX; ix += 4) {
+                        var word = 0;
+                        for(var iy = 0; (iy < 4) && ((ix + iy) < id.length); iy++) word |= (id.charCodeAt(ix + iy) & 0xff) << (iy * 8);
+                        Atomics.store(this.recs, base + REC_ID + (ix >> 2), word);
+                    }
+                    Atomics.store(this.recs, base + REC_VERSION, 2);
+                    return base;
+                }
+                key = Atomics.load(this.recs, base + REC_HASH);
+            }
+            if(key === hash) {
+                // another thread might still be writing the id
+                while(Atomics.load(this.recs, base + REC_VERSION) === 0);
+                if(this.sameId(base, id)) return base;
+            }
+            slot = (slot + 1) & this.mask;
+        }
+        return -1;
+    }
+
+    /*
+        Update a device's reading, `status` is optional. Only one thread
+        may update a given device.
+    */
+    update(id, seq, t, h, status, seen) {
+        var base = this.find(id, true);
+        if(base < 0) return false;
+
+        var version = Atomics.load(this.recs, base + REC_VERSION);
+        Atomics.store(this.recs, base + REC_VERSION, version + 1);
+        if(seq !== undefined) {
+            this.recs[base + REC_SEQ] = seq;
+            this.recs[base + REC_T] = Math.round(t * 100);
+            this.recs[base + REC_H] = Math.round(h * 100);
+        }
+        if(status !== undefined) {
+            var code = STATUS.indexOf(status);
+            this.recs[base + REC_STATUS] = (code < 0 ? 1 : code);
+        }
+        this.recs[base + REC_SEEN_HI] = Math.floor(seen / 0x100000000);
+        this.recs[base + REC_SEEN_LO] = seen >>> 0;
+        Atomics.store(this.recs, base + REC_VERSION, version + 2);
+        return true;
+    }
+
+    // a consistent copy of a record, null if it's empty
+    read(base) {
+        for(;;) {
+            var version = Atomics.load(this.recs, base + REC_VERSION);
+            if(version === 0) {
+                if(Atomics.load(this.recs, base + REC_HASH) === 0) return null;
+                continue;
+            }
+            if(version & 1) continue;
+
+            var rec = {
+                dev_id: this.readId(base),
+                seq: this.recs[base + REC_SEQ] >>> 0,
+                t: this.recs[base + REC_T] / 100,
+                h: this.recs[base + REC_H] / 100,
+                seen: (this.recs[base + REC_SEEN_HI] * 0x100000000) + (this.recs[base + REC_SEEN_LO] >>> 0),
+                status: STATUS[this.recs[base + REC_STATUS]]
+            };
+            if(Atomics.load(this.recs, base + REC_VERSION) === version) return rec;
+        }
+    }
+
+    get(id) {
+        var base = this.find(id, false);
+        return (base < 0 ? null : this.read(base));
+    }
+
+    snapshot() {
+        var list = [];
+        for(var base = 0; base < this.recs.length; base += REC_INTS) {
+            if(this.recs[base + REC_HASH] === 0) continue;
+            var rec = this.read(base);
+            if(rec !== null) list.push(rec);
+        }
+        return list;
+    }
+}
+
+module.exports = LatestTable;
+
+/* ************************************************************************ */
+/*
+    Benchmark - node latest-table.js bench [devices] [threads]
+
+    The update threads write records where t, h and seq agree with each
+    other, the main thread checks every record it reads. A torn read
+    would show up as an inconsistent record.
+*/
+if((require.main === module) && (process.argv[2] === 'bench')) {
+    const {Worker, isMainThread, workerData, parentPort} = require('worker_threads');
+
+    if(isMainThread) {
+        const ndev = parseInt(process.argv[3]) || 100000;
+        const nthreads = parseInt(process.argv[4]) || 2;
+        const table = new LatestTable(ndev);
+        const ids = [];
+        var start;
+
+        for(var ix = 0; ix < ndev; ix++) ids.push('ESP_' + ix.toString(16).toUpperCase().padStart(6, '0'));
+
+        function us(ms, count) {
+            return ((ms * 1000) / count).toFixed(3);
+        }
+
+        start = performance.now();
+        ids.forEach((id, ix) => table.update(id, 0, 0, 0, 'APP_READY', Date.now()));
+        console.log(`insert ${ndev} devices - ${us(performance.now() - start, ndev)} us each`);
+
+        start = performance.now();
+        ids.forEach((id, ix) => table.update(id, 1, 20.5, 45.1, undefined, Date.now()));
+        console.log(`update ${ndev} devices - ${us(performance.now() - start, ndev)} us each`);
+
+        start = performance.now();
+        ids.forEach((id) => table.get(id));
+        console.log(`get ${ndev} devices - ${us(performance.now() - start, ndev)} us each`);
+
+        start = performance.now();
+        var snap = table.snapshot();
+        console.log(`snapshot of ${snap.length} devices - ${(performance.now() - start).toFixed(2)} ms`);
+
+        // concurrent updates, each thread owns every nth device
+        var running = nthreads;
+        var checked = 0;
+        var torn = 0;
+        for(var ix = 0; ix < nthreads; ix++) {
+            var worker = new Worker(__filename, {argv: process.argv.slice(2), workerData: {buffer: table.buffer, ndev: ndev, thread: ix, nthreads: nthreads}});
+            worker.on('message', (count) => {
+                console.log(`thread updated ${count} records`);
+                if(--running > 0) return;
+                console.log(`checked ${checked} records during the updates, ${torn} inconsistent`);
+                process.exit(torn === 0 ? 0 : 1);
+            });
+        }
+        // read while the threads are writing
+        function check() {
+            for(var ix = 0; ix < 1000; ix++) {
+                var rec = table.get(ids[Math.floor(Math.random() * ndev)]);
+                checked += 1;
+                if((rec.seq > 1) && ((rec.t !== (rec.seq % 1000) / 10) || (rec.h !== rec.t))) torn += 1;
+            }
+            if(running > 0) setImmediate(check);
+        }
+        setImmediate(check);
+    } else {
+        const table = new LatestTable(workerData.buffer);
+        const end = Date.now() + 2000;
+        var count = 0;
+        for(var seq = 2; Date.now() < end; seq++) {
+            for(var ix = workerData.thread; ix < workerData.ndev; ix += workerData.nthreads) {
+                var id = 'ESP_' + ix.toString(16).toUpperCase().padStart(6, '0');
+                table.update(id, seq, (seq % 1000) / 10, (seq % 1000) / 10, undefined, Date.now());
+                count += 1;
+            }
+        }
+        parentPort.postMessage(count);
+    }
+}
@@ -0,0 +1,9 @@
+/*
+    UDP Log Collector Configuration
+*/
+module.exports = {
+    // listen on all interfaces, the port must match
+    // the "log" port in the device's clientcfg.json
+    host : '0.0.0.0',
+    port : 54514
+};
@@ -0,0 +1,61 @@
+/* ************************************************************************ */
+/*
+    log-udp.js - receives the log packets shipped by the devices (see
+    esp8266-logship.cpp) and displays the records. Gaps in each device's
+    record sequence numbers are reported.
+
+    The packet format is - 
+
+        ESP_49ECF6
+        1021 123456 D sendUDP() - len = 52
+        1022 123460 D sendUDP(52) - sending to 192.168.0.7:54321
+
+    The first line is the device ID, each line after that is a record
+    that begins with its sequence number.
+*/
+// an option argument can specify an alternative configuration file. 
+var logCfgFile = process.argv[2];
+
+if((logCfgFile === undefined) || (logCfgFile === ''))
+    logCfgFile = './log-udp-cfg.js';
+
+const cfg = require(logCfgFile);
+
+// create a socket to listen on...
+const server = require('dgram').createSocket('udp4');
+
+// the next expected sequence number and the number of 
+// lost records for each device
+var devices = {};
+
+server.on('error', (err) => {
+    console.log(err.stack);
+    server.close();
+});
+
+server.on('message', (msg, rinfo) => {
+    var lines = msg.toString().split('\n').filter(line => line !== '');
+    var dev_id = lines.shift();
+
+    if(devices[dev_id] === undefined) devices[dev_id] = {next: -1, lost: 0};
+    var dev = devices[dev_id];
+
+    lines.forEach((line) => {
+        var seq = parseInt(line, 10);
+
+        // a lower sequence number means the device has rebooted
+        if((dev.next >= 0) && (seq > dev.next)) {
+            dev.lost += (seq - dev.next);
+            console.log(`${dev_id} >> GAP - ${seq - dev.next} records lost, ${dev.lost} total`);
+        }
+        dev.next = seq + 1;
+        console.log(`${dev_id} ${line}`);
+    });
+});
+
+server.on('listening', () => {
+    const address = server.address();
+    console.log(`log collector listening ${address.address}:${address.port}`);
+});
+
+server.bind(cfg.port, cfg.host);
@@ -0,0 +1,406 @@
+/* ************************************************************************ */
+/*
+    rollup.js - hourly and daily min/max/mean/last of each device's
+    readings, kept up to date as the readings arrive so that a dashboard
+    can chart months of data without reading the raw points.
+
+    Each device has two rings of buckets, `hours` hourly buckets and
+    `days` daily buckets (UTC). A reading updates one bucket in each ring,
+    a bucket that is reused for a newer hour or day is cleared first. A
+    reading for a bucket that has already been reused is counted in
+    `late` and ignored. Each bucket is 11 x Int32 -
+
+        0       version, odd while the bucket is being written
+        1       bucket number + 1 (hours or days since 1970), 0 = empty
+        2       number of readings
+        3 - 6   t min, max, sum and last (tenths)
+        7 - 10  h min, max, sum and last (tenths)
+
+    The rings are in a SharedArrayBuffer, devices are found through the
+    collector's latest-value table (see latest-table.js) and are given
+    rings in the order they're first seen. As in the table, each device
+    has one writer and readers use the version as a sequence lock.
+
+    Usage -
+
+        node rollup.js bench [devices] [days]
+
+            Save a synthetic year (by default) of 5 minute readings from
+            100 devices to a store (see tsdb.js) and to the rollups, then
+            compare the time taken by dashboard queries against each.
+*/
+const LatestTable = require('./latest-table.js');
+
+const HOUR = 3600000;
+const DAY = 86400000;
+
+// header, Int32
+const HDR_INTS = 8;
+const HDR_USED = 0;
+const HDR_DEVICES = 1;
+const HDR_HOURS = 2;
+const HDR_DAYS = 3;
+const HDR_SLOTS = 4;
+const HDR_LATE = 5;
+const HDR_FULL = 6;
+
+// bucket, Int32
+const BKT_INTS = 11;
+const BKT_VERSION = 0;
+const BKT_NUMBER = 1;
+const BKT_COUNT = 2;
+const BKT_T = 3;
+const BKT_H = 7;
+// offsets from BKT_T and BKT_H
+const MIN = 0;
+const MAX = 1;
+const SUM = 2;
+const LAST = 3;
+
+class Rollups {
+    /*
+        `table` is the collector's LatestTable. `size` is {devices, hours,
+        days}, or a SharedArrayBuffer from another thread's rollups.
+    */
+    constructor(table, size) {
+        this.table = table;
+        this.recInts = table.recs.length / table.slots;
+        if(size instanceof SharedArrayBuffer) this.buffer = size;
+        else {
+            var ints = HDR_INTS + table.slots + (size.devices * (size.hours + size.days) * BKT_INTS);
+            this.buffer = new SharedArrayBuffer(ints * 4);
+            var hdr = new Int32Array(this.buffer, 0, HDR_INTS);
+            hdr[HDR_DEVICES] = size.devices;
+            hdr[HDR_HOURS] = size.hours;
+            hdr[HDR_DAYS] = size.days;
+            hdr[HDR_SLOTS] = table.slots;
+        }
+        this.ints = new Int32Array(this.buffer);
+        this.devices = this.ints[HDR_DEVICES];
+        this.hours = this.ints[HDR_HOURS];
+        this.days = this.ints[HDR_DAYS];
+        // the table slot to device number map, 0 = none
+        this.map = HDR_INTS;
+        this.rings = HDR_INTS + this.ints[HDR_SLOTS];
+        this.perDevice = (this.hours + this.days) * BKT_INTS;
+    }
+
+    // the index of a device's first bucket, or -1
+    device(id, add) {
+        var base = this.table.find(id, add);
+        if(base < 0) return -1;
+
+        var slot = this.map + (base / this.recInts);
+        var num = Atomics.load(this.ints, slot);
+        if(num === 0) {
+            if(!add) return -1;
+            // only the device's own thread adds it, the count is shared
+            num = Atomics.add(this.ints, HDR_USED, 1) + 1;
+            if(num > this.devices) {
+                Atomics.add(this.ints, HDR_FULL, 1);
+                return -1;
+            }
+            Atomics.store(this.ints, slot, num);
+        }
+        return this.rings + ((num - 1) * this.perDevice);
+    }
+
+    /*
+        Add `count` readings to a bucket, the values are the min, max and
+        mean of the readings (tenths).
+    */
+    update(base, number, count, tmin, tmax, tmean, hmin, hmax, hmean) {
+        var ints = this.ints;
+        var current = ints[base + BKT_NUMBER] - 1;
+
+        if(number < current) {
+            Atomics.add(ints, HDR_LATE, 1);
+            return;
+        }
+        var version = ints[base + BKT_VERSION];
+        Atomics.store(ints, base + BKT_VERSION, version + 1);
+        if(number > current) {
+            ints[base + BKT_NUMBER] = number + 1;
+            ints[base + BKT_COUNT] = 0;
+            ints[base + BKT_T + MIN] = tmin;
+            ints[base + BKT_T + MAX] = tmax;
+            ints[base + BKT_H + MIN] = hmin;
+            ints[base + BKT_H + MAX] = hmax;
+            ints[base + BKT_T + SUM] = ints[base + BKT_H + SUM] = 0;
+        }
+        ints[base + BKT_COUNT] += count;
+        if(tmin < ints[base + BKT_T + MIN]) ints[base + BKT_T + MIN] = tmin;
+        if(tmax > ints[base + BKT_T + MAX]) ints[base + BKT_T + MAX] = tmax;
+        ints[base + BKT_T + SUM] += tmean * count;
+        ints[base + BKT_T + LAST] = tmean;
+        if(hmin < ints[base + BKT_H + MIN]) ints[base + BKT_H + MIN] = hmin;
+        if(hmax > ints[base + BKT_H + MAX]) ints[base + BKT_H + MAX] = hmax;
+        ints[base + BKT_H + SUM] += hmean * count;
+        ints[base + BKT_H + LAST] = hmean;
+        Atomics.store(ints, base + BKT_VERSION, version + 2);
+    }
+
+    /*
+        Add a reading, `time` is in milliseconds. Only one thread may add
+        a given device's readings. Returns false if there's no room for
+        the device.
+    */
+    add(id, time, t10, h10) {
+        return this.addSummary(id, time, 1, t10, t10, t10, h10, h10, h10);
+    }
+
+    /*
+        Add a summary of `count` readings, such as a "STATS" report. The
+        values are in tenths, the mean is used as the "last" value.
+    */
+    addSummary(id, time, count, tmin, tmax, tmean, hmin, hmax, hmean) {
+        var ring = this.device(id, true);
+        if(ring < 0) return false;
+
+        var hour = Math.floor(time / HOUR);
+        var day = Math.floor(time / DAY);
+        this.update(ring + ((hour % this.hours) * BKT_INTS), hour, count, tmin, tmax, tmean, hmin, hmax, hmean);
+        this.update(ring + ((this.hours + (day % this.days)) * BKT_INTS), day, count, tmin, tmax, tmean, hmin, hmax, hmean);
+        return true;
+    }
+
+    // a consistent copy of a bucket into `out`, false if it isn't `number`
+    read(base, number, out) {
+        for(;;) {
+            var version = Atomics.load(this.ints, base + BKT_VERSION);
+            if(version & 1) continue;
+            if(this.ints[base + BKT_NUMBER] !== (number + 1)) return false;
+            for(var ix = BKT_COUNT; ix < BKT_INTS; ix++) out[ix] = this.ints[base + ix];
+            if(Atomics.load(this.ints, base + BKT_VERSION) === version) return true;
+        }
+    }
+
+    /*
+        Call `each(number, bkt)` for each of a device's buckets from
+        `first` to `last` (bucket numbers) that are still in its ring,
+        `bkt` is a copy of the bucket.
+    */
+    scan(ring, size, first, last, each) {
+        var bkt = new Int32Array(BKT_INTS);
+        first = Math.max(first, last - size + 1);
+        for(var number = first; number <= last; number++) {
+            if(this.read(ring + ((number % size) * BKT_INTS), number, bkt)) each(number, bkt);
+        }
+    }
+
+    /*
+        A device's hourly (`level` = 'hour') or daily buckets that overlap
+        `from` to `to` (milliseconds), oldest first. null if the device
+        is unknown.
+    */
+    query(id, level, from, to) {
+        var ring = this.device(id, false);
+        if(ring < 0) return null;
+
+        var list = [];
+        var width = (level === 'hour' ? HOUR : DAY);
+        var size = (level === 'hour' ? this.hours : this.days);
+        if(level !== 'hour') ring += this.hours * BKT_INTS;
+
+        this.scan(ring, size, Math.floor(from / width), Math.floor(to / width), (number, bkt) => list.push(toJSON(number * width, bkt)));
+        return list;
+    }
+
+    /*
+        The min/max/mean/last of a device's readings from `from` to `to`,
+        using the daily buckets for whole days and the hourly buckets for
+        the rest. The ends are rounded out to the hour, or to the day if
+        the hours are no longer in the ring. null if the device is unknown.
+    */
+    summary(id, from, to) {
+        var ring = this.device(id, false);
+        if(ring < 0) return null;
+
+        var sum = new Int32Array(BKT_INTS);
+        var hours = ring;
+        var days = ring + (this.hours * BKT_INTS);
+        var firstDay = Math.ceil(from / DAY);
+        var lastDay = Math.floor((to + 1) / DAY) - 1;
+        var oldestHour = Math.floor(to / HOUR) - this.hours + 1;
+
+        function merge(number, bkt) {
+            if(sum[BKT_COUNT] === 0) {
+                sum.set(bkt);
+            } else {
+                sum[BKT_COUNT] += bkt[BKT_COUNT];
+                [BKT_T, BKT_H].forEach((col) => {
+                    sum[col + MIN] = Math.min(sum[col + MIN], bkt[col + MIN]);
+                    sum[col + MAX] = Math.max(sum[col + MAX], bkt[col + MAX]);
+                    sum[col + SUM] += bkt[col + SUM];
+                    sum[col + LAST] = bkt[col + LAST];
+                });
+            }
+        }
+
+        // the part of a day before or after the whole days
+        const part = (start, end) => {
+            if(start > end) return;
+            var day = Math.floor(start / DAY);
+            if(Math.floor(start / HOUR) >= oldestHour) this.scan(hours, this.hours, Math.floor(start / HOUR), Math.floor(end / HOUR), merge);
+            else this.scan(days, this.days, day, day, merge);
+        };
+
+        if(firstDay > lastDay) {
+            // within one day, or across midnight
+            var mid = Math.floor(to / DAY) * DAY;
+            if(mid > from) {
+                part(from, mid - 1);
+                part(mid, to);
+            } else part(from, to);
+        } else {
+            part(from, (firstDay * DAY) - 1);
+            this.scan(days, this.days, firstDay, lastDay, merge);
+            part((lastDay + 1) * DAY, to);
+        }
+        if(sum[BKT_COUNT] === 0) return {count: 0};
+        var out = toJSON(from, sum);
+        delete out.time;
+        return out;
+    }
+
+    stats() {
+        return {devices: Math.min(this.ints[HDR_USED], this.devices), full: this.ints[HDR_FULL], late: this.ints[HDR_LATE]};
+    }
+}
+
+function toJSON(time, bkt) {
+    var count = bkt[BKT_COUNT];
+    function col(base) {
+        return {min: bkt[base + MIN] / 10, max: bkt[base + MAX] / 10,
+                mean: Math.round(bkt[base + SUM] / count) / 10, last: bkt[base + LAST] / 10};
+    }
+    return {time: time, count: count, t: col(BKT_T), h: col(BKT_H)};
+}
+
+module.exports = Rollups;
+
+/* ************************************************************************ */
+/*
+    Benchmark - the same dashboard queries answered from the raw readings
+    in a store and from the rollups. The answers are compared as well.
+*/
+if((require.main === module) && (process.argv[2] === 'bench')) {
+    const fs = require('fs');
+    const TSStore = require('./tsdb.js');
+    const dir = './rollup-bench';
+    const ndev = parseInt(process.argv[3]) || 100;
+    const days = parseInt(process.argv[4]) || 365;
+    const STEP = 300000;
+    const start = Date.UTC(2025, 0, 1);
+    const steps = (days * DAY) / STEP;
+    const end = start + (steps * STEP) - 1;
+
+    fs.rmSync(dir, {recursive: true, force: true});
+    const store = new TSStore(dir);
+    const table = new LatestTable(ndev);
+    // enough hours and days to hold the whole run
+    const rollups = new Rollups(table, {devices: ndev, hours: days * 24, days: days});
+
+    var ids = [];
+    for(var ix = 0; ix < ndev; ix++) ids.push('ESP_' + (0xC00000 + ix).toString(16).toUpperCase());
+
+    var storems = 0;
+    var rollms = 0;
+    var seq = 0;
+    for(var step = 0; step < steps; step++) {
+        var time = start + (step * STEP);
+        var t10 = [];
+        var h10 = [];
+        for(var ix = 0; ix < ndev; ix++) {
+            var cycle = Math.round(50 * Math.sin(((step + ix) % 288) * (Math.PI / 144)));
+            t10.push(700 + (ix % 50) + cycle + Math.floor(Math.random() * 3) - 1);
+            h10.push(400 - cycle + Math.floor(Math.random() * 5) - 2);
+        }
+        seq += 1;
+        began = performance.now();
+        for(var ix = 0; ix < ndev; ix++) store.append(ids[ix], time, seq, t10[ix], h10[ix]);
+        storems += performance.now() - began;
+        began = performance.now();
+        for(var ix = 0; ix < ndev; ix++) rollups.add(ids[ix], time, t10[ix], h10[ix]);
+        rollms += performance.now() - began;
+    }
+    store.flush();
+    var pts = ndev * steps;
+    console.log(`${ndev} devices, ${days} days, ${pts} readings`);
+    console.log(`ingest - store ${((storems * 1000) / pts).toFixed(3)} us/reading, rollups ${((rollms * 1000) / pts).toFixed(3)} us/reading`);
+    console.log(`rollups - ${(rollups.buffer.byteLength / 1048576).toFixed(1)}MB, ${(rollups.buffer.byteLength / ndev / 1024).toFixed(1)}KB per device`);
+
+    // buckets from the raw readings, the same shape as Rollups.query(), 0 = one bucket
+    function rawBuckets(id, width, from, to) {
+        var list = [];
+        var bkt = null;
+        store.query(id, from, to, (time, seq, t10, h10) => {
+            var bstart = (width === 0 ? from : Math.floor(time / width) * width);
+            if((bkt === null) || (bkt.time !== bstart)) {
+                bkt = {time: bstart, count: 0, t: {min: t10, max: t10, sum: 0}, h: {min: h10, max: h10, sum: 0}};
+                list.push(bkt);
+            }
+            bkt.count += 1;
+            [[bkt.t, t10], [bkt.h, h10]].forEach(([col, v]) => {
+                col.min = Math.min(col.min, v);
+                col.max = Math.max(col.max, v);
+                col.sum += v;
+                col.last = v;
+            });
+        });
+        return list.map((bkt) => {
+            function col(c) {
+                return {min: c.min / 10, max: c.max / 10, mean: Math.round(c.sum / bkt.count) / 10, last: c.last / 10};
+            }
+            return {time: bkt.time, count: bkt.count, t: col(bkt.t), h: col(bkt.h)};
+        });
+    }
+
+    const dashboards = [
+        {name: 'hourly, 1 day', level: 'hour', span: 1},
+        {name: 'hourly, 7 days', level: 'hour', span: 7},
+        {name: 'daily, 30 days', level: 'day', span: 30},
+        {name: `daily, ${days} days`, level: 'day', span: days}
+    ];
+    var mismatch = 0;
+    dashboards.filter((dash) => dash.span <= days).forEach((dash) => {
+        var queries = 100;
+        var rawms = 0;
+        var rollupms = 0;
+        for(var ix = 0; ix < queries; ix++) {
+            var id = ids[Math.floor(Math.random() * ndev)];
+            var from = start + (Math.floor(Math.random() * (days - dash.span + 1)) * DAY);
+            var to = from + (dash.span * DAY) - 1;
+            var began = performance.now();
+            var raw = rawBuckets(id, (dash.level === 'hour' ? HOUR : DAY), from, to);
+            rawms += performance.now() - began;
+            began = performance.now();
+            var rolled = rollups.query(id, dash.level, from, to);
+            rollupms += performance.now() - began;
+            if(JSON.stringify(raw) !== JSON.stringify(rolled)) mismatch += 1;
+        }
+        console.log(`${dash.name} - raw ${(rawms / queries).toFixed(3)}ms, rollups ${(rollupms / queries).toFixed(3)}ms (${(rawms / rollupms).toFixed(0)}x)`);
+    });
+
+    // a summary over a range that doesn't start or end on a day
+    var queries = 100;
+    var rawms = 0;
+    var rollupms = 0;
+    for(var ix = 0; ix < queries; ix++) {
+        var id = ids[Math.floor(Math.random() * ndev)];
+        var from = start + (Math.floor(Math.random() * ((days * 24) / 2)) * HOUR);
+        var to = Math.min(end, from + ((Math.floor(Math.random() * ((days * 24) / 2)) + 1) * HOUR) - 1);
+        var began = performance.now();
+        var raw = rawBuckets(id, 0, from, to);
+        rawms += performance.now() - began;
+        began = performance.now();
+        var sum = rollups.summary(id, from, to);
+        rollupms += performance.now() - began;
+        if((raw.length === 1) && (JSON.stringify([raw[0].count, raw[0].t, raw[0].h]) !== JSON.stringify([sum.count, sum.t, sum.h]))) mismatch += 1;
+    }
+    console.log(`summary, random range - raw ${(rawms / queries).toFixed(3)}ms, rollups ${(rollupms / queries).toFixed(3)}ms (${(rawms / rollupms).toFixed(0)}x)`);
+    console.log(`${mismatch} answers differ`);
+    store.close();
+    fs.rmSync(dir, {recursive: true, force: true});
+    process.exit(mismatch === 0 ? 0 : 1);
+}
@@ -0,0 +1,23 @@
+/*
+    Soak Test Checker Configuration
+
+    These must match the device's configuration files and the
+    settings in esp8266-clock.h
+*/
+module.exports = {
+    // sensor data, the "udp1" port in clientcfg.json
+    host : '0.0.0.0',
+    port : 54321,
+    // heap status messages, match multicfg.json
+    mcast : {addr : '224.0.0.1', port : 54000},
+    // the "interval" in sensorcfg.json, the heartbeat rate is 4 times this
+    interval : 60000,
+    // SOAK_STEP_MS in esp8266-clock.h
+    step : 1000,
+    // the free heap may drop this many bytes below the first samples
+    heapslack : 1024,
+    // HEAP samples to skip before taking the baseline
+    heapwarmup : 3,
+    // seconds between progress reports
+    report : 10
+};
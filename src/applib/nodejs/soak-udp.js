@@ -0,0 +1,165 @@
+/* ************************************************************************ */
+/*
+    soak-udp.js - checks a device that is running with SOAK_TEST defined
+    (see esp8266-clock.h). Each sensor message contains "vt", the device's
+    virtual time in milliseconds. The checks are - 
+
+        * seq always moves forward (it is 32 bits, wrapping is counted)
+        * rseq goes up by one for each report, a gap is a lost report
+        * boot doesn't change, the device didn't restart
+        * readings are not reported more often than the interval, and 
+          no more than one step late when nothing was skipped
+        * heartbeats arrive when the device has been quiet for the 
+          heartbeat rate, the device is never quiet for longer
+        * the free heap doesn't drop below its early level, and 
+          there is no HEAP_LOW status
+
+    Any failure is displayed as it's found. Run until the virtual clock 
+    has covered the time of interest and stop with Ctrl-C, the exit code 
+    is the number of failures.
+*/
+// an option argument can specify an alternative configuration file. 
+var soakCfgFile = process.argv[2];
+
+if((soakCfgFile === undefined) || (soakCfgFile === ''))
+    soakCfgFile = './soak-udp-cfg.js';
+
+const cfg = require(soakCfgFile);
+const dgram = require('dgram');
+
+const heartrate = cfg.interval * 4;
+
+var stats = {
+    data: 0, beats: 0, heaps: 0, fails: 0,
+    seqwraps: 0, lost: 0, rollovers: 0, vtime: 0
+};
+
+// the last message of each kind, null until one arrives
+var last = {seq: null, boot: null, rseq: null, vt: null, datavt: null};
+var heap = {samples: 0, base: 0, min: 0};
+
+function fail(msg) {
+    stats.fails += 1;
+    console.log(`FAIL @ ${days(stats.vtime)} days - ${msg}`);
+}
+
+function days(ms) {
+    return (ms / 86400000).toFixed(2);
+}
+
+// elapsed milliseconds between two 32 bit times
+function since(now, then) {
+    return (now - then) >>> 0;
+}
+
+function checkSensor(msg) {
+    var isbeat = (msg.last !== undefined);
+
+    if(msg.vt === undefined) {
+        fail('no "vt" in message, is SOAK_TEST defined?');
+        return;
+    }
+
+    if(last.seq !== null) {
+        var diff = (msg.seq - last.seq) >>> 0;
+        if((diff === 0) || (diff >= 0x80000000)) fail(`seq went from ${last.seq} to ${msg.seq}`);
+        else if(msg.seq < last.seq) stats.seqwraps += 1;
+    }
+    last.seq = msg.seq;
+
+    if((last.boot !== null) && (msg.boot !== last.boot)) fail(`boot changed from ${last.boot} to ${msg.boot}`);
+    else if((last.rseq !== null) && (msg.rseq !== (last.rseq + 1))) {
+        if(msg.rseq > last.rseq) stats.lost += msg.rseq - last.rseq - 1;
+        else fail(`rseq went from ${last.rseq} to ${msg.rseq}`);
+    }
+    last.boot = msg.boot;
+    last.rseq = msg.rseq;
+
+    if(last.vt !== null) {
+        var gap = since(msg.vt, last.vt);
+
+        if(msg.vt < last.vt) stats.rollovers += 1;
+        stats.vtime += gap;
+
+        if(gap > (heartrate + cfg.step)) fail(`quiet for ${gap} ms`);
+        if(isbeat && (gap < heartrate)) fail(`heartbeat after only ${gap} ms`);
+    }
+    last.vt = msg.vt;
+
+    if(isbeat) stats.beats += 1;
+    else {
+        stats.data += 1;
+        if(last.datavt !== null) {
+            var datagap = since(msg.vt, last.datavt);
+            if(datagap < cfg.interval) fail(`data after only ${datagap} ms`);
+        }
+        last.datavt = msg.vt;
+    }
+}
+
+function checkHeap(msg) {
+    if(msg.status === 'HEAP_LOW') fail(`HEAP_LOW - free = ${msg.free}`);
+    if(msg.status !== 'HEAP') return;
+
+    stats.heaps += 1;
+    heap.samples += 1;
+    if(heap.samples <= cfg.heapwarmup) return;
+    if(heap.samples === (cfg.heapwarmup + 1)) {
+        heap.base = heap.min = msg.free;
+        return;
+    }
+    if(msg.free < heap.min) {
+        heap.min = msg.free;
+        if(heap.min < (heap.base - cfg.heapslack)) fail(`free heap ${heap.min}, started at ${heap.base}`);
+    }
+}
+
+function parse(payload) {
+    try {
+        return JSON.parse(payload.filter(letter => letter !== 0).toString());
+    } catch(err) {
+        fail(`bad message - ${payload.toString()}`);
+        return null;
+    }
+}
+
+const server = dgram.createSocket('udp4');
+
+server.on('error', (err) => {
+    console.log(err.stack);
+    server.close();
+});
+
+server.on('message', (payload, rinfo) => {
+    var msg = parse(payload);
+    if((msg !== null) && (msg.seq !== undefined)) checkSensor(msg);
+});
+
+server.bind(cfg.port, cfg.host);
+
+const mcast = dgram.createSocket({type: 'udp4', reuseAddr: true});
+
+mcast.on('listening', () => {
+    mcast.addMembership(cfg.mcast.addr);
+});
+
+mcast.on('message', (payload, rinfo) => {
+    var msg = parse(payload);
+    if(msg !== null) checkHeap(msg);
+});
+
+mcast.bind(cfg.mcast.port);
+
+function report() {
+    console.log(`${days(stats.vtime)} days - data ${stats.data}  beats ${stats.beats}  heap ${stats.heaps} (min ${heap.min})  seq wraps ${stats.seqwraps}  lost ${stats.lost}  rollovers ${stats.rollovers}  fails ${stats.fails}`);
+}
+
+setInterval(report, cfg.report * 1000);
+
+process.on('SIGINT', () => {
+    report();
+    console.log(stats.fails === 0 ? 'PASS' : 'FAIL');
+    process.exit(stats.fails === 0 ? 0 : 1);
+});
+
+console.log(`soak checker listening on ${cfg.port}, heap on ${cfg.mcast.addr}:${cfg.mcast.port}`);
@@ -0,0 +1,406 @@
+/* ************************************************************************ */
+/*
+    tsdb.js - an append-only store for the readings received from the
+    devices.
+
+    The readings for each device are collected into blocks of up to
+    BLOCK_POINTS points, and full blocks are appended to segment files
+    in the store's folder (seg-000001.dat, ...). A new segment is started
+    when the current one reaches `segment` bytes. Each block holds one
+    device's points in columns -
+
+        u32     block length in bytes, including this field
+        u16     BLOCK_MAGIC
+        u8      dev_id length, followed by dev_id
+        u16     number of points
+        f64     time of the first point, milliseconds
+        f64     time of the last point
+        varint  first seq, zigzag first t, zigzag first h
+        column  time, zigzag varint delta-of-delta
+        column  seq, zigzag varint delta
+        column  t, zigzag varint delta (tenths)
+        column  h, zigzag varint delta (tenths)
+
+    Readings at a steady interval have a delta-of-delta of 0, and
+    slowly changing t & h have small deltas, most values fit in one byte.
+
+    The index of blocks (device, time range, file & offset) is kept in
+    memory and rebuilt from the block headers when a store is opened.
+    Blocks are read with positioned reads, node has no mmap().
+
+    Usage -
+
+        node tsdb.js bench [folder] [devices] [days]
+
+            Ingest a synthetic year (by default) of 5 minute readings
+            from 1000 devices and report the compression and the ingest
+            and query rates.
+
+        node tsdb.js query <folder> <dev_id> [from] [to]
+
+            Display a device's readings, `from` and `to` are dates.
+*/
+const fs = require('fs');
+const path = require('path');
+
+const BLOCK_POINTS = 256;
+const BLOCK_MAGIC = 0x5442;
+// the fixed part of a block header, not including dev_id
+const HEADER_FIXED = 4 + 2 + 1 + 2 + 8 + 8;
+const ID_MAX = 32;
+
+/* ************************************************************************ */
+/*
+    Encoding
+*/
+function zigzag(v) {
+    return (v >= 0 ? v * 2 : (-v * 2) - 1);
+}
+
+function unzigzag(v) {
+    return ((v % 2) === 0 ? v / 2 : -(v + 1) / 2);
+}
+
+// returns the new position, `v` must be >= 0
+function putVarint(buf, pos, v) {
+    while(v >= 0x80) {
+        buf[pos++] = (v % 0x80) | 0x80;
+        v = Math.floor(v / 0x80);
+    }
+    buf[pos++] = v;
+    return pos;
+}
+
+class Reader {
+    constructor(buf, pos) {
+        this.buf = buf;
+        this.pos = pos;
+    }
+
+    varint() {
+        var v = 0;
+        var scale = 1;
+        var b;
+        do {
+            b = this.buf[this.pos++];
+            v += (b & 0x7f) * scale;
+            scale *= 0x80;
+        } while(b & 0x80);
+        return v;
+    }
+
+    zigzag() {
+        return unzigzag(this.varint());
+    }
+}
+
+/*
+    Encode a device's points, `pts` is an array of {time, seq, t10, h10}
+*/
+function encodeBlock(id, pts, scratch) {
+    var pos = 4;
+    var count = pts.length;
+
+    scratch.writeUInt16LE(BLOCK_MAGIC, pos);
+    pos += 2;
+    scratch[pos++] = id.length;
+    pos += scratch.write(id, pos, 'latin1');
+    scratch.writeUInt16LE(count, pos);
+    pos += 2;
+    scratch.writeDoubleLE(pts[0].time, pos);
+    scratch.writeDoubleLE(pts[count - 1].time, pos + 8);
+    pos += 16;
+
+    pos = putVarint(scratch, pos, pts[0].seq);
+    pos = putVarint(scratch, pos, zigzag(pts[0].t10));
+    pos = putVarint(scratch, pos, zigzag(pts[0].h10));
+
+    var delta = 0;
+    for(var ix = 1; ix < count; ix++) {
+        var d = pts[ix].time - pts[ix - 1].time;
+        pos = putVarint(scratch, pos, zigzag(d - delta));
+        delta = d;
+    }
+    for(var ix = 1; ix < count; ix++) pos = putVarint(scratch, pos, zigzag(pts[ix].seq - pts[ix - 1].seq));
+    for(var ix = 1; ix < count; ix++) pos = putVarint(scratch, pos, zigzag(pts[ix].t10 - pts[ix - 1].t10));
+    for(var ix = 1; ix < count; ix++) pos = putVarint(scratch, pos, zigzag(pts[ix].h10 - pts[ix - 1].h10));
+
+    scratch.writeUInt32LE(pos, 0);
+    return Buffer.from(scratch.subarray(0, pos));
+}
+
+// the header fields of a block
+function blockHeader(buf) {
+    var idlen = buf[6];
+    var pos = 7 + idlen;
+    return {
+        length: buf.readUInt32LE(0),
+        magic: buf.readUInt16LE(4),
+        id: buf.toString('latin1', 7, pos),
+        count: buf.readUInt16LE(pos),
+        first: buf.readDoubleLE(pos + 2),
+        last: buf.readDoubleLE(pos + 10),
+        body: pos + 18
+    };
+}
+
+/*
+    Decode a block, calls `each(time, seq, t10, h10)` for every point
+*/
+function decodeBlock(buf, each) {
+    var hdr = blockHeader(buf);
+    var rd = new Reader(buf, hdr.body);
+    var count = hdr.count;
+    var time = new Float64Array(count);
+    var seq = new Float64Array(count);
+    var t10 = new Int32Array(count);
+    var h10 = new Int32Array(count);
+
+    time[0] = hdr.first;
+    seq[0] = rd.varint();
+    t10[0] = rd.zigzag();
+    h10[0] = rd.zigzag();
+
+    var delta = 0;
+    for(var ix = 1; ix < count; ix++) {
+        delta += rd.zigzag();
+        time[ix] = time[ix - 1] + delta;
+    }
+    for(var ix = 1; ix < count; ix++) seq[ix] = seq[ix - 1] + rd.zigzag();
+    for(var ix = 1; ix < count; ix++) t10[ix] = t10[ix - 1] + rd.zigzag();
+    for(var ix = 1; ix < count; ix++) h10[ix] = h10[ix - 1] + rd.zigzag();
+
+    for(var ix = 0; ix < count; ix++) each(time[ix], seq[ix], t10[ix], h10[ix]);
+}
+
+/* ************************************************************************ */
+/*
+    Store
+*/
+class TSStore {
+    /*
+        opts.segment  - bytes per segment file
+        opts.readonly - don't create or write any files
+    */
+    constructor(dir, opts) {
+        this.dir = dir;
+        this.segbytes = (opts && opts.segment) || (64 * 1024 * 1024);
+        this.readonly = (opts && opts.readonly) || false;
+        // dev_id -> [{seg, offset, length, first, last}]
+        this.index = new Map();
+        // dev_id -> points not written yet
+        this.open = new Map();
+        // segment number -> file descriptor
+        this.fds = new Map();
+        this.seg = 0;
+        this.segsize = 0;
+        this.scratch = Buffer.alloc(HEADER_FIXED + ID_MAX + (BLOCK_POINTS * 4 * 8));
+        this.stats = {points: 0, blocks: 0, bytes: 0};
+
+        if(!this.readonly) fs.mkdirSync(dir, {recursive: true});
+        this.load();
+    }
+
+    segName(seg) {
+        return path.join(this.dir, 'seg-' + String(seg).padStart(6, '0') + '.dat');
+    }
+
+    fd(seg) {
+        if(!this.fds.has(seg)) this.fds.set(seg, fs.openSync(this.segName(seg), (this.readonly ? 'r' : 'a+')));
+        return this.fds.get(seg);
+    }
+
+    // rebuild the index from the block headers in the segments
+    load() {
+        var hdrbuf = Buffer.alloc(HEADER_FIXED + ID_MAX);
+        var segs = [];
+
+        if(fs.existsSync(this.dir)) {
+            segs = fs.readdirSync(this.dir).filter(name => /^seg-\d{6}\.dat$/.test(name))
+                                          .map(name => parseInt(name.substr(4, 6))).sort((a, b) => a - b);
+        }
+        segs.forEach((seg) => {
+            var fd = this.fd(seg);
+            var size = fs.fstatSync(fd).size;
+            var offset = 0;
+
+            while(offset + HEADER_FIXED <= size) {
+                fs.readSync(fd, hdrbuf, 0, hdrbuf.length, offset);
+                var hdr = blockHeader(hdrbuf);
+                // a partly written block at the end is ignored
+                if((hdr.magic !== BLOCK_MAGIC) || (offset + hdr.length > size)) break;
+                this.addIndex(hdr.id, {seg: seg, offset: offset, length: hdr.length, first: hdr.first, last: hdr.last});
+                this.stats.points += hdr.count;
+                this.stats.blocks += 1;
+                this.stats.bytes += hdr.length;
+                offset += hdr.length;
+            }
+            // new blocks are appended, anything after the last good block has to go
+            if(!this.readonly && (offset < size)) fs.ftruncateSync(fd, offset);
+            this.seg = seg;
+            this.segsize = offset;
+        });
+        if(this.seg === 0) this.seg = 1;
+    }
+
+    addIndex(id, entry) {
+        if(!this.index.has(id)) this.index.set(id, []);
+        this.index.get(id).push(entry);
+    }
+
+    /*
+        Add a reading, t10 & h10 are in tenths. Readings for a device
+        must be added in time order.
+    */
+    append(id, time, seq, t10, h10) {
+        if(!this.open.has(id)) this.open.set(id, []);
+        var pts = this.open.get(id);
+
+        pts.push({time: time, seq: seq, t10: t10, h10: h10});
+        this.stats.points += 1;
+        if(pts.length >= BLOCK_POINTS) this.writeBlock(id, pts);
+    }
+
+    writeBlock(id, pts) {
+        var block = encodeBlock(id, pts, this.scratch);
+
+        if((this.segsize > 0) && (this.segsize + block.length > this.segbytes)) {
+            this.seg += 1;
+            this.segsize = 0;
+        }
+        fs.writeSync(this.fd(this.seg), block);
+        this.addIndex(id, {seg: this.seg, offset: this.segsize, length: block.length, first: pts[0].time, last: pts[pts.length - 1].time});
+        this.segsize += block.length;
+        this.stats.blocks += 1;
+        this.stats.bytes += block.length;
+        pts.length = 0;
+    }
+
+    // write the partly filled blocks
+    flush() {
+        this.open.forEach((pts, id) => {
+            if(pts.length > 0) this.writeBlock(id, pts);
+        });
+    }
+
+    close() {
+        if(!this.readonly) this.flush();
+        this.fds.forEach((fd) => fs.closeSync(fd));
+        this.fds.clear();
+    }
+
+    /*
+        A device's readings from `from` to `to` (milliseconds, inclusive),
+        `each(time, seq, t10, h10)` is called for each one in time order.
+        Returns the number of readings.
+    */
+    query(id, from, to, each) {
+        var count = 0;
+        var blocks = this.index.get(id) || [];
+        var buf = null;
+
+        function visit(time, seq, t10, h10) {
+            if((time >= from) && (time <= to)) {
+                count += 1;
+                each(time, seq, t10, h10);
+            }
+        }
+
+        blocks.forEach((blk) => {
+            if((blk.last < from) || (blk.first > to)) return;
+            if((buf === null) || (buf.length < blk.length)) buf = Buffer.alloc(Math.max(blk.length, 4096));
+            fs.readSync(this.fd(blk.seg), buf, 0, blk.length, blk.offset);
+            decodeBlock(buf, visit);
+        });
+        (this.open.get(id) || []).forEach((pt) => visit(pt.time, pt.seq, pt.t10, pt.h10));
+        return count;
+    }
+
+    devices() {
+        return Array.from(new Set([...this.index.keys(), ...this.open.keys()]));
+    }
+}
+
+module.exports = TSStore;
+
+/* ************************************************************************ */
+/*
+    Benchmark and query tool
+*/
+if((require.main === module) && (process.argv[2] === 'bench')) {
+    const dir = process.argv[3] || './tsdb-bench';
+    const ndev = parseInt(process.argv[4]) || 1000;
+    const days = parseInt(process.argv[5]) || 365;
+    const STEP = 300000;
+    const start = Date.UTC(2025, 0, 1);
+    const steps = (days * 86400000) / STEP;
+
+    fs.rmSync(dir, {recursive: true, force: true});
+    const store = new TSStore(dir);
+
+    // each device has a daily cycle plus noise, a few missed readings and reboots
+    var devs = [];
+    for(var ix = 0; ix < ndev; ix++) {
+        devs.push({id: 'ESP_' + (0xB00000 + ix).toString(16).toUpperCase(), seq: 0, t10: 700 + (ix % 50), h10: 400, phase: ix});
+    }
+
+    var jsonbytes = 0;
+    var began = Date.now();
+    for(var step = 0; step < steps; step++) {
+        var time = start + (step * STEP);
+        for(var ix = 0; ix < ndev; ix++) {
+            var dev = devs[ix];
+            dev.seq = (Math.random() < 0.00005 ? 1 : dev.seq + 1);
+            if(Math.random() < 0.002) continue;
+            var cycle = Math.round(50 * Math.sin(((step + dev.phase) % 288) * (Math.PI / 144)));
+            var t10 = 700 + (ix % 50) + cycle + Math.floor(Math.random() * 3) - 1;
+            var h10 = 400 - cycle + Math.floor(Math.random() * 5) - 2;
+            // jitter in the arrival time
+            store.append(dev.id, time + Math.floor(Math.random() * 200), dev.seq, t10, h10);
+            jsonbytes += `{"dev_id":"${dev.id}","seq":${dev.seq},"t":${(t10 / 10).toFixed(2)},"h":${(h10 / 10).toFixed(2)}}`.length + 8;
+        }
+    }
+    store.flush();
+    var ingestms = Date.now() - began;
+
+    var pts = store.stats.points;
+    console.log(`${ndev} devices, ${days} days, ${pts} readings`);
+    console.log(`ingest - ${(pts / (ingestms / 1000) / 1e6).toFixed(2)}M readings/s (${(ingestms / 1000).toFixed(1)}s)`);
+    console.log(`stored ${(store.stats.bytes / 1048576).toFixed(1)}MB in ${store.stats.blocks} blocks, ${(store.stats.bytes / pts).toFixed(2)} bytes/reading`);
+    console.log(`compression - ${(jsonbytes / store.stats.bytes).toFixed(1)}x vs JSON + 8 byte time, ${((pts * 16) / store.stats.bytes).toFixed(1)}x vs 16 byte binary records`);
+    store.close();
+
+    began = Date.now();
+    const reader = new TSStore(dir, {readonly: true});
+    console.log(`open (index rebuild) - ${Date.now() - began}ms`);
+
+    [1, 30, days].forEach((span) => {
+        var queries = 200;
+        var total = 0;
+        began = process.hrtime.bigint();
+        for(var ix = 0; ix < queries; ix++) {
+            var dev = devs[Math.floor(Math.random() * ndev)];
+            var from = start + Math.floor(Math.random() * Math.max(1, (days - span) * 86400000));
+            total += reader.query(dev.id, from, from + (span * 86400000), () => {});
+        }
+        var ms = Number(process.hrtime.bigint() - began) / 1e6;
+        console.log(`query ${span} day(s) - ${(ms / queries).toFixed(3)}ms each, ${(total / (ms / 1000) / 1e6).toFixed(2)}M readings/s`);
+    });
+    reader.close();
+} else if((require.main === module) && (process.argv[2] === 'query')) {
+    const from = (process.argv[5] ? Date.parse(process.argv[5]) : 0);
+    const to = (process.argv[6] ? Date.parse(process.argv[6]) : Date.now());
+    // the collector keeps a store for each parse thread, p0, p1...
+    const dirs = [process.argv[3]].concat(fs.readdirSync(process.argv[3]).filter(name => /^p\d+$/.test(name))
+                                                                     .map(name => path.join(process.argv[3], name)));
+    var count = 0;
+
+    dirs.forEach((dir) => {
+        const store = new TSStore(dir, {readonly: true});
+        count += store.query(process.argv[4], from, to, (time, seq, t10, h10) => {
+            console.log(`${new Date(time).toISOString()}  seq ${seq}  t ${(t10 / 10).toFixed(1)}  h ${(h10 / 10).toFixed(1)}`);
+        });
+        store.close();
+    });
+    console.log(`${count} readings`);
+}
@@ -0,0 +1,10 @@
+/* ************************************************************************ */
+/*
+    prof-defs.h - the loop profiling switch, used by esp8266-prof.* and by
+    the DHT library (to time the interrupts-off window).
+*/
+#pragma once
+
+// Uncomment to enable the loop & phase timing histograms. When this is
+// commented out the profiling code is not compiled.
+//#define LOOP_PROFILE
@@ -0,0 +1,292 @@
+/* ************************************************************************ */
+/*
+    sensor-derived.cpp - the heat index and dew point, in fixed point.
+
+    See sensor-derived.h for details.
+*/
+#include "../adafruit/DHT.h"
+#include "sensor-derived.h"
+
+// the heat index table, tenths of a degree C from HI_T_MIN to HI_T_MAX
+// every HI_T_STEP (columns) and 0 to 100 % RH every 5 % (rows)
+#define HI_T_MIN    240
+#define HI_T_STEP   20
+#define HI_COLS     17
+#define HI_T_MAX    (HI_T_MIN + ((HI_COLS - 1) * HI_T_STEP))
+// the dew point table, from DP_T_MIN every DP_T_STEP
+#define DP_T_MIN    -400
+#define DP_T_STEP   100
+#define DP_COLS     13
+// the rows of both tables
+#define RH_STEP     50
+#define RH_ROWS     21
+
+/* ************************************************************************ */
+/*
+    Table generation - the tables are filled in by the compiler. C++11
+    only allows a return statement in a constexpr function, so the loops
+    are recursion and there's a template that makes the list of entry
+    numbers, 0 to N - 1.
+*/
+template<int... I> class derivedseq {};
+template<int N, int... I> class derivedgen : public derivedgen<N - 1, N - 1, I...> {};
+template<int... I> class derivedgen<0, I...> {
+    public:
+        typedef derivedseq<I...> type;
+};
+
+template<int N> class derivedtable {
+    public:
+        int16_t v[N];
+};
+
+constexpr double cxAbs(double x)
+{
+    return (x < 0 ? -x : x);
+}
+
+// Newton's method, `g` is the current guess
+constexpr double cxSqrt(double x, double g = 1.0, int n = 24)
+{
+    return (n == 0 ? g : cxSqrt(x, 0.5 * (g + (x / g)), n - 1));
+}
+
+// ln(x) = 2 atanh((x - 1) / (x + 1)), the series is summed once
+// x is between 0.5 and 1
+constexpr double cxAtanh(double term, double y2, int k, int n)
+{
+    return (n == 0 ? 0 : (term / k) + cxAtanh(term * y2, y2, k + 2, n - 1));
+}
+
+constexpr double cxLn(double x)
+{
+    return (x < 0.5 ? cxLn(x * 2) - 0.69314718055994531 : 2 * cxAtanh((x - 1) / (x + 1), ((x - 1) / (x + 1)) * ((x - 1) / (x + 1)), 1, 24));
+}
+
+constexpr int16_t cxTenths(double v)
+{
+    return (int16_t)(v < 0 ? (v * 10) - 0.5 : (v * 10) + 0.5);
+}
+
+/*
+    Rothfusz's regression and its adjustments, as in DHT::computeHeatIndex().
+    The steps are in F and the result in C. The table has it everywhere, the
+    simple formula is used at run time when it's 79 F or less.
+*/
+constexpr double hiAdjust(double t, double rh, double hi)
+{
+    return (((rh < 13) && (t >= 80.0) && (t <= 112.0)) ? hi - (((13.0 - rh) * 0.25) * cxSqrt((17.0 - cxAbs(t - 95.0)) * 0.05882)) :
+           (((rh > 85.0) && (t >= 80.0) && (t <= 87.0)) ? hi + (((rh - 85.0) * 0.1) * ((87.0 - t) * 0.2)) : hi));
+}
+
+constexpr double hiRothfusz(double t, double rh)
+{
+    return -42.379 + (2.04901523 * t) + (10.14333127 * rh) + (-0.22475541 * t * rh) + (-0.00683783 * t * t) +
+           (-0.05481717 * rh * rh) + (0.00122874 * t * t * rh) + (0.00085282 * t * rh * rh) + (-0.00000199 * t * t * rh * rh);
+}
+
+constexpr double hiEntryF(double t, double rh)
+{
+    return hiAdjust(t, rh, hiRothfusz(t, rh));
+}
+
+constexpr int16_t hiEntry(int ix)
+{
+    return cxTenths((hiEntryF((((HI_T_MIN + ((ix % HI_COLS) * HI_T_STEP)) / 10.0) * 1.8) + 32, (ix / HI_COLS) * (RH_STEP / 10.0)) - 32) / 1.8);
+}
+
+/*
+    The Magnus formula, the first row is for 1 % RH instead of 0
+*/
+constexpr double dpGamma(double t, double rh)
+{
+    return cxLn(rh / 100) + ((17.62 * t) / (243.12 + t));
+}
+
+constexpr double dpEntryC(double t, double rh)
+{
+    return (243.12 * dpGamma(t, rh)) / (17.62 - dpGamma(t, rh));
+}
+
+constexpr int16_t dpEntry(int ix)
+{
+    return cxTenths(dpEntryC((DP_T_MIN + ((ix % DP_COLS) * DP_T_STEP)) / 10.0, ((ix / DP_COLS) == 0 ? 1.0 : (ix / DP_COLS) * (RH_STEP / 10.0))));
+}
+
+template<int... I> constexpr derivedtable<sizeof...(I)> hiMake(derivedseq<I...>)
+{
+    return {{ hiEntry(I)... }};
+}
+
+template<int... I> constexpr derivedtable<sizeof...(I)> dpMake(derivedseq<I...>)
+{
+    return {{ dpEntry(I)... }};
+}
+
+// in flash, they're read with pgm_read_word()
+static constexpr derivedtable<HI_COLS * RH_ROWS> hiTable PROGMEM = hiMake(derivedgen<HI_COLS * RH_ROWS>::type());
+static constexpr derivedtable<DP_COLS * RH_ROWS> dpTable PROGMEM = dpMake(derivedgen<DP_COLS * RH_ROWS>::type());
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ************************************************************************ */
+/*
+    Bilinear interpolation in a table, `x` is the temperature in tenths.
+    Outside of the table the nearest edge is used. The table is in flash.
+*/
+static int16_t derivedLookup(const int16_t *tab, int cols, int16_t xmin, int16_t xstep, int16_t x, int16_t h10)
+{
+int32_t fx = constrain(x - xmin, 0, (cols - 1) * xstep);
+int32_t fy = constrain(h10, 0, (RH_ROWS - 1) * RH_STEP);
+int col = fx / xstep;
+int row = fy / RH_STEP;
+int32_t t00;
+int32_t t01;
+int32_t t10;
+int32_t t11;
+int32_t top;
+int32_t bottom;
+int32_t v;
+
+    if(col == (cols - 1)) col -= 1;
+    if(row == (RH_ROWS - 1)) row -= 1;
+    fx -= col * xstep;
+    fy -= row * RH_STEP;
+    tab += (row * cols) + col;
+    t00 = (int16_t)pgm_read_word(&tab[0]);
+    t01 = (int16_t)pgm_read_word(&tab[1]);
+    t10 = (int16_t)pgm_read_word(&tab[cols]);
+    t11 = (int16_t)pgm_read_word(&tab[cols + 1]);
+
+    // scaled by xstep, then by xstep * RH_STEP
+    top = (t00 * xstep) + ((t01 - t00) * fx);
+    bottom = (t10 * xstep) + ((t11 - t10) * fx);
+    v = (top * RH_STEP) + ((bottom - top) * fy);
+    return (v + ((v < 0 ? -1 : 1) * ((xstep * RH_STEP) / 2))) / (xstep * RH_STEP);
+}
+
+// tenths of a degree F to tenths of a degree C, rounded
+int16_t convertFtoC10(int32_t f)
+{
+    return (((f - 320) * 5) + (f < 320 ? -4 : 4)) / 9;
+}
+
+/*
+    The heat index - Steadman's simple formula, and when that's over
+    79 F the table. The simple formula is 1.1 T - 10.3 + 0.047 RH in F,
+    in tenths it is (1100 T - 103000 + 47 RH) / 1000.
+*/
+int16_t heatIndex10(int16_t t10, int16_t h10, bool fahrenheit)
+{
+int32_t simple = (1100L * DHT::convertCtoF10(t10)) - 103000L + (47L * h10);
+int16_t hi;
+
+    simple = (simple + (simple < 0 ? -500 : 500)) / 1000;
+    if(simple <= 790) return (fahrenheit ? simple : convertFtoC10(simple));
+
+    hi = derivedLookup(hiTable.v, HI_COLS, HI_T_MIN, HI_T_STEP, t10, h10);
+    return (fahrenheit ? DHT::convertCtoF10(hi) : hi);
+}
+
+int16_t dewPoint10(int16_t t10, int16_t h10, bool fahrenheit)
+{
+int16_t dp = derivedLookup(dpTable.v, DP_COLS, DP_T_MIN, DP_T_STEP, t10, h10);
+
+    return (fahrenheit ? DHT::convertCtoF10(dp) : dp);
+}
+
+#ifdef DERIVED_BENCH
+// calls per timing
+#define DERIVED_BENCH_CALLS 1000
+
+// the reference dew point, in float
+float dewPointRef(float t, float rh)
+{
+float gamma = logf(rh / 100) + ((17.62f * t) / (243.12f + t));
+
+    return (243.12f * gamma) / (17.62f - gamma);
+}
+
+/*
+    Compare the results to the reference formulas over the range of the
+    DHT22, and time them. The heat index is only compared up to the end 
+    of its table and the dew point above 10 % RH.
+*/
+void derivedBench()
+{
+DHT dht;
+float err;
+float hierr = 0;
+float dperr = 0;
+float hisum = 0;
+float dpsum = 0;
+uint32_t hicount = 0;
+uint32_t dpcount = 0;
+int16_t hiworst[2] = {0, 0};
+int16_t dpworst[2] = {0, 0};
+int16_t t10;
+int16_t h10;
+volatile int32_t sink = 0;
+uint32_t cycles;
+int ix;
+
+    Serial.println();
+    Serial.println("derivedBench() - errors in C, cycles per call");
+
+    for(t10 = -400; t10 <= 800; t10 += 7)
+    {
+        for(h10 = 0; h10 <= 1000; h10 += 9)
+        {
+            // the heat index isn't defined past the end of its table
+            err = (t10 > HI_T_MAX ? 0 : fabs((heatIndex10(t10, h10, false) / 10.0f) - dht.computeHeatIndex(t10 / 10.0f, h10 / 10.0f, false)));
+            hisum += err;
+            hicount += (t10 > HI_T_MAX ? 0 : 1);
+            if(err > hierr)
+            {
+                hierr = err;
+                hiworst[0] = t10;
+                hiworst[1] = h10;
+            }
+            if(h10 < 100) continue;
+            err = fabs((dewPoint10(t10, h10, false) / 10.0f) - dewPointRef(t10 / 10.0f, h10 / 10.0f));
+            dpsum += err;
+            dpcount += 1;
+            if(err > dperr)
+            {
+                dperr = err;
+                dpworst[0] = t10;
+                dpworst[1] = h10;
+            }
+        }
+    }
+    Serial.println("heat index - mean " + String(hisum / hicount, 3) + "  max " + String(hierr, 2) + " at " + String(hiworst[0]) + " " + String(hiworst[1]));
+    Serial.println("dew point  - mean " + String(dpsum / dpcount, 3) + "  max " + String(dperr, 2) + " at " + String(dpworst[0]) + " " + String(dpworst[1]));
+
+    cycles = ESP.getCycleCount();
+    for(ix = 0; ix < DERIVED_BENCH_CALLS; ix++) sink += heatIndex10(250 + (ix % 150), ix % 1000, true);
+    cycles = ESP.getCycleCount() - cycles;
+    Serial.println("heatIndex10()        " + String(cycles / DERIVED_BENCH_CALLS));
+
+    cycles = ESP.getCycleCount();
+    for(ix = 0; ix < DERIVED_BENCH_CALLS; ix++) sink += (int32_t)dht.computeHeatIndex(77.0f + ((ix % 150) / 5.0f), (ix % 1000) / 10.0f, true);
+    cycles = ESP.getCycleCount() - cycles;
+    Serial.println("computeHeatIndex()   " + String(cycles / DERIVED_BENCH_CALLS));
+
+    cycles = ESP.getCycleCount();
+    for(ix = 0; ix < DERIVED_BENCH_CALLS; ix++) sink += dewPoint10(ix % 400, 100 + (ix % 900), false);
+    cycles = ESP.getCycleCount() - cycles;
+    Serial.println("dewPoint10()         " + String(cycles / DERIVED_BENCH_CALLS));
+
+    cycles = ESP.getCycleCount();
+    for(ix = 0; ix < DERIVED_BENCH_CALLS; ix++) sink += (int32_t)dewPointRef((ix % 400) / 10.0f, (100 + (ix % 900)) / 10.0f);
+    cycles = ESP.getCycleCount() - cycles;
+    Serial.println("float dew point      " + String(cycles / DERIVED_BENCH_CALLS));
+    Serial.println();
+}
+#endif // DERIVED_BENCH
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,43 @@
+/* ************************************************************************ */
+/*
+    sensor-derived.h - the heat index and dew point, in fixed point.
+
+    The temperature is in tenths of a degree C and the humidity is in
+    tenths of a percent, the results are in tenths of a degree C or F.
+    Both are looked up in 2-D tables, one entry for every 2 C (heat index)
+    or 10 C (dew point) and every 5 % RH, with bilinear interpolation. The
+    tables are computed by the compiler from the reference formulas (see
+    sensor-derived.cpp), there's no float math at run time and they take
+    1260 bytes of flash (PROGMEM) instead of RAM.
+
+    The heat index is the one in DHT::computeHeatIndex(), the dew point is
+    the Magnus formula. The interpolated heat index is within about 0.3 C
+    of the formula, except next to the formula's own steps where it can 
+    be 0.8 C. Its table ends at 56 C, the formula isn't meant for hotter
+    air. The dew point is within about 0.4 C above 10 % RH.
+
+    When DERIVED_BENCH is defined derivedBench() compares the results
+    with the reference formulas in float and prints the errors, and the
+    CPU cycles used by each, it's called during start up.
+*/
+#pragma once
+
+#include <stdint.h>
+
+// Uncomment to check the tables and time them during start up
+//#define DERIVED_BENCH
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int16_t heatIndex10(int16_t t10, int16_t h10, bool fahrenheit);
+extern int16_t dewPoint10(int16_t t10, int16_t h10, bool fahrenheit);
+extern int16_t convertFtoC10(int32_t f10);
+#ifdef DERIVED_BENCH
+extern void derivedBench();
+#endif
+
+#ifdef __cplusplus
+}
+#endif
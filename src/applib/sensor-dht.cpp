@@ -8,6 +8,16 @@
 #include "esp8266-ino.h"
 #include "esp8266-udp.h"
 #include "sensor-dht.h"
+#include "esp8266-prof.h"
+#include "esp8266-log.h"
+#include "sensor-stats.h"
+#include "sensor-filter.h"
+#include "sensor-derived.h"
+#ifdef SENSOR_PROFILE
+#include "sensor-profile.h"
+
+typedef SensorProfile<SENSOR_PROFILE_SCALE, SENSOR_PROFILE_REPORT> profile;
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,9 +27,28 @@ extern "C" {
 // before reporting an error
 #define MAX_NAN 5
 
-// Initialize the temperature/humidity sensor
-// NOTE: The DHT class has been modified from its original.
-DHT dht;
+// the most quick re-reads after a failed read, and the time between 
+// them for the first sensor. A sensor can't be read any sooner.
+#define MAX_RETRIES 5
+#define RETRY_INTERVAL SensorDriver::minInterval()
+
+// the shortest interval between readings in "STATS" mode
+#define STATS_MIN_SAMPLE SensorDriver::minInterval()
+
+// more than one sensor - the start of each sensor's first reading
+// is this far apart, a little more than a reading takes
+#define SENSOR_STAGGER (SensorDriver::readTime() + 25)
+// the readings that are due within this long of the first one are
+// sent in one packet
+#define SENSOR_TICK 1000
+// a read isn't started until this long after a packet is sent
+#define SENSOR_TX_GUARD 20
+
+// the result of updateSensorData()
+enum readresult { READ_FAIL = 0, READ_OK, READ_REJECTED, READ_RETRY };
+
+// the temperature/humidity sensor, see sensor-driver.h
+SensorDriver drv;
 
 // sensor config data
 sensorconfig scfg;
@@ -27,68 +56,294 @@ sensorconfig scfg;
 livesensor sensor;
 livesensor sensorlast;
 
+// the additional sensors ("probes"), their settings are in 
+// scfg.probes. A probe with an interval of 0 isn't used. Each
+// slot has its own driver type, see probeStart().
+ProbeDriver1 probedrv1;
+ProbeDriver2 probedrv2;
+livesensor probe[SENSOR_MAX - 1];
+livesensor probelast[SENSOR_MAX - 1];
+uint8_t probeCount = 0;
+
+// the readings waiting to be sent, bit 0 is the first sensor 
+// and bit 1 and up are the probes
+uint8_t batchMask = 0;
+unsigned long batchStart = 0;
+
+// the sensor with a reading in progress, the same numbers as 
+// batchMask's bits, or -1. Only one sensor is read at a time.
+int8_t reading = -1;
+
+// see getBootID()
+uint32_t bootID = 0;
+
+// the "STATS" mode window, a summary is sent when it's due
+winstat tstats;
+winstat hstats;
+unsigned long statsDue = 0;
+
+reporttype reportMode()
+{
+#ifdef SENSOR_PROFILE
+    return profile::mode();
+#else
+    return scfg.report_id;
+#endif
+}
+
+scaletype scaleMode()
+{
+#ifdef SENSOR_PROFILE
+    return profile::scale();
+#else
+    return scfg.scale_id;
+#endif
+}
+
+// the interval between readings in "STATS" mode
+unsigned long statsSample()
+{
+unsigned long sample = (scfg.stats_sample > 0 ? scfg.stats_sample : scfg.interval / 10);
+
+    return (sample < STATS_MIN_SAMPLE ? STATS_MIN_SAMPLE : sample);
+}
+
+// start a new "STATS" window
+void statsStart()
+{
+    statsReset(tstats);
+    statsReset(hstats);
+    statsDue = scfg.interval + appMillis();
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+// the functions that are templates on the driver can't have C linkage
+
 /*
-    Get fresh data from the sensor and save it in the `sensor`
-    object. Also check it for "is a NaN" and id it is then
-    return `false` and let the caller decide the next step.
+    Returns FAULT_RANGE if the reading (tenths of a degree C) can't 
+    be from a working sensor, otherwise FAULT_NONE.
 */
-bool updateSensorData() 
+template<class DRIVER>
+sensorfault checkRange(int16_t t10, int16_t h10)
 {
-bool bRet = true;
+    if((t10 < DRIVER::tempMin()) || (t10 > DRIVER::tempMax()) || (h10 < 0) || (h10 > DRIVER::humidMax())) return FAULT_RANGE;
+    return FAULT_NONE;
+}
 
-    // read values from the sensor
-    sensor.h = dht.readHumidity();
-    sensor.t = dht.readTemperature(!(scfg.scale == "F" ? false : true));
+/*
+    Get a finished reading from a sensor's driver, the values are 
+    in tenths of a degree and tenths of a percent. Returns FAULT_NONE
+    or the reason the read failed.
+*/
+template<class DRIVER>
+sensorfault readSensor(DRIVER &_drv, int16_t &t10, int16_t &h10)
+{
+sensorfault fault;
+
+    if((fault = _drv.result(t10, h10)) != FAULT_NONE) return fault;
+    if((fault = checkRange<DRIVER>(t10, h10)) != FAULT_NONE) return fault;
+    if(scaleMode() == SCALE_F) t10 = DHT::convertCtoF10(t10);
+    return FAULT_NONE;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    The failed reads since the last good reading, for the status
+    messages. `num` is the sensor's number, 0 is the first one.
+*/
+String faultSummary(const livesensor &_sensor, uint8_t num)
+{
+String summary = "";
+
+    if(num > 0) summary = "sensor " + String(num) + " ";
+    return summary + "faults " + String(_sensor.timeouts + _sensor.badsums + _sensor.ranges) + " - timeout " + String(_sensor.timeouts) + 
+           " checksum " + String(_sensor.badsums) + " range " + String(_sensor.ranges);
+}
+
+/*
+    Count a failed read of sensor `num`. Returns READ_RETRY until the
+    retries are used up and then READ_FAIL.
 
-    if(isnan(sensor.t) || isnan(sensor.h))
+    Only one SENSOR_FAULT status is sent for a run of failed reads,
+    then a SENSOR_ERROR every MAX_NAN failures and one SENSOR_RECOVER
+    when it ends (see readGood()). Each has the number of failed reads
+    by type.
+*/
+readresult readFailed(livesensor &_sensor, livesensor &_last, sensorfault fault, uint8_t num)
+{
+    if(fault == FAULT_TIMEOUT) _sensor.timeouts += 1;
+    else if(fault == FAULT_CHECKSUM) _sensor.badsums += 1;
+    else _sensor.ranges += 1;
+
+    LOG_WARN("readFailed(%d) - fault %d  retries %d", num, fault, _sensor.retries);
+
+    // most failures are one bad frame, try again soon
+    if(_sensor.retries < constrain(scfg.retries, 0, MAX_RETRIES))
     {
-        sensor.nancount += 1;
+        _sensor.retries += 1;
+        return READ_RETRY;
+    }
+    _sensor.retries = 0;
+    _sensor.nancount += 1;
 
-        if(!checkDebugMute()) sendStatus("SENSOR_FAULT", "NaN " + String(isnan(sensor.t)) + "  "  + String(isnan(sensor.h)));
-        sendStatus("SENSOR_FAULT", "NaN " + String(sensor.nancount));
+    // the first of a run
+    if((_sensor.nancount == 1) && (_sensor.errcount == 0)) sendStatus("SENSOR_FAULT", faultSummary(_sensor, num));
 
-        if(!checkDebugMute()) Serial.println("updateSensorData() - nancount = " + String(sensor.nancount));
+    LOG_DBG("readFailed(%d) - nancount = %d", num, _sensor.nancount);
 
-        // if/when we get a good data reading this will make
-        // sure that chkReport() will return 'true'
-        sensor.h = sensorlast.h = 0;
-        sensor.t = sensorlast.t = 0;
+    // if/when we get a good data reading this will make
+    // sure that chkReport() will return 'true'
+    _sensor.h = _last.h = 0;
+    _sensor.t = _last.t = 0;
+    _sensor.h10 = _last.h10 = 0;
+    _sensor.t10 = _last.t10 = 0;
 
-        bRet = false;
+    if(_sensor.nancount >= MAX_NAN) 
+    {
+        sendStatus("SENSOR_ERROR", faultSummary(_sensor, num));
+        _sensor.nancount = 0;
+        _sensor.errcount += 1;
+    }
+    return READ_FAIL;
+}
 
-        if(sensor.nancount >= MAX_NAN) 
-        {
-            sendStatus("SENSOR_ERROR", "Too many NaN readings from sensor");
-            sensor.nancount = 0;
-            sensor.errcount += 1;
-        }
+/*
+    Save a good reading of sensor `num`
+*/
+void readGood(livesensor &_sensor, int16_t t10, int16_t h10, uint8_t num)
+{
+    _sensor.t10 = t10;
+    _sensor.h10 = h10;
+    _sensor.t = (float)_sensor.t10 / 10;
+    _sensor.h = (float)_sensor.h10 / 10;
+
+    // if a SENSOR_FAULT was sent then announce that we've 
+    // recovered and have good data
+    if((_sensor.nancount > 0) || (_sensor.errcount > 0))
+    {
+        sendStatus("SENSOR_RECOVER", faultSummary(_sensor, num));
+        _sensor.errcount = 0;
+        _sensor.nancount = 0;
+    } else if(_sensor.retries > 0) LOG_INFO("readGood(%d) - good after %d retries", num, _sensor.retries);
+    _sensor.retries = 0;
+    _sensor.timeouts = 0;
+    _sensor.badsums = 0;
+    _sensor.ranges = 0;
+    // each time we successfully update the data from the sensor increment 
+    // the sequence number. this will assist in determining data updates vs
+    // data reports.
+    _sensor.seq += 1;
+}
+
+/*
+    Adaptive sampling - see sensorconfig. Returns true if it's
+    enabled in the sensor configuration.
+*/
+bool adaptEnabled()
+{
+    return ((scfg.interval_min > 0) && (scfg.interval_max > scfg.interval_min));
+}
+
+/*
+    Choose the interval to the next reading, called after each
+    good reading. A change faster than the configured slope since 
+    the previous reading shortens the interval to interval_min, 
+    otherwise it backs off geometrically to interval_max.
+*/
+unsigned long nextInterval()
+{
+static int16_t prev_t10 = 0;
+static int16_t prev_h10 = 0;
+static unsigned long prev_time = 0;
+static bool prev_valid = false;
+unsigned long now = appMillis();
+unsigned long elapsed = timeSince(now, prev_time);
+bool fast = false;
+
+    if(!adaptEnabled()) return scfg.interval;
+
+    if(prev_valid && (elapsed > 0))
+    {
+        // compare (change / elapsed) to (slope / minute) without dividing
+        if((scfg.slope_t > 0) && ((abs(sensor.t10 - prev_t10) * 60000UL) > (scfg.slope_t * elapsed))) fast = true;
+        if((scfg.slope_h > 0) && ((abs(sensor.h10 - prev_h10) * 60000UL) > (scfg.slope_h * elapsed))) fast = true;
+    }
+    prev_t10 = sensor.t10;
+    prev_h10 = sensor.h10;
+    prev_time = now;
+    prev_valid = true;
+
+    if(fast) sensor.interval = scfg.interval_min;
+    else sensor.interval = constrain(sensor.interval * scfg.backoff, scfg.interval_min, scfg.interval_max);
+
+    LOG_DBG("nextInterval() - fast = %d  interval = %lu", fast, sensor.interval);
+    return sensor.interval;
+}
+
+/*
+    Get fresh data from the sensor, filter it and save it in the 
+    `sensor` object. If the read fails return `READ_RETRY` until
+    the retries are used up and then `READ_FAIL`, and let the 
+    caller decide the next step. A reading that the filter rejects
+    is not saved.
+*/
+readresult updateSensorData() 
+{
+readresult result = READ_OK;
+sensorfault fault;
+int16_t t10 = 0;
+int16_t h10 = 0;
 
+    // read values from the sensor
+    if((fault = readSensor(drv, t10, h10)) != FAULT_NONE) result = readFailed(sensor, sensorlast, fault, 0);
+    else if(!filterReading(t10, h10, appMillis())) 
+    {
+        LOG_WARN("updateSensorData() - rejected %d  %d", t10, h10);
+        result = READ_REJECTED;
     } else {
-        // if any previous readings were NaN then announce
-        // that we've recovered and have good data
-        if(sensor.errcount > 0)
-        {
-            if(!checkDebugMute()) sendStatus("SENSOR_RECOVER", "Recovered after NaN from sensor - errcount = " + String(sensor.errcount));
-            sendStatus("SENSOR_RECOVER", "nancount = " + String(sensor.nancount));
-            sensor.errcount = 0;
-            sensor.nancount = 0;
-        }
-        // each time we successfully update the data from the sensor increment 
-        // the sequence number. this will assist in determining data updates vs
-        // data reports.
-        sensor.seq += 1;
-        if(!checkDebugMute()) Serial.println("updateSensorData() - " + String(sensor.seq) + "   " + String(sensor.t) + "  " + String(sensor.h));
+        readGood(sensor, t10, h10, 0);
+        LOG_DBG("updateSensorData() - %u   %d  %d", sensor.seq, sensor.t10, sensor.h10);
     }
-    return bRet;
+    return result;
+}
+
+/*
+    The boot ID is drawn when the first report is sent. The hardware
+    random number generator only has the RF noise to work with once the
+    WiFi is up, and startSensor() runs before that. The low 32 bits of
+    the MAC are mixed in so that devices that start together still get
+    different IDs. 0 isn't used.
+*/
+uint32_t getBootID(const conninfo &conn)
+{
+uint32_t mac = ((uint32_t)conn.mac[2] << 24) | ((uint32_t)conn.mac[3] << 16) | ((uint32_t)conn.mac[4] << 8) | conn.mac[5];
+
+    while(bootID == 0) bootID = ESP.random() ^ mac;
+    return bootID;
 }
 
 void readSensorNow(sensornow &_sensor)
 {
-    // read values from the sensor
-    _sensor.hnow = dht.readHumidity();
-    _sensor.tnow = dht.readTemperature(!(scfg.scale == "F" ? false : true));
-    if(isnan(_sensor.hnow) || isnan(_sensor.tnow))
-        _sensor.hnow = _sensor.tnow = 0;
+int16_t t10 = 0;
+int16_t h10 = 0;
+
+    // read values from the sensor, they'll be 0 if the read failed.
+    // a reading that's in progress is finished first.
+    if(reading == 0) while(!drv.poll()) yield();
+    else 
+    {
+        drv.start();
+        while(!drv.poll()) yield();
+    }
+    if(readSensor(drv, t10, h10) != FAULT_NONE) t10 = h10 = 0;
+    _sensor.tnow = (float)t10 / 10;
+    _sensor.hnow = (float)h10 / 10;
 
     // also provide the last readings and seq #
     _sensor.hlast = sensorlast.h;
@@ -107,11 +362,17 @@ String sensorData;
     {
         // construct the JSON string with our data inside...
         //
-        // example : {"dev_id":"ESP_290767","seq":1,"t":71.5,"h":37.40}
+        // example : {"dev_id":"ESP_290767","boot":2712847316,"rseq":7,"seq":1,"t":71.5,"h":37.40}
         sensorData = "{\"dev_id\":\"" + conn.hostname + "\"";
+        sensorData = sensorData + ",\"boot\":" + String(getBootID(conn)) + ",\"rseq\":" + String(sensor.rseq += 1);
         sensorData = sensorData + ",\"seq\":" + String(_sensor.seq);
         sensorData = sensorData + ",\"t\":" + String(_sensor.tnow) + ",\"h\":" + String(_sensor.hnow);
         sensorData = sensorData + ",\"last\":{\"t\":"+ String(_sensor.tlast) + ",\"h\":" + String(_sensor.hlast) +"}";
+        // the current interval, see nextInterval()
+        if(adaptEnabled()) sensorData = sensorData + ",\"iv\":" + String(sensor.interval);
+#ifdef SOAK_TEST
+        sensorData = sensorData + ",\"vt\":" + String(appMillis());
+#endif
         sensorData = sensorData + "}";
 
         int sent = sendUDP((char *)sensorData.c_str(), strlen(sensorData.c_str()));
@@ -120,6 +381,69 @@ String sensorData;
     return bRet;
 }
 
+/*
+    A window's summary as [min,max,mean,stddev]
+*/
+String statsJSON(const winstat &w)
+{
+    return "[" + String((float)w.min / 10, 1) + "," + String((float)w.max / 10, 1) + "," + 
+           String((float)statsMean(w) / 10, 1) + "," + String((float)statsStdDev(w) / 100, 2) + "]";
+}
+
+/*
+    "STATS" mode - add the new reading to the window, and when the
+    window is over send its summary and start a new one. Returns true
+    if the summary was sent.
+*/
+bool sendSensorStats()
+{
+bool bRet = false;
+conninfo conn;
+String sensorData;
+
+    statsAdd(tstats, sensor.t10);
+    statsAdd(hstats, sensor.h10);
+
+    if(!timeReached(appMillis(), statsDue)) return false;
+
+    if(connWiFi->GetConnInfo(&conn))
+    {
+        PROF_BEGIN(PROF_SERIAL);
+        // example : {"dev_id":"ESP_290767","boot":2712847316,"rseq":7,"seq":61,"n":10,
+        //            "t":[70.1,71.5,70.8,0.42],"h":[37.2,38.0,37.5,0.25]}
+        sensorData = "{\"dev_id\":\"" + conn.hostname + "\"";
+        sensorData = sensorData + ",\"boot\":" + String(getBootID(conn)) + ",\"rseq\":" + String(sensor.rseq += 1);
+        sensorData = sensorData + ",\"seq\":" + String(sensor.seq) + ",\"n\":" + String(tstats.n);
+        sensorData = sensorData + ",\"t\":" + statsJSON(tstats) + ",\"h\":" + statsJSON(hstats) + "}";
+        PROF_END(PROF_SERIAL);
+
+        PROF_BEGIN(PROF_SEND);
+        int sent = sendUDP((char *)sensorData.c_str(), strlen(sensorData.c_str()));
+        PROF_END(PROF_SEND);
+        if(sent > 0)
+        {
+            sensorlast = sensor;
+            bRet = true;
+            LOG_DBG("stats - %s", sensorData.c_str());
+        } else LOG_WARN("sendUDP() failed, sent = %d", sent);
+    }
+    statsStart();
+    return bRet;
+}
+
+/*
+    The heat index and dew point of the first sensor's reading, they're
+    computed from the temperature in C.
+*/
+String derivedJSON()
+{
+bool fahrenheit = (scaleMode() == SCALE_F);
+int16_t t10 = (fahrenheit ? convertFtoC10(sensor.t10) : sensor.t10);
+
+    return ",\"hi\":" + String((float)heatIndex10(t10, sensor.h10, fahrenheit) / 10, 1) + 
+           ",\"dp\":" + String((float)dewPoint10(t10, sensor.h10, fahrenheit) / 10, 1);
+}
+
 /*
     Check the configured reporting type and decide if the data should
     be reported (sent via UDP)
@@ -128,144 +452,352 @@ bool chkReport()
 {
 bool bRet = false;
 
+#ifdef SENSOR_PROFILE
+    bRet = profile::report(sensor.t10, sensor.h10, sensorlast.t10, sensorlast.h10, scfg.delta_t, scfg.delta_h);
+#else
     // report ALL values as they are read
-    if(scfg.report == "ALL") 
+    if(scfg.report_id == REPORT_ALL) bRet = true;
+    else
     {
+        // report only if a change was detected...
+        //
+        // calculate the amount of change (if any)
+        // NOTE: Small incremental (below delta
+        // threshold) will not be sent. Then it's 
+        // possible for a sensor to appear "frozen"
+        // and not sending any updates. However a 
+        // small fix by moving "sensorlast = sensor;"
+        // to when the data is actually sent.
+        int t_diff = abs(sensor.t10 - sensorlast.t10);
+        int h_diff = abs(sensor.h10 - sensorlast.h10);
+
+        // Using the configured delta value determine if the
+        // temperature or humidity have changed enough to be
+        // reported. The delta is stored as a integer that
+        // represents the number of "tenths" of change that
+        // must occur to allow the values to be reported.
+        if((t_diff > scfg.delta_t) || (h_diff > scfg.delta_h)) bRet = true;
+
+        LOG_DBG("deltaT = %d    deltaH = %d", scfg.delta_t, scfg.delta_h);
+        LOG_DBG("t_diff = %d    h_diff = %d", t_diff, h_diff);
+
         // save the last reading 
-        sensorlast = sensor;
-        bRet = true;
+        // NOTE: removal should fix frozen sensor, issue #11
+        //sensorlast = sensor;
     }
-    else
-    {
-        float f_deltaT = ((float)(scfg.delta_t) / 10);
-        float f_deltaH = ((float)(scfg.delta_h) / 10);
+#endif
+    return bRet;
+}
 
-        // report only if a change was detected...
-        if(scfg.report == "CHG")
-        {
-            // calculate the amount of change (if any)
-            // NOTE: Small incremental (below delta
-            // threshold) will not be sent. Then it's 
-            // possible for a sensor to appear "frozen"
-            // and not sending any updates. However a 
-            // small fix by moving "sensorlast = sensor;"
-            // to when the data is actually sent.
-            float t_diff = abs(sensor.t - sensorlast.t);
-            float h_diff = abs(sensor.h - sensorlast.h);
-
-            // Using the configured delta value determine if the
-            // temperature or humidity have changed enough to be
-            // reported. The delta is stored as a integer that
-            // represents the number of "tenths" of change that
-            // must occur to allow the values to be reported.
-            if((t_diff > f_deltaT) || (h_diff > f_deltaH)) bRet = true;
-
-            if(!checkDebugMute())
-            {
-                Serial.println("deltaT = " + String(f_deltaT) + "    deltaH = " + String(f_deltaH));
-                Serial.println("t_diff = " + String(t_diff) + "    h_diff = " + String(h_diff));
-            }
+/*
+    Check the reporting type and decide if a probe's reading should
+    be reported. "STATS" mode is for the first sensor only, the 
+    probes report all of their readings in that mode.
+*/
+bool probeReport(uint8_t ix)
+{
+int t_diff = abs(probe[ix].t10 - probelast[ix].t10);
+int h_diff = abs(probe[ix].h10 - probelast[ix].h10);
+
+    if(reportMode() != REPORT_CHG) return true;
+    return ((t_diff > scfg.probes[ix].delta_t) || (h_diff > scfg.probes[ix].delta_h));
+}
 
-            // save the last reading 
-            // NOTE: removal should fix frozen sensor, issue #11
-            //sensorlast = sensor;
+/*
+    Add sensor `num`'s reading to the next packet
+*/
+void batchAdd(uint8_t num)
+{
+    if(batchMask == 0) batchStart = appMillis();
+    batchMask |= (1 << num);
+}
+
+/*
+    Returns true if the packet should wait for another sensor that's
+    due before the tick is over.
+*/
+bool batchWait()
+{
+unsigned long tickEnd = batchStart + SENSOR_TICK;
+uint8_t ix;
 
-        } else bRet = true;
+    if(timeReached(appMillis(), tickEnd)) return false;
+    if(timeReached(tickEnd, sensor.nextup)) return true;
+    for(ix = 0; ix < probeCount; ix++)
+    {
+        if((probe[ix].interval > 0) && timeReached(tickEnd, probe[ix].nextup)) return true;
     }
-    return bRet;
+    return false;
 }
 
 /*
-    Send the current sensor data to the server if the specified interval
-    has elapsed.
+    Send the readings in the batch as one packet. The first sensor's
+    reading is sent as usual and the probes' readings are added as
+    "p", [number, t, h] for each one.
 */
-bool sendSensorData()
+bool sendBatch()
 {
 bool bRet = false;
 conninfo conn;
 String sensorData;
+String derived;
+bool first = true;
+uint8_t ix;
 
-    // Is this sensor up next for a reading?
-    if(sensor.nextup < millis())
+    // if the WiFi is connected...
+    if(connWiFi->GetConnInfo(&conn))
     {
-        // update the sensor data, if an error occurred then 
-        // change the interval between retries... success?
-        if(updateSensorData()) 
+        PROF_BEGIN(PROF_SERIAL);
+        // construct the JSON string with our data inside...
+        //
+        // example : {"dev_id":"ESP_290767","boot":2712847316,"rseq":7,"seq":61,"t":71.5,"h":37.40,"p":[[1,70.1,40.0]]}
+        sensorData = "{\"dev_id\":\"" + conn.hostname + "\"";
+        // 'app_id' currently not used, removed from sensor data.
+        //sensorData = sensorData + ",\"app_id\":\"" + a_cfgdat->getAppName() + "\"";
+        // for finding lost reports, see the README
+        sensorData = sensorData + ",\"boot\":" + String(getBootID(conn)) + ",\"rseq\":" + String(sensor.rseq += 1);
+        if(batchMask & 1)
         {
-            // success!
-            sensor.nextup = scfg.interval + millis();
-
-            if(!checkDebugMute())
+            // convenient for tracking data updates vs. data reports
+            sensorData = sensorData + ",\"seq\":" + String(sensor.seq);
+            sensorData = sensorData + ",\"t\":" + String(sensor.t) + ",\"h\":" + String(sensor.h);
+        }
+        if(batchMask & ~1)
+        {
+            sensorData = sensorData + ",\"p\":[";
+            for(ix = 0; ix < probeCount; ix++)
             {
-                Serial.println("last - " + String(sensorlast.t) + "  " + String(sensorlast.h));
-                Serial.println("live - " + String(sensor.t) + "  " + String(sensor.h));
+                if(!(batchMask & (1 << (ix + 1)))) continue;
+                if(!first) sensorData = sensorData + ",";
+                sensorData = sensorData + "[" + String(ix + 1) + "," + String(probe[ix].t, 1) + "," + String(probe[ix].h, 1) + "]";
+                first = false;
             }
-    
-            // if the WiFi is connected and we're supposed to report the values...
-            if(connWiFi->GetConnInfo(&conn) && chkReport())
+            sensorData = sensorData + "]";
+        }
+#ifdef SOAK_TEST
+        // the virtual time, checked by soak-udp.js
+        sensorData = sensorData + ",\"vt\":" + String(appMillis());
+#endif
+        // optional, and left out if there isn't room for them
+        if((batchMask & 1) && scfg.derived)
+        {
+            derived = derivedJSON();
+            if((strlen(sensorData.c_str()) + strlen(derived.c_str()) + 1) <= UDP_PAYLOAD_SIZE) sensorData = sensorData + derived;
+            else LOG_WARN("sendBatch() - no room for hi & dp");
+        }
+        sensorData = sensorData + "}";
+        PROF_END(PROF_SERIAL);
+
+        PROF_BEGIN(PROF_SEND);
+        int sent = sendUDP((char *)sensorData.c_str(), strlen(sensorData.c_str()));
+        PROF_END(PROF_SEND);
+        if(sent > 0)
+        {
+            // NOTE: fixes frozen sensor, issue #11
+            if(batchMask & 1) sensorlast = sensor;
+            for(ix = 0; ix < probeCount; ix++)
             {
-                // construct the JSON string with our data inside...
-                //
-                // example : {"dev_id":"ESP_290767","t":71.5,"h":37.40,"scale":"F"}
-                sensorData = "{\"dev_id\":\"" + conn.hostname + "\"";
-                // 'app_id' currently not used, removed from sensor data.
-                //sensorData = sensorData + ",\"app_id\":\"" + a_cfgdat->getAppName() + "\"";
-                // convenient for tracking data updates vs. data reports
-                sensorData = sensorData + ",\"seq\":" + String(sensor.seq);
-                sensorData = sensorData + ",\"t\":" + String(sensor.t) + ",\"h\":" + String(sensor.h);
-                sensorData = sensorData + "}";
-    
-                int sent = sendUDP((char *)sensorData.c_str(), strlen(sensorData.c_str()));
-                if(sent > 0)
-                {
-                    // NOTE: fixes frozen sensor, issue #11
-                    sensorlast = sensor;
-
-                    bRet = true;
-                    if(!checkDebugMute()) Serial.println("data - " + sensorData);
-                } else if(!checkDebugMute()) Serial.println("sendUDP() failed, sent = " + String(sent));
+                if(batchMask & (1 << (ix + 1))) probelast[ix] = probe[ix];
             }
-        } else sensor.nextup = scfg.error_interval + millis();
+            bRet = true;
+            LOG_DBG("data - %s", sensorData.c_str());
+        } else LOG_WARN("sendUDP() failed, sent = %d", sent);
     }
+    batchMask = 0;
     return bRet;
 }
 
 /*
-    Get the relative number of the pin we're supposed to use for
-    getting data from the sensor.
+    Read the first sensor and decide what's next. Returns true if 
+    a "STATS" summary was sent.
 */
-uint8_t getPin(sensorconfig &cfg)
+bool readPrimary()
 {
-uint8_t pin = 0;
+bool bRet = false;
+readresult updated;
+
+    updated = updateSensorData();
+
+    // update the sensor data, if an error occurred then 
+    // change the interval between retries... success?
+    if(updated == READ_RETRY)
+    {
+        sensor.nextup = RETRY_INTERVAL + appMillis();
+    }
+    else if(updated == READ_REJECTED)
+    {
+        // nothing to report, read again as soon as the sensor
+        // allows it. A spike is gone by then, a real change is 
+        // believed sooner (see FILTER_MAX_REJECTS).
+        sensor.nextup = RETRY_INTERVAL + appMillis();
+    }
+    else if((updated == READ_OK) && (reportMode() == REPORT_STATS))
+    {
+        sensor.nextup = statsSample() + appMillis();
+        bRet = sendSensorStats();
+    }
+    else if(updated == READ_OK) 
+    {
+        // success!
+        sensor.nextup = nextInterval() + appMillis();
 
-#ifdef ARDUINO_ESP8266_NODEMCU
-    if(!checkDebugMute()) Serial.println("cfg.pin = " + cfg.pin);
+        LOG_DBG("last - %d  %d", sensorlast.t10, sensorlast.h10);
+        LOG_DBG("live - %d  %d", sensor.t10, sensor.h10);
 
-    if(cfg.pin == "D6") pin = D6;
-    else if(cfg.pin == "D4") pin = D4;
+        // if we're supposed to report the values...
+        if(chkReport()) batchAdd(0);
+    } else sensor.nextup = scfg.error_interval + appMillis();
+    return bRet;
+}
+
+#ifdef __cplusplus
+}
 #endif
-#ifdef ARDUINO_ESP8266_ESP01
-    if(!checkDebugMute()) Serial.println("pin will be GPIO2");
-    pin = 2;
+
+/*
+    Start probe `ix` with its slot's driver. It can't be read more
+    often than the driver allows.
+*/
+template<class DRIVER>
+void beginProbe(DRIVER &_drv, uint8_t ix)
+{
+    _drv.begin(scfg.probes[ix].pin_id, scfg.probes[ix].type_id);
+    probe[ix].interval = (scfg.probes[ix].interval < DRIVER::minInterval() ? DRIVER::minInterval() : scfg.probes[ix].interval);
+}
+
+/*
+    Read a probe, the filter, adaptive sampling and "STATS" mode
+    are only used with the first sensor.
+*/
+template<class DRIVER>
+void readProbe(DRIVER &_drv, uint8_t ix)
+{
+sensorfault fault;
+int16_t t10 = 0;
+int16_t h10 = 0;
+
+    fault = readSensor(_drv, t10, h10);
+
+    if(fault != FAULT_NONE)
+    {
+        if(readFailed(probe[ix], probelast[ix], fault, ix + 1) == READ_RETRY) probe[ix].nextup = DRIVER::minInterval() + appMillis();
+        else probe[ix].nextup = scfg.error_interval + appMillis();
+    } else {
+        readGood(probe[ix], t10, h10, ix + 1);
+        probe[ix].nextup = probe[ix].interval + appMillis();
+        LOG_DBG("readProbe(%d) - %u   %d  %d", ix + 1, probe[ix].seq, t10, h10);
+        if(probeReport(ix)) batchAdd(ix + 1);
+    }
+}
+
+#ifdef __cplusplus
+extern "C" {
 #endif
-    return pin;
+
+/*
+    The probe slots' drivers are different types, these call the 
+    one for slot `ix`
+*/
+void probeBegin(uint8_t ix)
+{
+    if(ix == 0) beginProbe(probedrv1, ix);
+    else beginProbe(probedrv2, ix);
+}
+
+void probeStart(uint8_t ix)
+{
+    if(ix == 0) probedrv1.start();
+    else probedrv2.start();
+}
+
+bool probePoll(uint8_t ix)
+{
+    return (ix == 0 ? probedrv1.poll() : probedrv2.poll());
+}
+
+const DHTDiag &probeDiag(uint8_t ix)
+{
+    return (ix == 0 ? probedrv1.diag() : probedrv2.diag());
+}
+
+void probeClearDiag(uint8_t ix)
+{
+    if(ix == 0) probedrv1.clearDiag();
+    else probedrv2.clearDiag();
+}
+
+void probeRead(uint8_t ix)
+{
+    if(ix == 0) readProbe(probedrv1, ix);
+    else readProbe(probedrv2, ix);
 }
 
 /*
-    Get the sensor type from the config
+    Poll the sensor with a reading in progress, returns true when
+    the reading is finished.
 */
-uint8_t getType(sensorconfig &cfg)
+bool pollSensor()
 {
-uint8_t type = 0;
+bool bRet;
 
-    if(!checkDebugMute()) Serial.println("cfg.type = " + cfg.type);
+    PROF_BEGIN(PROF_READ);
+    bRet = (reading == 0 ? drv.poll() : probePoll(reading - 1));
+    PROF_END(PROF_READ);
+    return bRet;
+}
 
-    if(cfg.type == "DHT22") type = DHT22;
-    else if(cfg.type == "DHT11") type = DHT11;
+/*
+    Read the sensors that are due and send their data to the server.
+    Only one sensor is read at a time so that their reads don't hold
+    up the loop together, and one isn't started right after a packet
+    was sent. The readings that are due in the same tick are sent in 
+    one packet.
+*/
+bool sendSensorData()
+{
+bool bRet = false;
+uint8_t ix;
 
-    return type;
+    // Is a sensor up next for a reading?
+    if((reading < 0) && timeReached(appMillis(), lastTransmit + SENSOR_TX_GUARD))
+    {
+        if(timeReached(appMillis(), sensor.nextup)) reading = 0;
+        else
+        {
+            for(ix = 0; (ix < probeCount) && (reading < 0); ix++)
+            {
+                if((probe[ix].interval > 0) && timeReached(appMillis(), probe[ix].nextup)) reading = ix + 1;
+            }
+        }
+        if(reading == 0) drv.start();
+        else if(reading > 0) probeStart(reading - 1);
+    }
+    // the DHT is read here, other sensors may take a few passes
+    if((reading >= 0) && pollSensor())
+    {
+        if(reading == 0) bRet = readPrimary();
+        else probeRead(reading - 1);
+        reading = -1;
+    }
+    if((batchMask != 0) && !batchWait()) bRet = sendBatch() || bRet;
+    return bRet;
 }
 
+/*
+    Called while the WiFi connection is made and the server is found
+    (see setupWiFi() and queryServer()). It takes the first reading of 
+    the first sensor as soon as the warm-up is over, and the reading is 
+    sent on the first pass through the loop.
+*/
+void sampleSensor()
+{
+    // only until there's a good reading
+    if((sensor.seq > 0) || !timeReached(appMillis(), sensor.nextup)) return;
+
+    drv.start();
+    while(!drv.poll()) yield();
+    readPrimary();
+}
 
 /*
     Get the sensor read interval
@@ -275,27 +807,118 @@ unsigned long getSensorInterval()
     return scfg.interval;
 }
 
+/*
+    Returns true if sensor `num` is being read, 0 is the first
+    sensor and 1 and up are the probes.
+*/
+bool sensorInUse(uint8_t num)
+{
+    return ((num == 0) || ((num <= probeCount) && (probe[num - 1].interval > 0)));
+}
+
+/*
+    Get a copy of the current state of sensor `num`, used for 
+    reporting stats on request.
+*/
+void getSensorState(livesensor &_sensor, uint8_t num)
+{
+    _sensor = (num == 0 ? sensor : probe[num - 1]);
+}
+
+/*
+    Get a copy of sensor `num`'s read diagnostics, or clear them
+*/
+void getSensorDiag(DHTDiag &_diag, uint8_t num)
+{
+    _diag = (num == 0 ? drv.diag() : probeDiag(num - 1));
+}
+
+void clearSensorDiag(uint8_t num)
+{
+    if(num == 0) drv.clearDiag();
+    else probeClearDiag(num - 1);
+}
+
+/*
+    Run-time configuration - these are called when a command
+    is received from the server. The changes are not saved to
+    the configuration file.
+*/
+void setSensorInterval(unsigned long interval)
+{
+    scfg.interval = interval;
+    sensor.interval = (adaptEnabled() ? constrain(interval, scfg.interval_min, scfg.interval_max) : interval);
+    // the next reading will use the new interval
+    if(reportMode() == REPORT_STATS)
+    {
+        sensor.nextup = statsSample() + appMillis();
+        statsStart();
+    } else sensor.nextup = sensor.interval + appMillis();
+}
+
+void setSensorDelta(int delta_t, int delta_h)
+{
+    scfg.delta_t = delta_t;
+    scfg.delta_h = delta_h;
+}
+
+bool setSensorReport(String report)
+{
+    if(!SensorCfgData::parseReport(report, scfg.report_id)) return false;
+    scfg.report = report;
+    // the first summary is a full window from now
+    if(reportMode() == REPORT_STATS) statsStart();
+    return true;
+}
+
 /*
     Start the sensor - finish any necessary initialization and
     get the first data reading.
 */
 void startSensor()
 {
+uint8_t ix;
+uint8_t iy;
+
     if(sens_cfgdat != NULL)
     {
         // get a copy of the sensor's configuration data
         sens_cfgdat->getSensor(scfg);
+        filterStart(scfg);
+        sensor.interval = (adaptEnabled() ? constrain(scfg.interval, scfg.interval_min, scfg.interval_max) : scfg.interval);
 
-        // initialize the DHT...
+        // initialize the sensor, see sensor-driver.h
         // NOTE: the DHT class was originally authored by AdaFruit. I 
         // made a copy and have modified it a little. See the comments
         // in src/adafruit/DHT.*
-        dht.begin(getPin(scfg), getType(scfg));
+        drv.begin(scfg.pin_id, scfg.type_id);
+        LOG_INFO("startSensor() - pin = %d  type = %d", scfg.pin_id, scfg.type_id);
+
+        // the probes, each one needs its own pin
+        probeCount = scfg.probe_count;
+        for(ix = 0; ix < probeCount; ix++)
+        {
+            probe[ix] = livesensor();
+            probelast[ix] = livesensor();
+            for(iy = 0; (iy < ix) && (scfg.probes[iy].pin_id != scfg.probes[ix].pin_id); iy++);
+            if((scfg.probes[ix].type_id == 0) || (scfg.probes[ix].pin_id == scfg.pin_id) || (iy < ix))
+            {
+                LOG_ERR("startSensor() - sensor %d not used, pin = %d  type = %d", ix + 1, scfg.probes[ix].pin_id, scfg.probes[ix].type_id);
+                continue;
+            }
+            probeBegin(ix);
+            LOG_INFO("startSensor() - sensor %d pin = %d  type = %d", ix + 1, scfg.probes[ix].pin_id, scfg.probes[ix].type_id);
+        }
 
-        // "fake" the time, it will force an update
-        // and send... 30 seconds is long enough to
-        // let the sensor stabilize
-        sensor.nextup = 30000 + millis();
+        // "fake" the time, it will force an update and send once
+        // the sensor has settled. This is called before the WiFi 
+        // connection is made, see sampleSensor(). The sensor has
+        // been powered since boot, the warm-up is counted from then.
+        sensor.nextup = bootTime + scfg.warmup;
+        if(timeReached(appMillis(), sensor.nextup)) sensor.nextup = appMillis();
+        statsDue = sensor.nextup + scfg.interval;
+        // the probes follow, a little apart
+        for(ix = 0; ix < probeCount; ix++) probe[ix].nextup = sensor.nextup + ((ix + 1) * SENSOR_STAGGER);
     }
 }
 
@@ -7,22 +7,79 @@
 #pragma once
 
 #include "../adafruit/DHT.h"
+#include "SensorCfgData.h"
+#include "sensor-driver.h"
+
+// Fixed hardware profile - when defined the sensor type, scale and report
+// mode are compiled in (see sensor-profile.h) and the corresponding settings
+// in the sensor configuration file are ignored.
+//#define SENSOR_PROFILE
+#ifdef SENSOR_PROFILE
+#define SENSOR_PROFILE_TYPE     DHT22
+#define SENSOR_PROFILE_SCALE    SCALE_F
+#define SENSOR_PROFILE_REPORT   REPORT_CHG
+#endif
+
+// The sensor drivers, see sensor-driver.h. The first sensor and each
+// probe slot (see sensorconfig) has its own, so a probe can be another
+// kind of sensor. A build can choose the probes' drivers with 
+// PROBE1_DRIVER and PROBE2_DRIVER (see host/CMakeLists.txt).
+#if SENSOR_MAX != 3
+#error "each probe slot needs a driver type"
+#endif
+#ifndef PROBE1_DRIVER
+#define PROBE1_DRIVER DHTDriver<>
+#endif
+#ifndef PROBE2_DRIVER
+#define PROBE2_DRIVER DHTDriver<>
+#endif
+
+#ifdef SOAK_TEST
+typedef SoakDriver SensorDriver;
+typedef SoakDriver ProbeDriver1;
+typedef SoakDriver ProbeDriver2;
+#else
+#ifdef SENSOR_PROFILE
+typedef DHTDriver<SENSOR_PROFILE_TYPE> SensorDriver;
+#else
+typedef DHTDriver<> SensorDriver;
+#endif
+typedef PROBE1_DRIVER ProbeDriver1;
+typedef PROBE2_DRIVER ProbeDriver2;
+#endif
 
 // 
 class livesensor {
     public:
-        uint16_t seq = 0;
+        // readings taken, including the heartbeat readings
+        uint32_t seq = 0;
+        // reports sent (data and heartbeat), a gap means one was lost
+        uint32_t rseq = 0;
         float t = 0.0;
         float h = 0.0;
+        // t & h in tenths, used for comparisons
+        int16_t t10 = 0;
+        int16_t h10 = 0;
         unsigned long nextup = 0;
+        // the current interval between readings, it only differs
+        // from the configured one with adaptive sampling
+        unsigned long interval = 0;
+        // failed reads after the retries were used up, and the
+        // number of times that reached MAX_NAN
         int16_t nancount = 0;
         int16_t errcount = 0;
+        // the quick re-reads done since the last good reading
+        uint8_t retries = 0;
+        // failed reads since the last good reading, by sensorfault
+        uint16_t timeouts = 0;
+        uint16_t badsums = 0;
+        uint16_t ranges = 0;
 };
 
 // 
 class sensornow {
     public:
-        uint16_t seq = 0;
+        uint32_t seq = 0;
         float hnow   = 0.0;
         float tnow   = 0.0;
         float hlast  = 0.0;
@@ -33,11 +90,27 @@ class sensornow {
 extern "C" {
 #endif
 
+// a random number chosen when the first report is sent, it's in every
+// report so that a server can tell a reboot from a gap in the sequence
+// numbers
+extern uint32_t bootID;
+
 extern void startSensor();
+extern void sampleSensor();
 extern bool sendSensorData();
 extern unsigned long getSensorInterval();
 extern void readSensorNow(sensornow &);
 extern bool sendSensorNow(sensornow);
+// the sensor's number is 0 for the first sensor, 1 and up are the probes
+extern bool sensorInUse(uint8_t num);
+extern void getSensorState(livesensor &, uint8_t num = 0);
+extern void getSensorDiag(DHTDiag &, uint8_t num = 0);
+extern void clearSensorDiag(uint8_t num = 0);
+
+// run-time configuration, see esp8266-cmd.cpp
+extern void setSensorInterval(unsigned long);
+extern void setSensorDelta(int, int);
+extern bool setSensorReport(String);
 
 #ifdef __cplusplus
 }
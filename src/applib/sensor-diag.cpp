@@ -0,0 +1,92 @@
+/* ************************************************************************ */
+/*
+    sensor-diag.cpp - DHT read diagnostics, see sensor-diag.h
+
+    As with the heap telemetry the status message is assembled in a 
+    static buffer with snprintf(), see sendStatusFmt().
+*/
+#include "esp8266-ino.h"
+#include "sensor-dht.h"
+#include "sensor-diag.h"
+#include "esp8266-log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    The probes' messages begin with the sensor's number, the first
+    sensor's don't. Returns the length as snprintf() does.
+*/
+int fmtSensorNum(char *buf, int len, uint8_t num)
+{
+    if(num == 0) return 0;
+    return snprintf(buf, len, "\"sensor\":%u,", num);
+}
+
+/*
+    Format sensor `num`'s read counters as JSON members (without the
+    enclosing braces) into `buf`. "fail" is [start low, start high, bit
+    timeout, checksum] and "marg" is the number of bits with a ratio 
+    between 0.75 and 1.25. Returns the length, or a value >= len if the
+    buffer was too small.
+*/
+int fmtSensorDiag(char *buf, int len, uint8_t num)
+{
+DHTDiag tmp;
+int used;
+
+    getSensorDiag(tmp, num);
+    if((used = fmtSensorNum(buf, len, num)) >= len) return used;
+    return used + snprintf(&buf[used], len - used, "\"good\":%u,\"fail\":[%u,%u,%u,%u],\"us\":%u,\"marg\":%u",
+                           tmp.good, tmp.startlow, tmp.starthigh, tmp.bittimeout, tmp.checksum, tmp.lastus,
+                           tmp.ratio[DHT_RATIO_MARGIN] + tmp.ratio[DHT_RATIO_MARGIN + 1]);
+}
+
+/*
+    Format the bit ratio histogram, the number of bits in each
+    quarter from 0 to 1.75 and over
+*/
+int fmtSensorRatio(char *buf, int len, uint8_t num)
+{
+DHTDiag tmp;
+int used;
+
+    getSensorDiag(tmp, num);
+    if((used = fmtSensorNum(buf, len, num)) >= len) return used;
+    return used + snprintf(&buf[used], len - used, "\"ratio\":[%u,%u,%u,%u,%u,%u,%u,%u]",
+                           tmp.ratio[0], tmp.ratio[1], tmp.ratio[2], tmp.ratio[3],
+                           tmp.ratio[4], tmp.ratio[5], tmp.ratio[6], tmp.ratio[7]);
+}
+
+// the sensor that sendSensorDiag() is sending
+static uint8_t diagNum = 0;
+
+static int fmtDiagNum(char *buf, int len)
+{
+    return fmtSensorDiag(buf, len, diagNum);
+}
+
+/*
+    Multi-cast the read counters as a status message, one for each
+    sensor that's in use, sent with each heartbeat - 
+
+        {"dev_id":"ESP_49ECF6","status":"SENSOR_DIAG","good":1520,"fail":[0,0,1,3],"us":4810,"marg":2}
+        {"dev_id":"ESP_49ECF6","status":"SENSOR_DIAG","sensor":1,"good":1518,"fail":[0,0,0,1],"us":4790,"marg":0}
+
+    Returns false if any of them wasn't sent.
+*/
+bool sendSensorDiag()
+{
+bool bRet = true;
+
+    for(diagNum = 0; diagNum < SENSOR_MAX; diagNum++)
+    {
+        if(sensorInUse(diagNum)) bRet = sendStatusFmt("SENSOR_DIAG", fmtDiagNum) && bRet;
+    }
+    return bRet;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,26 @@
+/* ************************************************************************ */
+/*
+    sensor-diag.h - DHT read diagnostics, the reasons that reads failed,
+    the time taken by the last read and the high/low ratios of the bits 
+    (see DHTDiag in DHT.h).
+
+    A summary for each sensor is sent with each heartbeat and all of it is
+    available with the "H" command. A sensor that's failing usually times out, marginal
+    wiring (long wires, a weak pull-up) shows up as checksum failures and
+    bits with ratios close to 1.
+*/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// `num` is the sensor, 0 is the first one and 1 and up are the probes
+extern int fmtSensorNum(char *buf, int len, uint8_t num);
+extern int fmtSensorDiag(char *buf, int len, uint8_t num = 0);
+extern int fmtSensorRatio(char *buf, int len, uint8_t num = 0);
+extern bool sendSensorDiag();
+
+#ifdef __cplusplus
+}
+#endif
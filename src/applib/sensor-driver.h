@@ -0,0 +1,219 @@
+/* ************************************************************************ */
+/*
+    sensor-driver.h - the interface between the sensor code and a sensor's
+    library, and the drivers for the DHTxx and the soak test.
+
+    The sensor code (sensor-dht.cpp) doesn't call a sensor library, it
+    calls the driver classes chosen at compile time (SensorDriver and a
+    ProbeDriver for each probe slot, see sensor-dht.h). There are no virtual functions, each call is resolved
+    by the compiler and most are inlined. A driver class has -
+
+        void begin(uint8_t pin, uint8_t type)
+            Set up the sensor, `type` is from the sensor configuration.
+
+        void start()
+            Begin a reading. A sensor that converts in the background
+            (most I2C sensors) sends its command here and returns.
+
+        bool poll()
+            Returns true when the reading that start() began is finished,
+            or has failed. It's called on each pass through the loop until
+            then, so it must not wait and must give up on a sensor that
+            doesn't answer. It keeps returning true until the next start().
+
+        sensorfault result(int16_t &t, int16_t &h)
+            The finished reading in tenths of a degree C and tenths of a
+            percent, or why it failed (FAULT_TIMEOUT or FAULT_CHECKSUM).
+
+        const DHTDiag &diag() and void clearDiag()
+            The read diagnostics, see sensor-diag.h. A sensor without them
+            returns an empty DHTDiag.
+
+        static unsigned long minInterval()
+            The shortest time between readings in milliseconds.
+
+        static unsigned long readTime()
+            About how long a reading holds up the loop in milliseconds.
+
+        static int16_t tempMin(), tempMax() and humidMax()
+            The range of the sensor in tenths, a reading outside of it is
+            counted as FAULT_RANGE.
+*/
+#pragma once
+
+#include "../adafruit/DHT.h"
+#include "esp8266-clock.h"
+
+// why a sensor read failed
+enum sensorfault { FAULT_NONE = 0, FAULT_TIMEOUT, FAULT_CHECKSUM, FAULT_RANGE };
+
+/*
+    Start a reading and wait for it, for the callers that can't come
+    back on the next pass through the loop.
+*/
+template<class DRIVER>
+inline sensorfault driverRead(DRIVER &drv, int16_t &t, int16_t &h)
+{
+    drv.start();
+    while(!drv.poll()) yield();
+    return drv.result(t, h);
+}
+
+/*
+    DHT11, DHT21 and DHT22 - the whole reading is done in poll(), it
+    waits for the start signal (about 270 ms) and then receives the 40
+    bits with interrupts off. When TYPE isn't 0 the sensor type is fixed
+    and the type passed to begin() is ignored.
+
+    NOTE: The DHT class has been modified from its original.
+*/
+template<uint8_t TYPE = 0>
+class DHTDriver {
+    public:
+        void begin(uint8_t pin, uint8_t type)
+        {
+            _type = (TYPE != 0 ? TYPE : type);
+            _dht.begin(pin, _type);
+        }
+
+        inline void start()
+        {
+            _done = false;
+        }
+
+        inline bool poll()
+        {
+            if(!_done)
+            {
+                _good = _dht.readTenths(_t, _h);
+                _done = true;
+            }
+            return true;
+        }
+
+        // the reading is decoded by DHT::readTenths()
+        inline sensorfault result(int16_t &t, int16_t &h)
+        {
+            if(!_good) return (_dht.lastError() == DHT_ERR_CHECKSUM ? FAULT_CHECKSUM : FAULT_TIMEOUT);
+            t = _t;
+            h = _h;
+            return FAULT_NONE;
+        }
+
+        inline const DHTDiag &diag()
+        {
+            return _dht.diag();
+        }
+
+        inline void clearDiag()
+        {
+            _dht.clearDiag();
+        }
+
+        // DHT::read() returns the previous result if it's read sooner
+        static inline unsigned long minInterval()
+        {
+            return 2500;
+        }
+
+        static inline unsigned long readTime()
+        {
+            return 275;
+        }
+
+        // the limits of the DHT22
+        static inline int16_t tempMin()
+        {
+            return -400;
+        }
+
+        static inline int16_t tempMax()
+        {
+            return 800;
+        }
+
+        static inline int16_t humidMax()
+        {
+            return 1000;
+        }
+
+    private:
+        DHT _dht;
+        uint8_t _type = 0;
+        int16_t _t = 0;
+        int16_t _h = 0;
+        bool _good = false;
+        bool _done = true;
+};
+
+/*
+    The soak test (see esp8266-clock.h) and the host build - a slow 
+    random walk instead of a sensor, it changes enough to be reported
+    some of the time.
+*/
+class SoakDriver {
+    public:
+        void begin(uint8_t pin, uint8_t type)
+        {
+            _rnd += pin;
+        }
+
+        inline void start()
+        {
+            _rnd = (_rnd * 1103515245) + 12345;
+            _t10 = constrain(_t10 + (int)((_rnd >> 16) % 5) - 2, 150, 270);
+            _h10 = constrain(_h10 + (int)((_rnd >> 24) % 5) - 2, 200, 600);
+        }
+
+        inline bool poll()
+        {
+            return true;
+        }
+
+        inline sensorfault result(int16_t &t, int16_t &h)
+        {
+            t = _t10;
+            h = _h10;
+            return FAULT_NONE;
+        }
+
+        inline const DHTDiag &diag()
+        {
+            return _diag;
+        }
+
+        inline void clearDiag()
+        {
+        }
+
+        static inline unsigned long minInterval()
+        {
+            return 2500;
+        }
+
+        static inline unsigned long readTime()
+        {
+            return 0;
+        }
+
+        static inline int16_t tempMin()
+        {
+            return -400;
+        }
+
+        static inline int16_t tempMax()
+        {
+            return 800;
+        }
+
+        static inline int16_t humidMax()
+        {
+            return 1000;
+        }
+
+    private:
+        uint32_t _rnd = 1;
+        int16_t _t10 = 210;
+        int16_t _h10 = 400;
+        DHTDiag _diag;
+};
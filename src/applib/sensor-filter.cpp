@@ -0,0 +1,154 @@
+/* ************************************************************************ */
+/*
+    sensor-filter.cpp - a filter stage for the sensor readings, see 
+    sensor-filter.h
+*/
+#include "sensor-filter.h"
+#include "esp8266-clock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the EMA is kept in tenths x FILTER_EMA_SCALE
+#define FILTER_EMA_SCALE 256
+
+// the filter's settings, copied from the sensor configuration
+static uint8_t medianLen = 0;
+static int maxRateT = 0;
+static int maxRateH = 0;
+static uint8_t emaShift = 0;
+
+// the last accepted readings, a ring of medianLen
+static int16_t tring[FILTER_MEDIAN_MAX];
+static int16_t hring[FILTER_MEDIAN_MAX];
+static uint8_t ringCount = 0;
+static uint8_t ringNext = 0;
+
+// the last accepted reading, for the rate check
+static int16_t lastT = 0;
+static int16_t lastH = 0;
+static unsigned long lastTime = 0;
+static uint8_t rejectRun = 0;
+
+static int32_t emaT = 0;
+static int32_t emaH = 0;
+
+static filterstats fstats;
+
+/*
+    Forget the previous readings
+*/
+static void filterRestart()
+{
+    ringCount = 0;
+    ringNext = 0;
+    rejectRun = 0;
+}
+
+void filterStart(const sensorconfig &cfg)
+{
+    medianLen = constrain(cfg.median, 0, FILTER_MEDIAN_MAX);
+    maxRateT = cfg.max_rate_t;
+    maxRateH = cfg.max_rate_h;
+    emaShift = constrain(cfg.ema, 0, 8);
+    filterRestart();
+}
+
+/*
+    Returns true if `x` changed faster than `rate` tenths per minute
+    since `last`, `elapsed` milliseconds ago.
+*/
+static bool tooFast(int16_t x, int16_t last, int rate, unsigned long elapsed)
+{
+int diff = abs(x - last);
+
+    if((rate <= 0) || (diff <= FILTER_RATE_SLACK)) return false;
+    return ((unsigned long)diff * 60000UL) > ((unsigned long)rate * elapsed);
+}
+
+/*
+    The median of the first `count` values, they're copied and sorted
+    (insertion sort, `count` is small)
+*/
+static int16_t median(const int16_t *vals, uint8_t count)
+{
+int16_t sorted[FILTER_MEDIAN_MAX];
+
+    for(uint8_t ix = 0; ix < count; ix++)
+    {
+        int16_t v = vals[ix];
+        uint8_t iy = ix;
+        while((iy > 0) && (sorted[iy - 1] > v))
+        {
+            sorted[iy] = sorted[iy - 1];
+            iy -= 1;
+        }
+        sorted[iy] = v;
+    }
+    return sorted[count / 2];
+}
+
+static int16_t emaUpdate(int32_t &ema, int16_t x, bool first)
+{
+    if(first) ema = (int32_t)x * FILTER_EMA_SCALE;
+    else ema += (((int32_t)x * FILTER_EMA_SCALE) - ema) / (1 << emaShift);
+    return (ema >= 0 ? ema + (FILTER_EMA_SCALE / 2) : ema - (FILTER_EMA_SCALE / 2)) / FILTER_EMA_SCALE;
+}
+
+/*
+    Filter a reading (tenths), `now` is the time it was read. Returns
+    false if the reading was rejected, otherwise t10 and h10 are 
+    replaced with the filtered values.
+*/
+bool filterReading(int16_t &t10, int16_t &h10, unsigned long now)
+{
+bool first = (ringCount == 0);
+
+    if(!first && (tooFast(t10, lastT, maxRateT, timeSince(now, lastTime)) || tooFast(h10, lastH, maxRateH, timeSince(now, lastTime))))
+    {
+        rejectRun += 1;
+        if(rejectRun < FILTER_MAX_REJECTS)
+        {
+            fstats.rejected += 1;
+            return false;
+        }
+        // it has stayed there, believe it
+        fstats.resets += 1;
+        filterRestart();
+        first = true;
+    }
+    rejectRun = 0;
+    lastT = t10;
+    lastH = h10;
+    lastTime = now;
+    fstats.accepted += 1;
+
+    // keep the readings even when the median isn't used, 
+    // ringCount marks the first reading
+    tring[ringNext] = t10;
+    hring[ringNext] = h10;
+    if(medianLen > 1)
+    {
+        ringNext = (ringNext + 1) % medianLen;
+        if(ringCount < medianLen) ringCount += 1;
+        t10 = median(tring, ringCount);
+        h10 = median(hring, ringCount);
+    } else ringCount = 1;
+
+    if(emaShift > 0)
+    {
+        t10 = emaUpdate(emaT, t10, first);
+        h10 = emaUpdate(emaH, h10, first);
+    }
+    return true;
+}
+
+void getFilterStats(filterstats &out)
+{
+    out = fstats;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,54 @@
+/* ************************************************************************ */
+/*
+    sensor-filter.h - a filter stage for the sensor readings, between
+    reading the sensor and deciding if the reading is reported.
+
+    A DHT22 will now and then return a reading that passes the checksum
+    but is garbage, a sudden 20 degree spike for example. Each reading
+    passes through three optional steps, all in integer math with a fixed
+    amount of memory - 
+
+        rate    - a reading that changed faster than max_rate_t or 
+                  max_rate_h (tenths per minute) since the last accepted
+                  reading is rejected. Changes of FILTER_RATE_SLACK or
+                  less are always accepted. After FILTER_MAX_REJECTS 
+                  rejections in a row the reading is accepted and the
+                  filter starts over, the change was real.
+        median  - the median of the last `median` accepted readings
+        ema     - an exponential moving average of the median, the new 
+                  value's weight is 1 / 2^ema
+
+    The settings are in the sensor configuration (see sensorconfig), 0
+    turns a step off.
+*/
+#pragma once
+
+#include "SensorCfgData.h"
+
+// the largest "median" setting
+#define FILTER_MEDIAN_MAX   7
+// changes up to this many tenths pass the rate check
+#define FILTER_RATE_SLACK   5
+// accept the reading after this many rejections in a row
+#define FILTER_MAX_REJECTS  3
+
+// the filter's counters, see the "F" command
+class filterstats {
+    public:
+        uint32_t accepted = 0;
+        uint32_t rejected = 0;
+        // the number of times the filter started over
+        uint32_t resets = 0;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void filterStart(const sensorconfig &);
+extern bool filterReading(int16_t &t10, int16_t &h10, unsigned long now);
+extern void getFilterStats(filterstats &);
+
+#ifdef __cplusplus
+}
+#endif
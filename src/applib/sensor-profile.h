@@ -0,0 +1,37 @@
+/* ************************************************************************ */
+/*
+    sensor-profile.h - compile-time sensor profile, for builds where the
+    sensor type, temperature scale and report mode are fixed.
+
+    When SENSOR_PROFILE is defined (see sensor-dht.h) the sensor code will
+    use SensorProfile<> to choose the temperature scale and to decide if a
+    reading should be reported, and the sensor type is fixed in the driver
+    (see sensor-driver.h). The choices are made by the compiler and what 
+    remains is straight-line integer code. The "type", "scale" and 
+    "report" settings in the sensor configuration file are ignored.
+*/
+#pragma once
+
+#include "SensorCfgData.h"
+
+template<scaletype SCALE, reporttype REPORT>
+class SensorProfile {
+    public:
+        static inline reporttype mode()
+        {
+            return REPORT;
+        }
+
+        static inline scaletype scale()
+        {
+            return SCALE;
+        }
+
+        // returns true if the reading should be reported, the 
+        // deltas are in tenths. Not used for REPORT_STATS.
+        static inline bool report(int16_t t, int16_t h, int16_t tlast, int16_t hlast, int delta_t, int delta_h)
+        {
+            if(REPORT == REPORT_ALL) return true;
+            return (abs(t - tlast) > delta_t) || (abs(h - hlast) > delta_h);
+        }
+};
@@ -0,0 +1,77 @@
+/* ************************************************************************ */
+/*
+    sensor-stats.cpp - windowed statistics for the "STATS" report mode,
+    see sensor-stats.h
+*/
+#include "sensor-stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void statsReset(winstat &w)
+{
+    w = winstat();
+}
+
+/*
+    Add a reading (tenths) to the window
+*/
+void statsAdd(winstat &w, int16_t x)
+{
+int32_t xs = (int32_t)x * STATS_SCALE;
+int32_t delta;
+
+    if(w.n == 0) w.min = w.max = x;
+    else
+    {
+        if(x < w.min) w.min = x;
+        if(x > w.max) w.max = x;
+    }
+    w.n += 1;
+
+    delta = xs - w.mean;
+    w.mean += delta / (int32_t)w.n;
+    w.m2 += ((int64_t)delta * (xs - w.mean)) / STATS_SCALE;
+}
+
+int16_t statsMean(const winstat &w)
+{
+    if(w.mean >= 0) return (w.mean + (STATS_SCALE / 2)) / STATS_SCALE;
+    return (w.mean - (STATS_SCALE / 2)) / STATS_SCALE;
+}
+
+/*
+    Integer square root, the largest r where r * r <= v
+*/
+uint32_t isqrt64(uint64_t v)
+{
+uint64_t r = 0;
+uint64_t bit = 1ULL << 62;
+
+    while(bit > v) bit >>= 2;
+    while(bit != 0)
+    {
+        if(v >= r + bit)
+        {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else r >>= 1;
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+uint16_t statsStdDev(const winstat &w)
+{
+    if((w.n < 2) || (w.m2 <= 0)) return 0;
+
+    // the variance is tenths squared x STATS_SCALE, scaling it by another
+    // STATS_SCALE x 100 makes the root hundredths x STATS_SCALE
+    uint64_t var = ((uint64_t)w.m2 * STATS_SCALE * 100) / (w.n - 1);
+    return (isqrt64(var) + (STATS_SCALE / 2)) / STATS_SCALE;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,48 @@
+/* ************************************************************************ */
+/*
+    sensor-stats.h - windowed statistics for the "STATS" report mode.
+
+    The readings taken during a window are summarized as the count, the
+    min and max, the mean and the standard deviation. The mean and the
+    sum of squared differences are kept with Welford's method in fixed
+    point, the readings are in tenths and the mean is in tenths x
+    STATS_SCALE. There is no floating point until the summary is sent.
+*/
+#pragma once
+
+#if ARDUINO >= 100
+ #include "Arduino.h"
+#else
+ #include "WProgram.h"
+#endif
+
+// the fixed point scale of the mean
+#define STATS_SCALE 256
+
+// the summary of one value (temperature or humidity) during a window
+class winstat {
+    public:
+        uint16_t n = 0;
+        int16_t min = 0;
+        int16_t max = 0;
+        // tenths x STATS_SCALE
+        int32_t mean = 0;
+        // the sum of squared differences from the mean, 
+        // tenths squared x STATS_SCALE
+        int64_t m2 = 0;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void statsReset(winstat &);
+extern void statsAdd(winstat &, int16_t);
+// the mean in tenths, rounded
+extern int16_t statsMean(const winstat &);
+// the sample standard deviation in hundredths, rounded
+extern uint16_t statsStdDev(const winstat &);
+
+#ifdef __cplusplus
+}
+#endif
@@ -18,6 +18,10 @@ extern "C" {
 #define UDP_PAYLOAD_SIZE_READ (UDP_PAYLOAD_SIZE + 1)
 #define UDP_PAYLOAD_SIZE_WRITE (UDP_PAYLOAD_SIZE + 1)
 
+// The local port used for receiving the reply to REQ_IP and
+// for receiving commands from the server (see esp8266-cmd.h)
+#define UDP_CMD_PORT 43210
+
 #ifdef __cplusplus
 }
 #endif